@@ -14,7 +14,8 @@
 #include "stm32f1xx.h"
 
 /**
- * @brief Configure GPIO pins used for CAN (e.g., PA11 = RX, PA12 = TX).
+ * @brief Configure GPIO pins used for CAN (PA11 = RX, PA12 = TX; PB8 = RX, PB9 = TX
+ *        when UART flow control needs PA11 / PA12).
  */
 void CAN_GPIO_Init(void);
 
@@ -23,6 +24,48 @@ void CAN_GPIO_Init(void);
  */
 void CAN_Config(void);
 
+/**
+ * @brief Change the CAN bit rate. Timing is derived from the APB1 clock.
+ *
+ * @param bitrate  Bit rate in bit/s (e.g. 125000, 250000, 500000, 1000000)
+ * @return         1 on success, 0 if the rate cannot be generated exactly
+ */
+uint8_t CAN_SetBitrate(uint32_t bitrate);
+
+/**
+ * @brief Enter or leave silent (listen-only) mode. A silent node receives but
+ *        drives nothing on the bus: no ACK, no error frames, no transmissions.
+ *        Frames still waiting in a mailbox are aborted on entry.
+ *
+ * @param silent  1 = silent, 0 = normal
+ */
+void CAN_SetSilent(uint8_t silent);
+
+/**
+ * @brief Configure the acceptance filter (filter 0, 32-bit mask mode).
+ *
+ * A mask of 0 accepts every frame.
+ *
+ * @param id           Identifier to compare against
+ * @param mask         Bits of the identifier that must match
+ * @param is_extended  1 = match 29-bit IDs, 0 = match 11-bit IDs
+ */
+void CAN_SetFilter(uint32_t id, uint32_t mask, uint8_t is_extended);
+
+/**
+ * @brief Get the configured bit rate in bit/s.
+ */
+uint32_t CAN_GetBitrate(void);
+
+/**
+ * @brief Get the configured acceptance filter.
+ *
+ * @param id           Output: filter identifier
+ * @param mask         Output: filter mask
+ * @param is_extended  Output: 1 = extended IDs
+ */
+void CAN_GetFilter(uint32_t *id, uint32_t *mask, uint8_t *is_extended);
+
 /**
  * @brief Send a standard (11-bit ID) CAN frame.
  *
@@ -52,12 +95,13 @@ void CAN_Send_EXT(uint32_t ext_id, uint8_t *data, uint8_t len);
 uint8_t CAN_Receive(uint8_t *data_out, uint32_t *id_out, uint8_t *is_extended);
 
 /**
- * @brief Send raw byte array over UART1 (used for debugging or PC communication).
+ * @brief Queue a raw byte array on UART1 (used for debugging or PC communication).
  *
  * @param data    Pointer to data array
  * @param length  Number of bytes to send
+ * @return        length if queued, 0 if the transmit ring was full
  */
-void UART1_SendRawBytes(uint8_t *data, uint16_t length);
+uint16_t UART1_SendRawBytes(uint8_t *data, uint16_t length);
 
 /**
  * @brief Interrupt handler for CAN RX FIFO 0 (called when a message is received).
@@ -1,6 +1,10 @@
 /*
  * can_buffer.h
- * @brief   Shared buffer and flags for CAN receive interrupt handling.
+ * @brief   Queue of received CAN frames between the CAN1 RX0 interrupt and the
+ *          main loop, which forwards them as fast as the UART takes them. When
+ *          the bus delivers more than that the queue fills up, and the overflow
+ *          policy decides which frame is lost. Every loss is counted, per ID
+ *          for the first CAN_BUFFER_LOSS_IDS IDs that lose a frame.
  *  Created on: Jun 7, 2025
  *      Author: nguye
  */
@@ -9,28 +13,98 @@
 #define SRC_CAN_BUFFER_H_
 #include <stdint.h>
 
+#ifndef CAN_BUFFER_DEPTH
+#define CAN_BUFFER_DEPTH     32         ///< Frames the queue holds (2–255), 20 bytes each
+#endif
+#ifndef CAN_BUFFER_LOSS_IDS
+#define CAN_BUFFER_LOSS_IDS  32         ///< IDs with a loss counter of their own (1–255), 9 bytes each
+#endif
+
+// Overflow policies: what happens to a frame that arrives while the queue is full
+#define CAN_BUF_DROP_NEWEST  0          ///< The arriving frame is lost
+#define CAN_BUF_DROP_OLDEST  1          ///< The oldest queued frame is lost
+#define CAN_BUF_LATEST       2          ///< It replaces the queued frame of its ID, else the oldest is lost
+
+#define CAN_BUF_EXT          0x80000000u ///< Added to a loss entry ID: 29-bit ID
+#define CAN_BUF_OTHER_IDS    0xFFFFFFFFu ///< Loss entry of the IDs without a counter of their own
+
+/**
+ * @brief A received frame.
+ */
+typedef struct {
+    uint32_t id;
+    uint32_t time;                      ///< Reception time (Timebase_Now), µs
+    uint8_t data[8];
+    uint8_t len;                        ///< Data length code (9–15 carry 8 bytes)
+    uint8_t is_ext;                     ///< 0 = standard, 1 = extended
+} CanFrame;
+
+/**
+ * @brief Loss counter of one ID.
+ */
+typedef struct {
+    uint32_t id;                        ///< ID + CAN_BUF_EXT, or CAN_BUF_OTHER_IDS
+    uint32_t lost;                      ///< Frames lost since the counters were cleared
+} CanLoss;
+
+/**
+ * @brief Totals since the counters were cleared.
+ */
+typedef struct {
+    uint32_t received;                  ///< Frames taken from the controller
+    uint32_t lost;                      ///< Frames lost to a full queue
+    uint32_t overrun;                   ///< Controller FIFO overruns (at least one frame each, ID unknown)
+    uint8_t peak;                       ///< Most frames queued at once since the last call
+    uint8_t policy;                     ///< CAN_BUF_ overflow policy
+} CanBufferStats;
+
+/**
+ * @brief Queue a received frame, applying the overflow policy if the queue is
+ *        full. Called from the CAN1 RX0 interrupt only; the time it takes is
+ *        bounded by CAN_BUFFER_DEPTH + CAN_BUFFER_LOSS_IDS.
+ */
+void CAN_Buffer_Push(const CanFrame *f);
+
+/**
+ * @brief Count an overrun of the controller receive FIFO. Interrupt only.
+ */
+void CAN_Buffer_Overrun(void);
+
 /**
- * @brief Flag set to 1 when a new CAN frame is received.
+ * @brief Take the oldest queued frame. Main loop only.
+ *
+ * @param out  Frame
+ * @return     1 if a frame was taken, 0 if the queue is empty
  */
-extern volatile uint8_t can_rx_flag;
+uint8_t CAN_Buffer_Pop(CanFrame *out);
 
 /**
- * @brief Buffer for received CAN data (max 8 bytes).
+ * @brief Select the overflow policy and clear every counter.
+ *
+ * @param policy  CAN_BUF_DROP_NEWEST, CAN_BUF_DROP_OLDEST or CAN_BUF_LATEST
+ * @return        1 if accepted, 0 for an unknown policy
  */
-extern uint8_t rx_data[8];
+uint8_t CAN_Buffer_SetPolicy(uint8_t policy);
 
 /**
- * @brief ID of the received CAN message.
+ * @brief Read the totals and restart the peak fill level.
  */
-extern uint32_t rx_id;
+void CAN_Buffer_Stats(CanBufferStats *out);
 
 /**
- * @brief Flag indicating if the received ID is extended (1) or standard (0).
+ * @brief Read the loss counters that changed since they were last read here.
+ *        Each call goes on where the previous one stopped, so every ID gets its
+ *        turn even when some lose frames all the time.
+ *
+ * @param out  Entries, cumulative counts
+ * @param max  Entries that fit at out; the others stay marked for a later call
+ * @return     Number of entries written
  */
-extern uint8_t is_ext;
+uint8_t CAN_Buffer_Losses(CanLoss *out, uint8_t max);
 
 /**
- * @brief Length of the received CAN data in bytes.
+ * @brief Frames lost to a full queue or a controller overrun since the counters
+ *        were cleared. Main loop only.
  */
-extern uint8_t rx_len;
+uint32_t CAN_Buffer_Lost(void);
 #endif /* SRC_CAN_BUFFER_H_ */
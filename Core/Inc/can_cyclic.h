@@ -11,6 +11,82 @@
 
 #include <stdint.h>
 
+/*
+ * Table sizes, override with -D on the compiler command line.
+ * RAM use: 26 bytes per message slot, 20 per extension record (counter, checksum,
+ * burst or min/max settings of one message), 24 per generator and 16 per group
+ * entry. A static assert in can_cyclic.c fails the build if the total exceeds
+ * CAN_CYCLIC_RAM_BUDGET; the defaults take 13.8 KB.
+ */
+#ifndef CAN_CYCLIC_CAPACITY
+#define CAN_CYCLIC_CAPACITY      500        ///< Message slots (active + staged bulk table); a save holds CONFIG_SAVE_MAX_MESSAGES
+#endif
+#ifndef CAN_CYCLIC_EXT_CAPACITY
+#define CAN_CYCLIC_EXT_CAPACITY  32         ///< Messages that can have a counter, checksum or non-periodic mode
+#endif
+#ifndef CAN_CYCLIC_GEN_CAPACITY
+#define CAN_CYCLIC_GEN_CAPACITY  8          ///< Signal generators shared by all messages
+#endif
+#ifndef CAN_CYCLIC_GROUP_CAPACITY
+#define CAN_CYCLIC_GROUP_CAPACITY 16        ///< Messages one group update can change together
+#endif
+#ifndef CAN_CYCLIC_RAM_BUDGET
+#define CAN_CYCLIC_RAM_BUDGET    (14 * 1024)    ///< Upper limit for the whole cyclic table in bytes
+#endif
+
+/**
+ * @brief Checksum types that can be inserted into a cyclic payload at send time.
+ */
+typedef enum {
+    CYCLIC_CRC_NONE   = 0,  ///< No checksum
+    CYCLIC_CRC_J1850  = 1,  ///< CRC8 SAE-J1850 over the payload (init 0xFF, XOR 0xFF)
+    CYCLIC_CRC_E2E_P1 = 2,  ///< AUTOSAR E2E Profile 1 style: CRC8 over Data ID + payload
+    CYCLIC_CRC_E2E_P2 = 3   ///< AUTOSAR E2E Profile 2 style: CRC8H2F over payload + Data ID byte
+} CyclicCrcType;
+
+/**
+ * @brief Transmission modes executed by the scheduler.
+ */
+typedef enum {
+    CYCLIC_MODE_PERIODIC         = 0,  ///< Send every interval, forever (default)
+    CYCLIC_MODE_BURST            = 1,  ///< Send N times at the interval, then free the slot
+    CYCLIC_MODE_ON_CHANGE        = 2,  ///< Send only when an update changes the payload
+    CYCLIC_MODE_ON_CHANGE_MINMAX = 3   ///< Send on change, no faster than min, at least every interval
+} CyclicMode;
+
+/**
+ * @brief Complete configuration of one cyclic message, used to save and restore the schedule.
+ */
+typedef struct {
+    uint32_t id;            ///< CAN identifier
+    uint32_t interval_us;   ///< Transmission interval in microseconds
+    uint16_t shots;         ///< Burst length (CYCLIC_MODE_BURST)
+    uint16_t min_ms;        ///< Minimum repetition time (CYCLIC_MODE_ON_CHANGE_MINMAX)
+    uint16_t data_id;       ///< E2E Data ID
+    uint8_t model;          ///< 0 = Standard ID, 1 = Extended ID
+    uint8_t len;            ///< Payload length
+    uint8_t mode;           ///< CyclicMode
+    uint8_t ctr_start;      ///< Rolling counter start bit
+    uint8_t ctr_len;        ///< Rolling counter width (0 = none)
+    uint8_t ctr_max;        ///< Rolling counter wrap value
+    uint8_t crc_type;       ///< CyclicCrcType
+    uint8_t crc_byte;       ///< Checksum byte position
+    uint8_t data[8];        ///< Payload
+} CyclicEntry;
+
+/**
+ * @brief Configuration of one signal generator, used to save and restore the schedule.
+ */
+typedef struct {
+    uint32_t id;            ///< CAN identifier of the message it drives
+    uint16_t period_ms;     ///< Waveform period
+    uint16_t min;           ///< Raw value at the bottom of the waveform
+    uint16_t max;           ///< Raw value at the top of the waveform
+    uint8_t wave;           ///< SigGenWave
+    uint8_t start_bit;      ///< Start bit of the signal
+    uint8_t bit_len;        ///< Signal width in bits
+} CyclicGenEntry;
+
 /**
  * @brief Add a new cyclic CAN message or update an existing one.
  *
@@ -22,16 +98,251 @@
  * @param data        Pointer to data buffer (up to 8 bytes)
  * @param len         Number of data bytes (0–8)
  * @param cyclic_ms   Transmission interval in milliseconds
+ * @return            1 on success, 0 if the table is full
+ */
+uint8_t CAN_Cyclic_AddOrUpdate(uint8_t model, uint32_t id, uint8_t *data, uint8_t len, uint16_t cyclic_ms);
+
+/**
+ * @brief Same as CAN_Cyclic_AddOrUpdate with the interval in microseconds.
+ *
+ * Intervals below 50 us are raised to 50 us.
+ *
+ * @param model        0 for Standard ID, 1 for Extended ID
+ * @param id           CAN identifier (11-bit or 29-bit depending on model)
+ * @param data         Pointer to data buffer (up to 8 bytes)
+ * @param len          Number of data bytes (0–8)
+ * @param interval_us  Transmission interval in microseconds (0 = send once)
+ * @return             1 on success, 0 if the table is full
+ */
+uint8_t CAN_Cyclic_AddOrUpdateUs(uint8_t model, uint32_t id, uint8_t *data, uint8_t len, uint32_t interval_us);
+
+/**
+ * @brief Remove a cyclic message without sending anything.
+ *
+ * @param id  CAN identifier
+ * @return    1 on success, 0 if the ID is unknown
+ */
+uint8_t CAN_Cyclic_Delete(uint32_t id);
+
+/**
+ * @brief Remove all cyclic messages (a staged bulk table is kept).
+ */
+void CAN_Cyclic_Clear(void);
+
+/**
+ * @brief Number of messages in the active table.
+ */
+uint16_t CAN_Cyclic_Count(void);
+
+/**
+ * @brief Stop all cyclic transmissions. The table can still be changed; updates
+ *        that would send right away are held until the resume.
  */
-void CAN_Cyclic_AddOrUpdate(uint8_t model, uint32_t id, uint8_t *data, uint8_t len, uint16_t cyclic_ms);
+void CAN_Cyclic_Pause(void);
 
 /**
- * @brief Check and transmit all pending cyclic CAN messages.
+ * @brief Continue after CAN_Cyclic_Pause. Every message keeps its phase, shifted
+ *        by the time the scheduler was paused.
+ */
+void CAN_Cyclic_Resume(void);
+
+/**
+ * @brief 1 while the scheduler is paused.
+ */
+uint8_t CAN_Cyclic_Paused(void);
+
+/**
+ * @brief Transmit all due cyclic CAN messages and set the timer alarm for the next one.
  *
- * This function should be called periodically (e.g., every 10 ms)
- * to ensure that all registered cyclic messages are sent at the correct time.
+ * Called from TIM2_IRQHandler (see timebase.h) whenever the earliest deadline expires.
+ * Periodic messages keep their phase, so interrupt latency does not accumulate.
  */
 void CAN_Cyclic_Update(void);
 
+/**
+ * @brief Block the scheduler interrupt while the main loop changes the table.
+ */
+void CAN_Cyclic_Lock(void);
+
+/**
+ * @brief Release CAN_Cyclic_Lock and reschedule with the new table.
+ */
+void CAN_Cyclic_Unlock(void);
+
+/**
+ * @brief Read the configuration of the message in a table slot.
+ *
+ * @param slot   Slot index, iterate from 0 until the function returns 0xFF
+ * @param out    Output configuration (valid when 1 is returned)
+ * @return       1 if the slot holds an active message, 0 if it is free, 0xFF past the end
+ */
+uint8_t CAN_Cyclic_GetEntry(uint16_t slot, CyclicEntry *out);
+
+/**
+ * @brief Read the configuration of a signal generator.
+ *
+ * @param index  Generator index, iterate from 0 until the function returns 0xFF
+ * @param out    Output configuration (valid when 1 is returned)
+ * @return       1 if the generator is in use, 0 if it is free, 0xFF past the end
+ */
+uint8_t CAN_Cyclic_GetGenerator(uint16_t index, CyclicGenEntry *out);
+
+/**
+ * @brief Add a message from a saved configuration without transmitting it.
+ *
+ * The first transmission happens one interval later. An existing entry with the same ID
+ * is replaced.
+ *
+ * @param e  Saved configuration
+ * @return   1 on success, 0 if the entry is invalid or the table is full
+ */
+uint8_t CAN_Cyclic_Restore(const CyclicEntry *e);
+
+/**
+ * @brief Start building a new cyclic table next to the active one.
+ *
+ * Any entries staged by an earlier, uncommitted bulk load are discarded.
+ */
+void CAN_Cyclic_BulkBegin(void);
+
+/**
+ * @brief Stage one entry of the new table. Nothing is transmitted.
+ *
+ * Staged entries use free slots, so the active and the staged table together must fit
+ * into the slot pool.
+ *
+ * @param model       0 for Standard ID, 1 for Extended ID
+ * @param id          CAN identifier
+ * @param data        Pointer to data buffer (up to 8 bytes)
+ * @param len         Number of data bytes (0–8)
+ * @param interval_us Transmission interval in microseconds (must be > 0)
+ * @return            1 on success, 0 if the entry is invalid or no slot is free
+ */
+uint8_t CAN_Cyclic_BulkAdd(uint8_t model, uint32_t id, uint8_t *data, uint8_t len, uint32_t interval_us);
+
+/**
+ * @brief Replace the active table with the staged one at the next CAN_Cyclic_Update pass.
+ *
+ * Entries of the new table are first sent one interval after the swap.
+ */
+void CAN_Cyclic_BulkCommit(void);
+
+/**
+ * @brief Overwrite a byte range of an existing cyclic message's payload.
+ *
+ * The schedule is not touched: periodic messages carry the new bytes in their next
+ * regular frame, on-change messages react as to CAN_Cyclic_AddOrUpdate.
+ *
+ * @param id     CAN identifier of an already registered message
+ * @param pos    First byte to overwrite
+ * @param data   New bytes
+ * @param count  Number of bytes (pos + count must not exceed the payload length)
+ * @return       1 on success, 0 if the ID is unknown or the range is invalid
+ */
+uint8_t CAN_Cyclic_PatchBytes(uint32_t id, uint8_t pos, const uint8_t *data, uint8_t count);
+
+/**
+ * @brief Overwrite a bit field of an existing cyclic message's payload (Intel order).
+ *
+ * Other bits of the payload are kept. Scheduling as for CAN_Cyclic_PatchBytes.
+ *
+ * @param id         CAN identifier of an already registered message
+ * @param start_bit  Start bit (byte = bit / 8)
+ * @param bit_len    Field width in bits (1–32, must fit into the payload)
+ * @param value      New field value
+ * @return           1 on success, 0 if the ID is unknown or the field is invalid
+ */
+uint8_t CAN_Cyclic_PatchBits(uint32_t id, uint8_t start_bit, uint8_t bit_len, uint32_t value);
+
+/**
+ * @brief Start a group of payload updates, discarding an uncommitted group.
+ */
+void CAN_Cyclic_GroupBegin(void);
+
+/**
+ * @brief Stage a new payload for an existing cyclic message. Nothing changes yet.
+ *
+ * @param id     CAN identifier of an already registered message
+ * @param data   New payload
+ * @param len    Number of data bytes (0–8)
+ * @return       1 on success, 0 if the ID is unknown, the length is invalid or
+ *               CAN_CYCLIC_GROUP_CAPACITY messages are already staged
+ */
+uint8_t CAN_Cyclic_GroupStage(uint32_t id, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Apply all staged payloads in the same scheduler pass.
+ *
+ * No frame is sent between the first and the last payload change, so a receiver
+ * never sees a mix of old and new values within the group. The schedule phase
+ * is kept: periodic messages carry the new payload in their next frame, on-change
+ * messages are sent as if updated individually.
+ */
+void CAN_Cyclic_GroupCommit(void);
+
+/**
+ * @brief Add a rolling (alive) counter to an existing cyclic message.
+ *
+ * The counter is written into the payload and incremented on every transmission,
+ * before the checksum is calculated.
+ *
+ * @param id          CAN identifier of an already registered message
+ * @param start_bit   Start bit in the payload (Intel order: byte = bit / 8)
+ * @param bit_len     Counter width in bits (1–8, 0 disables the counter)
+ * @param max         Last value before wrapping to 0 (0 = full field range)
+ * @return            1 on success, 0 if the ID is unknown, the field is invalid or
+ *                    all CAN_CYCLIC_EXT_CAPACITY extension records are in use
+ */
+uint8_t CAN_Cyclic_SetCounter(uint32_t id, uint8_t start_bit, uint8_t bit_len, uint8_t max);
+
+/**
+ * @brief Add a checksum to an existing cyclic message.
+ *
+ * The checksum is recalculated over the current payload on every transmission.
+ *
+ * @param id          CAN identifier of an already registered message
+ * @param type        One of CyclicCrcType
+ * @param crc_byte    Byte position of the checksum in the payload (0–7)
+ * @param data_id     E2E Data ID (Profile 1 uses both bytes, Profile 2 the low byte)
+ * @return            1 on success, 0 if the ID is unknown, the type is invalid or
+ *                    all extension records are in use
+ */
+uint8_t CAN_Cyclic_SetChecksum(uint32_t id, uint8_t type, uint8_t crc_byte, uint16_t data_id);
+
+/**
+ * @brief Select the transmission mode of an existing cyclic message.
+ *
+ * In the on-change modes CAN_Cyclic_AddOrUpdate only transmits when the payload differs
+ * from the stored one. The message interval acts as the burst period (BURST) or the
+ * maximum repetition time (ON_CHANGE_MINMAX).
+ *
+ * @param id          CAN identifier of an already registered message
+ * @param mode        One of CyclicMode
+ * @param shots       Number of transmissions for CYCLIC_MODE_BURST (must be > 0)
+ * @param min_ms      Minimum time between transmissions for CYCLIC_MODE_ON_CHANGE_MINMAX
+ * @return            1 on success, 0 if the ID is unknown, the arguments are invalid or
+ *                    BURST / ON_CHANGE_MINMAX needs an extension record and none is free
+ */
+uint8_t CAN_Cyclic_SetMode(uint32_t id, uint8_t mode, uint16_t shots, uint16_t min_ms);
+
+/**
+ * @brief Drive a bit field of an existing cyclic message from an on-device waveform generator.
+ *
+ * On every transmission the generator produces the next sample, which is written into the
+ * field before the rolling counter and checksum are applied. Setting the same field again
+ * replaces its generator; SIGGEN_OFF removes it.
+ *
+ * @param id          CAN identifier of an already registered message
+ * @param wave        One of SigGenWave (see signal_gen.h)
+ * @param start_bit   Start bit of the signal in the payload (Intel order)
+ * @param bit_len     Signal width in bits (1–16)
+ * @param period_ms   Waveform period in milliseconds
+ * @param min         Raw value at the bottom of the waveform
+ * @param max         Raw value at the top of the waveform
+ * @return            1 on success, 0 if the ID is unknown, arguments are invalid or no generator is free
+ */
+uint8_t CAN_Cyclic_SetGenerator(uint32_t id, uint8_t wave, uint8_t start_bit, uint8_t bit_len,
+                                uint16_t period_ms, uint16_t min, uint16_t max);
+
 
 #endif /* INC_CAN_CYCLIC_H_ */
@@ -0,0 +1,76 @@
+/*
+ * can_dict.h
+ * @brief   Dictionary-coded record for a received CAN frame, sent in batches
+ *          (output format 3). Cyclic traffic repeats the same IDs with mostly
+ *          unchanged payloads, so the encoder learns the IDs on the fly: each
+ *          gets a dictionary slot holding its last payload, and later frames
+ *          send the slot number and only the bytes that changed, XORed with
+ *          their previous value:
+ *
+ *              definition:  [Def][Slot][ID 2 or 4][Data 0-8][Delta]
+ *              known ID:    [Hit][Mask][Byte]...[Delta]
+ *
+ *          Def: 0x20 = Delta follows, 0x10 = 29-bit ID in 4 bytes, low nibble =
+ *          DLC (the compact record flags without 0x40); it (re)defines Slot.
+ *          Hit: 0x80 + 0x40 when Delta follows + the slot number (0-63). Bit i
+ *          of Mask is set when data byte i changed; one XOR byte follows per
+ *          set bit, lowest first. Delta is the varint of can_record.h.
+ *
+ *          A new ID takes the slots in turn, replacing the oldest definition.
+ *          A payload of another length is sent as a definition, and so is every
+ *          CAN_DICT_REFRESH-th frame of an ID, so a PC that lost a frame is in
+ *          step again after that many frames of each ID.
+ *
+ *          Batch body: [Batch][Time 4][Record]... as in can_record.h, with the
+ *          marker CAN_DICT_BATCH.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_CAN_DICT_H_
+#define INC_CAN_DICT_H_
+
+#include <stdint.h>
+
+/*
+ * Dictionary size: IDs that can be known at once (at most 64). Every slot takes
+ * 14 bytes of RAM. With more IDs on the bus than slots, frames turn into
+ * definitions and the output grows to about the size of compact records.
+ */
+#ifndef CAN_DICT_SIZE
+#define CAN_DICT_SIZE     32
+#endif
+#ifndef CAN_DICT_REFRESH
+#define CAN_DICT_REFRESH  32            ///< Frames of an ID between definitions (1–255)
+#endif
+
+#define CAN_DICT_BATCH    0x04          ///< Batch marker; CAN_REC_BATCH_TIME is added when Time follows
+#define CAN_DICT_HIT      0x80          ///< Record of a known ID
+#define CAN_DICT_DELTA    0x40          ///< Added to a hit: Delta follows
+#define CAN_DICT_SLOT     0x3F          ///< Slot number in a hit
+#define CAN_DICT_RECORD_MAX (1 + 1 + 4 + 8 + 4)
+
+/**
+ * @brief Forget every ID: the frames that follow are all sent as definitions.
+ *        Called when the output format is selected.
+ */
+void CAN_Dict_Reset(void);
+
+/**
+ * @brief Encode one frame and update the dictionary. Looks at every slot at
+ *        most once, so the time per frame is bounded by CAN_DICT_SIZE.
+ *
+ * @param out       Output
+ * @param room      Bytes available at out; nothing is written or learned if the
+ *                  record would not fit
+ * @param id        CAN identifier
+ * @param is_ext    0 = standard, 1 = extended
+ * @param data      Payload
+ * @param len       Payload length (DLC; 9–15 carry 8 bytes)
+ * @param delta_us  Time since the previous record, or -1 for none
+ * @return          Record length, 0 if it does not fit
+ */
+uint8_t CAN_Dict_Encode(uint8_t *out, uint8_t room, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len,
+                        int32_t delta_us);
+
+#endif /* INC_CAN_DICT_H_ */
@@ -0,0 +1,105 @@
+/*
+ * can_forward.h
+ * @brief   Forwarding of received CAN frames to the PC in the output format
+ *          selected by the build (SLCAN_MODE, FRAME_COBS) and the PC (command 0x14).
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_CAN_FORWARD_H_
+#define INC_CAN_FORWARD_H_
+
+#include <stdint.h>
+
+// Output formats
+#define CAN_FWD_DEFAULT   0     ///< Text lines (can_text.h), or [Ext][ID 4][Len][Data] frames with FRAME_COBS
+#define CAN_FWD_RECORD    1     ///< One compact record per frame (can_record.h)
+#define CAN_FWD_BATCH     2     ///< Compact records packed into batches (can_record.h)
+#define CAN_FWD_DICT      3     ///< Dictionary-coded records packed into batches (can_dict.h)
+
+// Format flags
+#define CAN_FWD_TIMESTAMP 0x01  ///< Records carry the time since the previous one
+
+/**
+ * @brief Default batch limits: a batch is sent once it holds this many bytes, or
+ *        this many µs after its first record, whichever comes first. It is sent
+ *        right away whenever the UART has nothing else left to send.
+ */
+#define CAN_FWD_BATCH_BYTES 48
+#define CAN_FWD_BATCH_US    1000
+
+/*
+ * Loss report, sent every CAN_FWD_REPORT_MS (packet 0x16) while frames are
+ * received or lost, counters since the last 0x16 (can_buffer.h):
+ *
+ *     [84][Policy][Peak][Received 4][Lost 4][Overrun 4][Count][ID 4][Lost 4]...
+ *
+ * Each entry is an ID whose count changed since it was last reported; bit 31 of
+ * ID marks a 29-bit ID, and 0xFFFFFFFF stands for all IDs without a counter of
+ * their own. At most CAN_FWD_LOSS_ENTRIES IDs fit, taken in turn: the others
+ * follow in the next reports.
+ */
+#define CAN_FWD_REPORT_LOSS  0x84
+#define CAN_FWD_LOSS_HDR_LEN 16
+#define CAN_FWD_LOSS_ENTRIES 6
+#ifndef CAN_FWD_REPORT_MS
+#define CAN_FWD_REPORT_MS    1000
+#endif
+
+extern volatile uint32_t can_fwd_dropped;      ///< Frames dropped because CAN_Forward was called while not ready
+
+/**
+ * @brief Select the output format. An open batch is sent first, waiting for
+ *        room in the UART ring; the timestamp base and the dictionary restart
+ *        now. Main loop only.
+ *
+ * @param format  CAN_FWD_DEFAULT to CAN_FWD_DICT
+ * @param flags   CAN_FWD_ flags (records only)
+ * @return        1 if accepted, 0 for an unknown format or flag
+ */
+uint8_t CAN_Forward_SetFormat(uint8_t format, uint8_t flags);
+
+/**
+ * @brief Set the batch limits (CAN_FWD_BATCH, CAN_FWD_DICT).
+ *
+ * @param bytes       Send once the batch holds this many bytes (1–FRAME_TX_MAX)
+ * @param timeout_us  Send at the latest this long after the first record
+ * @return            1 if accepted, 0 if bytes is out of range
+ */
+uint8_t CAN_Forward_SetBatch(uint8_t bytes, uint16_t timeout_us);
+
+/**
+ * @brief Set the loss report period.
+ *
+ * @param ms  Milliseconds between reports, 0 = no reports
+ */
+void CAN_Forward_SetReport(uint16_t ms);
+
+/**
+ * @brief Send a batch whose time is up or that the idle UART can take now, and
+ *        the loss report when it is due. Call from the main loop.
+ */
+void CAN_Forward_Poll(void);
+
+/**
+ * @brief Whether CAN_Forward can take a frame now without dropping it: the UART
+ *        ring has room for its output, or the open batch for its record. While
+ *        not, received frames wait in can_buffer.h, and a loss report that is
+ *        due goes first.
+ */
+uint8_t CAN_Forward_Ready(void);
+
+/**
+ * @brief Send one received frame to the PC. Call from the main loop only, when
+ *        CAN_Forward_Ready. Otherwise the frame may be dropped whole
+ *        (uart_tx_dropped, or can_fwd_dropped for batches).
+ *
+ * @param id      CAN identifier
+ * @param is_ext  0 = standard, 1 = extended
+ * @param data    Payload
+ * @param len     Data length code (9–15 carry 8 bytes)
+ * @param rx_us   Reception time (Timebase_Now), for the timestamps
+ */
+void CAN_Forward(uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, uint32_t rx_us);
+
+#endif /* INC_CAN_FORWARD_H_ */
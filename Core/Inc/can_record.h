@@ -0,0 +1,62 @@
+/*
+ * can_record.h
+ * @brief   Compact binary record for a received CAN frame, sent to the PC as the
+ *          body of one UART frame instead of a text line:
+ *
+ *              [Flags][ID 2 or 4][Data 0-8][Delta]
+ *
+ *          Flags: 0x40 marks a record (reports start at 0x80, the full records
+ *          of the COBS build with 0x00 / 0x01), 0x10 = 29-bit ID in 4 bytes,
+ *          0x20 = Delta follows, low nibble = DLC. Delta is the time since the
+ *          previous record sent, in microseconds, as a little-endian base-128
+ *          varint of 1-4 bytes (7 bits per byte, 0x80 = more bytes follow).
+ *          Multi-byte IDs are big-endian.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_CAN_RECORD_H_
+#define INC_CAN_RECORD_H_
+
+#include <stdint.h>
+
+#define CAN_REC_MARK      0x40          ///< Set in every record flag byte
+#define CAN_REC_EXT       0x10          ///< 4-byte (29-bit) ID
+#define CAN_REC_DELTA     0x20          ///< Time delta follows the data
+#define CAN_REC_DLC       0x0F          ///< Data length code
+#define CAN_REC_DELTA_MAX 0x0FFFFFFFu   ///< Largest delta (4 varint bytes); longer gaps saturate
+#define CAN_RECORD_MAX    (1 + 4 + 8 + 4)
+
+/*
+ * Batch: several records in one frame body, [Batch][Time 4][Record]...
+ * Time (big-endian, µs) is the device time of the first record and present
+ * with CAN_REC_BATCH_TIME; every later record then carries its delta to the
+ * one before it.
+ */
+#define CAN_REC_BATCH      0x02         ///< Batch marker
+#define CAN_REC_BATCH_TIME 0x01         ///< Added to the marker: Time follows
+
+/**
+ * @brief Encode one frame.
+ *
+ * @param out       Output, at least CAN_RECORD_MAX bytes
+ * @param id        CAN identifier
+ * @param is_ext    0 = standard, 1 = extended
+ * @param data      Payload
+ * @param len       Payload length (DLC; 9–15 carry 8 bytes)
+ * @param delta_us  Time since the previous record, or -1 for none
+ * @return          Record length
+ */
+uint8_t CAN_Record_Encode(uint8_t *out, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len,
+                          int32_t delta_us);
+
+/**
+ * @brief Write a time delta as a varint (also used by can_dict.c).
+ *
+ * @param out       Output, at least 4 bytes
+ * @param delta_us  Time since the previous record; saturates at CAN_REC_DELTA_MAX
+ * @return          Bytes written (1–4)
+ */
+uint8_t CAN_Record_PutDelta(uint8_t *out, uint32_t delta_us);
+
+#endif /* INC_CAN_RECORD_H_ */
@@ -0,0 +1,37 @@
+/*
+ * can_text.h
+ * @brief   Text line for a received CAN frame, as sent to the PC in the default
+ *          (SOF framing) mode:
+ *
+ *              ID: 0x123 [Std], Data: 11 22 33 \r\n
+ *
+ *          Rendered in one pass with a nibble-to-ASCII table; the output is the
+ *          same as the former sprintf("ID: 0x%03lX [%s], Data: ") + "%02X " per
+ *          byte + "\r\n", without pulling printf into the image.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_CAN_TEXT_H_
+#define INC_CAN_TEXT_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Longest line: "ID: 0x1FFFFFFF [Ext], Data: " + 8 x "XX " + CR LF.
+ */
+#define CAN_TEXT_LINE_MAX 56
+
+/**
+ * @brief Format one frame.
+ *
+ * @param out     Output, at least CAN_TEXT_LINE_MAX bytes (not NUL-terminated)
+ * @param id      CAN identifier
+ * @param is_ext  0 = standard, 1 = extended
+ * @param data    Payload
+ * @param len     Payload length (DLC; 9–15 print 8 bytes)
+ * @return        Line length
+ */
+uint8_t CAN_Text_Format(char *out, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len);
+
+#endif /* INC_CAN_TEXT_H_ */
@@ -0,0 +1,43 @@
+/*
+ * clock.h
+ * @brief   System clock tree: 8 MHz HSE -> PLL x9 = 72 MHz SYSCLK / HCLK,
+ *          APB1 = 36 MHz, APB2 = 72 MHz, two flash wait states.
+ *          Peripheral drivers derive their dividers from the functions below
+ *          instead of assuming a fixed clock.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_CLOCK_H_
+#define INC_CLOCK_H_
+
+#include "stm32f1xx.h"
+
+/**
+ * @brief Switch to the PLL and update SystemCoreClock. Call first in main().
+ *
+ * If the crystal does not start, the PLL runs from HSI / 2 x 16 = 64 MHz instead.
+ *
+ * @return 1 if running from HSE at 72 MHz, 0 if fallen back to HSI
+ */
+uint8_t Clock_Init(void);
+
+/**
+ * @brief APB1 peripheral clock (CAN, TIM2 before doubling).
+ * @return Frequency in Hz
+ */
+uint32_t Clock_PCLK1(void);
+
+/**
+ * @brief APB2 peripheral clock (USART1).
+ * @return Frequency in Hz
+ */
+uint32_t Clock_PCLK2(void);
+
+/**
+ * @brief Clock of the APB1 timers (TIM2–TIM4): PCLK1, doubled when APB1 is divided.
+ * @return Frequency in Hz
+ */
+uint32_t Clock_TimerAPB1(void);
+
+#endif /* INC_CLOCK_H_ */
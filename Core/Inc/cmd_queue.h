@@ -0,0 +1,63 @@
+/*
+ * cmd_queue.h
+ * @brief   Lock-free single-producer / single-consumer queue of complete UART
+ *          command packets. USART1_IRQHandler writes bytes straight into the
+ *          current slot and pushes it when the packet is complete; the main loop
+ *          executes queued packets, so CAN transmission never blocks reception.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_CMD_QUEUE_H_
+#define INC_CMD_QUEUE_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Number of packet slots (one is always owned by the receiver).
+ */
+#define CMD_QUEUE_SLOTS 4
+
+/**
+ * @brief Producer (ISR): buffer the packet being received is written to.
+ * @return Pointer to a CMD_MAX_LEN byte buffer
+ */
+uint8_t *CmdQueue_Current(void);
+
+/**
+ * @brief Producer (ISR): queue the current packet and move to the next slot.
+ *
+ * If the queue is full the packet is dropped and the slot is reused.
+ *
+ * @param len  Packet length
+ * @param seq  Sequence number of the frame that carried the packet
+ * @return     1 if queued, 0 if dropped
+ */
+uint8_t CmdQueue_Push(uint16_t len, uint8_t seq);
+
+/**
+ * @brief Producer (ISR): check whether a packet completed now would be dropped.
+ * @return 1 if all slots but the receiving one are queued
+ */
+uint8_t CmdQueue_Full(void);
+
+/**
+ * @brief Consumer (thread): oldest queued packet.
+ *
+ * @param len  Output: packet length
+ * @param seq  Output: frame sequence number
+ * @return     Pointer to the packet, NULL if the queue is empty
+ */
+uint8_t *CmdQueue_Peek(uint16_t *len, uint8_t *seq);
+
+/**
+ * @brief Consumer (thread): release the packet returned by CmdQueue_Peek.
+ */
+void CmdQueue_Pop(void);
+
+/**
+ * @brief Number of packets dropped because the queue was full.
+ */
+uint32_t CmdQueue_Dropped(void);
+
+#endif /* INC_CMD_QUEUE_H_ */
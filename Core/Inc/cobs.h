@@ -0,0 +1,68 @@
+/*
+ * cobs.h
+ * @brief   Consistent Overhead Byte Stuffing. Encoded data holds no zero bytes,
+ *          so a zero delimits frames; the overhead is 1 byte per 254 (at most).
+ *          Zero-free runs are found and copied a word at a time instead of one
+ *          byte per loop.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_COBS_H_
+#define INC_COBS_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Largest encoded size of n bytes (without the delimiter).
+ */
+#define COBS_MAX_ENCODED(n) ((n) + (n) / 254 + 1)
+
+/**
+ * @brief State of a streaming decoder; zero it (or call COBS_DecodeReset) at a frame start.
+ */
+typedef struct {
+    uint8_t left;       ///< Data bytes left in the current block
+    uint8_t zero;       ///< Current block ends in an implied zero
+} CobsDecoder;
+
+/**
+ * @brief Encode a buffer.
+ *
+ * @param src  Input bytes
+ * @param len  Number of input bytes
+ * @param dst  Output, at least COBS_MAX_ENCODED(len) bytes (must not overlap src)
+ * @return     Encoded length; the caller appends the 0x00 delimiter
+ */
+uint16_t COBS_Encode(const uint8_t *src, uint16_t len, uint8_t *dst);
+
+/**
+ * @brief Start decoding a new frame.
+ * @param d  Decoder state
+ */
+void COBS_DecodeReset(CobsDecoder *d);
+
+/**
+ * @brief Decode the next piece of a frame.
+ *
+ * The decoded data is returned as segments that point into src (or at a
+ * constant zero byte), so the caller copies each run in one block.
+ *
+ * @param d        Decoder state
+ * @param src      Encoded bytes up to, not including, the delimiter (n > 0, no zeros)
+ * @param n        Number of encoded bytes
+ * @param seg      Output: start of the decoded segment
+ * @param seg_len  Output: segment length (0 if a block header was consumed)
+ * @return         Number of encoded bytes consumed
+ */
+uint16_t COBS_DecodeNext(CobsDecoder *d, const uint8_t *src, uint16_t n,
+                         const uint8_t **seg, uint16_t *seg_len);
+
+/**
+ * @brief Check at the delimiter that the frame was not cut inside a block.
+ * @param d  Decoder state
+ * @return   1 if the decoded frame is complete
+ */
+uint8_t COBS_DecodeComplete(const CobsDecoder *d);
+
+#endif /* INC_COBS_H_ */
@@ -0,0 +1,87 @@
+/*
+ * command.h
+ * @brief   PC command protocol: packet lengths and execution.
+ *          Packets arrive in UART frames (frame.h) and are executed from the main loop.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_COMMAND_H_
+#define INC_COMMAND_H_
+
+#include <stdint.h>
+
+#define CMD_MAX_LEN      300        ///< Largest packet (bulk load)
+#define CMD_LEN_UNKNOWN  0          ///< Not enough bytes yet to know the length
+#define CMD_LEN_INVALID  0xFFFF     ///< Unknown packet type or bad length field
+
+// Command status, returned by Command_Execute and reported to the PC
+#define CMD_OK           0x00       ///< Executed
+#define CMD_ERR_REJECTED 0x01       ///< Unknown ID, invalid argument or no free slot
+#define CMD_ERR_CHECK    0x02       ///< Packet CRC or entry layout wrong (bulk / group)
+#define CMD_ERR_FLASH    0x03       ///< Flash write or erase failed, or the configuration does not fit
+#define CMD_ERR_SEQUENCE 0x04       ///< Sequence number outside the window, not executed
+
+/**
+ * @brief Commands the PC may have in flight (sequence numbers ahead of the oldest
+ *        unexecuted one). A frame with an empty packet restarts the window.
+ */
+#define CMD_WINDOW       16
+
+// Reports to the PC: [Type][Seq][Status][Ack][Sack 2]
+#define CMD_REPORT_ACK   0x80       ///< Seq = last command executed in this pass
+#define CMD_REPORT_NACK  0x81       ///< Seq = command that failed with Status
+#define CMD_REPORT_LEN   6
+
+// Replies to queries, sent before the ACK of the same pass
+#define CMD_REPORT_LIST  0x82       ///< [Type][Seq][Next 2][Count][Entries], see CMD_LIST
+#define CMD_REPORT_INFO  0x83       ///< Layout below
+#define CMD_LIST_HDR_LEN 5
+
+/*
+ * Info reply: [Type][Seq][Major][Minor][Capacity 2][Used 2][ExtCapacity][GenCapacity]
+ *             [Window][MaxPacket 2][Flags]
+ */
+#define CMD_INFO_LEN          14
+#define CMD_INFO_PAUSED       0x01  ///< Scheduler paused
+#define CMD_INFO_COBS         0x02  ///< Built with FRAME_COBS
+#define CMD_INFO_FLOW_CONTROL 0x04  ///< Built with UART_FLOW_CONTROL
+
+#define CMD_VERSION_MAJOR 1
+#define CMD_VERSION_MINOR 1
+
+/**
+ * @brief Work out the full length of a packet from the bytes received so far.
+ *
+ * @param cmd       Packet bytes
+ * @param received  Number of bytes received
+ * @return          Packet length, CMD_LEN_UNKNOWN or CMD_LEN_INVALID
+ */
+uint16_t Command_Length(const uint8_t *cmd, uint16_t received);
+
+/**
+ * @brief Execute one complete packet.
+ *
+ * @param cmd        Packet bytes
+ * @param total_len  Packet length as returned by Command_Length
+ * @return           CMD_OK or a CMD_ERR_ code
+ */
+uint8_t Command_Execute(uint8_t *cmd, uint16_t total_len);
+
+/**
+ * @brief Execute all packets queued by the UART receiver. Call from the main loop.
+ *
+ * Each packet is executed once per sequence number; retransmissions of a
+ * command already executed are only acknowledged again, and commands outside
+ * the window are refused with CMD_ERR_SEQUENCE. An empty packet (a frame with
+ * Len 0) executes nothing and restarts the window right after its sequence
+ * number; after reset the first frame received sets the window.
+ *
+ * A failed command is answered with a NACK right away, and every pass ends with
+ * one cumulative ACK:
+ * Ack is the oldest sequence number not executed yet, bit i of Sack is set if
+ * Ack + i has already been executed (out of order, after a lost frame).
+ */
+void Command_Process(void);
+
+#endif /* INC_COMMAND_H_ */
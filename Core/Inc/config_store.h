@@ -0,0 +1,55 @@
+/*
+ * config_store.h
+ * @brief   Persistent bridge configuration (cyclic schedule, CAN bit rate and filter)
+ *          kept in the last pages of the internal flash, restored at boot.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_CONFIG_STORE_H_
+#define INC_CONFIG_STORE_H_
+
+#include <stdint.h>
+#include "flash_store.h"    // Store capacity
+#include "can_cyclic.h"     // Saved record types
+
+#define CONFIG_FLASH_PAGES      4       ///< Flash pages of the store
+#define CONFIG_FLASH_PAGE_SIZE  1024    ///< Bytes per page (FLASH_PAGE_SIZE of the part)
+#define CONFIG_SAVE_FIXED_SIZE  42      ///< Store bytes of the layout, bit rate, filter and count records
+
+/**
+ * @brief Cyclic messages a save always fits with all CAN_CYCLIC_GEN_CAPACITY
+ *        generators in use (73 with the defaults). The table holds up to
+ *        CAN_CYCLIC_CAPACITY; Config_Save refuses a schedule that does not fit.
+ */
+#define CONFIG_SAVE_MAX_MESSAGES \
+    ((FLASH_STORE_CAPACITY(CONFIG_FLASH_PAGE_SIZE, CONFIG_FLASH_PAGES) - CONFIG_SAVE_FIXED_SIZE - \
+      CAN_CYCLIC_GEN_CAPACITY * FLASH_STORE_RECORD_SIZE(sizeof(CyclicGenEntry))) / \
+     FLASH_STORE_RECORD_SIZE(sizeof(CyclicEntry)))
+
+/**
+ * @brief Mount the flash store and apply the saved configuration.
+ *
+ * Call once after CAN_Config(). Saved cyclic messages start transmitting one interval later.
+ */
+void Config_Restore(void);
+
+/**
+ * @brief Save the current schedule, bit rate and filter. Unchanged records are not rewritten.
+ *
+ * Nothing is written unless the whole configuration fits. The saved layout is
+ * marked valid only after every record was written, so a save that fails or
+ * is cut short by a reset leaves no configuration to restore instead of a mix
+ * of the old and the new one.
+ *
+ * @return 1 on success, 0 on flash error or if the configuration does not fit
+ */
+uint8_t Config_Save(void);
+
+/**
+ * @brief Erase the saved configuration (the running configuration is kept).
+ * @return 1 on success, 0 on flash error
+ */
+uint8_t Config_Erase(void);
+
+#endif /* INC_CONFIG_STORE_H_ */
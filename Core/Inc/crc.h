@@ -0,0 +1,48 @@
+/*
+ * crc.h
+ * @brief   Table-driven CRC routines used for E2E protection of CAN payloads
+ *          and for the UART frames from the PC.
+ *          The functions only run the CRC register; init and final XOR values
+ *          are applied by the caller so that several buffers can be chained.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_CRC_H_
+#define INC_CRC_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Update a CRC8 SAE-J1850 register (poly 0x1D) with a block of bytes.
+ *
+ * @param crc   Current register value (0xFF for plain SAE-J1850, 0x00 for E2E Profile 1)
+ * @param data  Pointer to input bytes
+ * @param len   Number of bytes
+ * @return      New register value (final XOR not applied)
+ */
+uint8_t CRC8_J1850_Update(uint8_t crc, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Update a CRC8H2F register (poly 0x2F, AUTOSAR E2E Profile 2) with a block of bytes.
+ *
+ * @param crc   Current register value (0xFF to start)
+ * @param data  Pointer to input bytes
+ * @param len   Number of bytes
+ * @return      New register value (final XOR not applied)
+ */
+uint8_t CRC8_H2F_Update(uint8_t crc, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Update a CRC16-CCITT register (poly 0x1021, MSB first) with a block of bytes.
+ *
+ * The STM32F1 CRC unit only computes CRC32 over whole words, so this is done in software.
+ *
+ * @param crc   Current register value (0xFFFF for CRC-16/CCITT-FALSE)
+ * @param data  Pointer to input bytes
+ * @param len   Number of bytes
+ * @return      New register value
+ */
+uint16_t CRC16_CCITT_Update(uint16_t crc, const uint8_t *data, uint16_t len);
+
+#endif /* INC_CRC_H_ */
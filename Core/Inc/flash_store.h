@@ -0,0 +1,99 @@
+/*
+ * flash_store.h
+ * @brief   Log-structured key-value store for small configuration records in flash.
+ *          Records are appended to the active page; when it is full the next page
+ *          is opened and the live records of the oldest page are moved forward, so
+ *          every page is erased in turn (wear leveling).
+ *          Flash access goes through FlashStoreDev, so the same code runs against
+ *          the STM32 flash controller or a RAM-backed model on a PC.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_FLASH_STORE_H_
+#define INC_FLASH_STORE_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Largest value that can be stored under one key.
+ */
+#define FLASH_STORE_MAX_VALUE 64
+
+/**
+ * @brief Flash bytes one record with a value of len bytes occupies.
+ */
+#define FLASH_STORE_RECORD_SIZE(len) (4 + (((len) + 1) & ~1u))
+
+/**
+ * @brief Bytes of live records that always fit an area of page_count pages:
+ *        a write can then always be placed after at most page_count - 1 page
+ *        changes, whatever the order of the records in the pages.
+ */
+#define FLASH_STORE_CAPACITY(page_size, page_count) \
+    (((page_count) - 1u) * ((page_size) - 8u - FLASH_STORE_RECORD_SIZE(FLASH_STORE_MAX_VALUE)))
+
+/**
+ * @brief Flash area used by the store.
+ */
+typedef struct {
+    const uint8_t *base;        ///< Memory-mapped start of the area (used for reads)
+    uint16_t page_size;         ///< Bytes per erase page (multiple of 4)
+    uint8_t page_count;         ///< Number of pages (at least 2, one is kept as spare)
+    /** Erase one page (index from base). Return 1 on success. */
+    uint8_t (*erase)(uint8_t page);
+    /** Program halfwords at a byte offset from base. Return 1 on success. */
+    uint8_t (*program)(uint32_t offset, const uint16_t *data, uint16_t count);
+} FlashStoreDev;
+
+/**
+ * @brief Mount the store, formatting the area if it holds no valid page.
+ *
+ * A page change that was interrupted by a reset is redone from the start.
+ *
+ * @param dev  Flash area (must stay valid while the store is used)
+ * @return     1 on success, 0 on flash error
+ */
+uint8_t FlashStore_Init(const FlashStoreDev *dev);
+
+/**
+ * @brief Erase all pages and start an empty store.
+ * @return 1 on success, 0 on flash error
+ */
+uint8_t FlashStore_Format(void);
+
+/**
+ * @brief Store a value. Nothing is written if the stored value is already identical.
+ *
+ * @param key   Record key (0xFFFF is reserved)
+ * @param data  Value bytes
+ * @param len   Value length (1–FLASH_STORE_MAX_VALUE)
+ * @return      1 on success, 0 if the store is full or flash failed
+ */
+uint8_t FlashStore_Write(uint16_t key, const void *data, uint8_t len);
+
+/**
+ * @brief Read the latest value of a key.
+ *
+ * @param key     Record key
+ * @param data    Output buffer
+ * @param maxlen  Size of the output buffer
+ * @return        Value length, 0 if the key is missing or deleted
+ */
+uint8_t FlashStore_Read(uint16_t key, void *data, uint8_t maxlen);
+
+/**
+ * @brief Bytes of live records the mounted area always holds
+ *        (FLASH_STORE_CAPACITY of its geometry).
+ */
+uint32_t FlashStore_Capacity(void);
+
+/**
+ * @brief Delete a key (writes a tombstone if the key exists).
+ *
+ * @param key  Record key
+ * @return     1 on success, 0 on flash error
+ */
+uint8_t FlashStore_Delete(uint16_t key);
+
+#endif /* INC_FLASH_STORE_H_ */
@@ -0,0 +1,60 @@
+/*
+ * frame.h
+ * @brief   Framing of the PC link on USART1, in one of two build-time modes:
+ *          - SOF (default): [0xA5][Seq][Len 2][HdrCRC8][Body][CRC16 2]; the header
+ *            check rejects a corrupted length at once and the CRC16 the rest.
+ *          - COBS (FRAME_COBS=1): [Seq][Body][CRC16 2], COBS encoded and ended by
+ *            0x00, so a frame boundary is a single zero byte.
+ *          Either way the receiver is back in step at the next frame after any
+ *          corruption. PC-to-device bodies are command packets.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_FRAME_H_
+#define INC_FRAME_H_
+
+#include <stdint.h>
+
+/**
+ * @brief 1 = COBS framing in both directions, 0 = SOF framing. Set with -D at build time.
+ */
+#ifndef FRAME_COBS
+#define FRAME_COBS 0
+#endif
+
+#define FRAME_SOF      0xA5         ///< Start of frame (never a packet type)
+#define FRAME_HDR_LEN  5            ///< SOF, sequence, length, header CRC8
+#define FRAME_CRC_LEN  2            ///< CRC16 trailer
+#define FRAME_TX_MAX   64           ///< Largest body sent by Frame_Send
+#define FRAME_WIRE_MAX (FRAME_HDR_LEN + FRAME_TX_MAX + FRAME_CRC_LEN)  ///< Longest frame on the wire (either framing)
+
+// Receive statistics
+extern volatile uint32_t frame_errors;     ///< Frames dropped: bad header, CRC or packet length
+
+/**
+ * @brief Feed received bytes to the deframer (called from the UART receive interrupt).
+ *
+ * Any number of bytes may be passed at once; a run can end in the middle of a
+ * frame or hold several frames. Complete frames that pass all checks are pushed
+ * to the command queue. While the queue is full, reception stops before the
+ * next frame so that nothing is lost; the caller keeps the rest and retries.
+ *
+ * @param data  Received bytes
+ * @param n     Number of bytes
+ * @return      Number of bytes consumed (less than n only if the queue is full)
+ */
+uint16_t Frame_Receive(const uint8_t *data, uint16_t n);
+
+/**
+ * @brief Queue one frame for the PC (UART1_Write: whole or not at all). Call
+ *        from the main loop only; for replies that must not be lost, wait for
+ *        UART1_TxWait(FRAME_WIRE_MAX) first.
+ *
+ * @param body  Frame body
+ * @param len   Body length (1–FRAME_TX_MAX)
+ * @return      1 if queued, 0 if the transmit ring was full
+ */
+uint8_t Frame_Send(const uint8_t *body, uint8_t len);
+
+#endif /* INC_FRAME_H_ */
@@ -0,0 +1,67 @@
+/*
+ * signal_gen.h
+ * @brief   Fixed-point waveform generators used to animate cyclic CAN signals
+ *          (e.g. engine temperature sweeps) on the device without PC traffic.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_SIGNAL_GEN_H_
+#define INC_SIGNAL_GEN_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Available waveforms.
+ */
+typedef enum {
+    SIGGEN_OFF      = 0,  ///< Generator disabled
+    SIGGEN_RAMP     = 1,  ///< Sawtooth from min to max, then jump back to min
+    SIGGEN_SINE     = 2,  ///< Sine between min and max (256-entry lookup table)
+    SIGGEN_STEP     = 3,  ///< Square wave: min for half a period, max for the other half
+    SIGGEN_TRIANGLE = 4,  ///< Linear up from min to max and back down
+    SIGGEN_NOISE    = 5   ///< Pseudo-random values between min and max (xorshift32)
+} SigGenWave;
+
+/**
+ * @brief State of one generator. The phase is a 32-bit accumulator (2^32 = one period).
+ */
+typedef struct {
+    uint8_t wave;       ///< SigGenWave
+    uint16_t min;       ///< Raw output value at the bottom of the waveform
+    uint16_t max;       ///< Raw output value at the top of the waveform
+    uint32_t phase;     ///< Phase accumulator (noise: PRNG state)
+    uint32_t step;      ///< Phase increment per sample
+} SigGen;
+
+/**
+ * @brief Calculate the phase increment for a given sample period and waveform period.
+ *
+ * Both times must use the same unit.
+ *
+ * @param sample   Time between two samples (the message interval)
+ * @param period   Waveform period
+ * @return         Phase increment per sample
+ */
+uint32_t SigGen_PhaseStep(uint32_t sample, uint32_t period);
+
+/**
+ * @brief Initialize a generator at phase 0.
+ *
+ * @param g      Generator to initialize
+ * @param wave   One of SigGenWave
+ * @param min    Raw value at the bottom of the waveform
+ * @param max    Raw value at the top of the waveform
+ * @param step   Phase increment per sample (see SigGen_PhaseStep)
+ */
+void SigGen_Init(SigGen *g, uint8_t wave, uint16_t min, uint16_t max, uint32_t step);
+
+/**
+ * @brief Produce the next sample and advance the phase.
+ *
+ * @param g  Generator
+ * @return   Raw value in [min, max]
+ */
+uint16_t SigGen_Next(SigGen *g);
+
+#endif /* INC_SIGNAL_GEN_H_ */
@@ -0,0 +1,79 @@
+/*
+ * slcan.h
+ * @brief   SLCAN (Lawicel) ASCII protocol on USART1, selected at build time with
+ *          SLCAN_MODE=1 instead of the framed binary command protocol. Lines are
+ *          received into the command queue by the UART interrupt and executed from
+ *          the main loop; received CAN frames are sent as t/T lines, so Linux
+ *          slcand and can-utils work unchanged.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_SLCAN_H_
+#define INC_SLCAN_H_
+
+#include <stdint.h>
+
+/**
+ * @brief 1 = USART1 speaks SLCAN, 0 = framed command protocol. Set with -D at build time.
+ */
+#ifndef SLCAN_MODE
+#define SLCAN_MODE 0
+#endif
+
+/**
+ * @brief Serial number returned by the N command (4 characters).
+ */
+#ifndef SLCAN_SERIAL
+#define SLCAN_SERIAL "0001"
+#endif
+
+#define SLCAN_LINE_MAX  32          ///< Longest line in either direction, CR included
+
+// Statistics
+extern volatile uint32_t slcan_errors;     ///< Lines answered with BEL (unknown, malformed, too long)
+
+/**
+ * @brief Feed received bytes (called from the UART receive interrupt).
+ *
+ * Same contract as Frame_Receive: complete lines go to the command queue, and
+ * while it is full reception stops before the next line.
+ *
+ * @param data  Received bytes
+ * @param n     Number of bytes
+ * @return      Number of bytes consumed (less than n only if the queue is full)
+ */
+uint16_t SLCAN_Receive(const uint8_t *data, uint16_t n);
+
+/**
+ * @brief Execute the queued lines and answer each with CR (ok) or BEL (error).
+ *        Call from the main loop.
+ */
+void SLCAN_Process(void);
+
+/**
+ * @brief Send a received CAN frame to the PC if the channel is open.
+ *
+ * @param id      CAN identifier
+ * @param is_ext  1 = 29-bit identifier
+ * @param data    Payload
+ * @param len     Payload length (0–8)
+ * @param rx_us   Reception time (Timebase_Now), for the timestamp
+ */
+void SLCAN_Forward(uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, uint32_t rx_us);
+
+/**
+ * @brief Format a frame as an SLCAN line: t<id 3><len><data>[<time 4>]\r or
+ *        T<id 8><len><data>[<time 4>]\r.
+ *
+ * @param out        Output, at least SLCAN_LINE_MAX characters (not NUL-terminated)
+ * @param id         CAN identifier
+ * @param is_ext     1 = 29-bit identifier
+ * @param data       Payload
+ * @param len        Payload length (0–8)
+ * @param timestamp  Milliseconds (0–59999), or -1 for none
+ * @return           Line length
+ */
+uint8_t SLCAN_Format(char *out, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, int32_t timestamp);
+
+#endif /* INC_SLCAN_H_ */
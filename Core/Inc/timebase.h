@@ -0,0 +1,44 @@
+/*
+ * timebase.h
+ * @brief   Microsecond time base on TIM2 with a one-shot alarm.
+ *          TIM2 counts at 1 MHz; overflows extend the count to 32 bits and
+ *          channel 1 compare wakes the cyclic scheduler at the next deadline.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include "stm32f1xx.h"
+
+/**
+ * @brief Start TIM2 as a free-running 1 MHz counter and enable its interrupt.
+ */
+void Timebase_Init(void);
+
+/**
+ * @brief Current time in microseconds (wraps after ~71 minutes).
+ */
+uint32_t Timebase_Now(void);
+
+/**
+ * @brief Run CAN_Cyclic_Update() from the TIM2 interrupt at the given time.
+ *
+ * Replaces any earlier alarm. A deadline in the past fires immediately.
+ *
+ * @param deadline  Absolute time in microseconds
+ */
+void Timebase_SetAlarm(uint32_t deadline);
+
+/**
+ * @brief Run CAN_Cyclic_Update() from the TIM2 interrupt as soon as possible.
+ */
+void Timebase_Kick(void);
+
+/**
+ * @brief TIM2 interrupt handler: counter overflow and alarm.
+ */
+void TIM2_IRQHandler(void);
+
+#endif /* INC_TIMEBASE_H_ */
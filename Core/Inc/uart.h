@@ -1,7 +1,7 @@
 /*
  * uart.h
  *UART1 driver header for initialization and communication functions.
- *Supports basic UART transmission and reception using polling and interrupt.
+ *Reception and transmission both run through DMA rings.
  *  Created on: May 30, 2025
  *      Author: nguye
  */
@@ -11,32 +11,112 @@
 
 #include "stm32f1xx.h"
 
-// UART receive buffer and status flags
-extern uint8_t rx_buffer[];                    ///< Buffer to store received UART data
-extern volatile uint8_t rx_index;              ///< Index for buffer tracking
-extern volatile uint8_t uart_rx_complete_flag; ///< Flag to indicate full message received
+/**
+ * @brief PC link baud rate. With USART1 on the 72 MHz APB2 clock any rate up to
+ *        4500000 works (BRR >= 16); 921600, 2000000, 3000000 and 4500000 are
+ *        within 0.2% of the target. Set with -D at build time.
+ */
+#ifndef UART_BAUDRATE
+#define UART_BAUDRATE 921600
+#endif
+
+/**
+ * @brief 1 = RTS/CTS flow control on PA12 / PA11 (CAN moves to PB9 TX / PB8 RX).
+ *        RTS is driven from the receive side: it is released whenever received
+ *        frames are waiting in the DMA buffer for a free command slot. CTS pauses
+ *        transmission in hardware. Set with -D at build time.
+ */
+#ifndef UART_FLOW_CONTROL
+#define UART_FLOW_CONTROL 0
+#endif
+
+/**
+ * @brief Size of the circular DMA receive buffer (the HT/TC interrupts fire every half).
+ */
+#define UART_RX_RING_SIZE 256
 
 /**
- * @brief Initialize UART1 on PA9 (TX) and PA10 (RX) with interrupt-based reception.
+ * @brief Size of the transmit ring drained by DMA1 channel 4 (power of two).
+ *        Set with -D at build time.
+ */
+#ifndef UART_TX_RING_SIZE
+#define UART_TX_RING_SIZE 512
+#endif
+
+// UART receive state and statistics
+extern volatile uint32_t uart_isr_max_cycles;  ///< Longest USART1 ISR run in CPU cycles
+extern volatile uint32_t uart_rx_overruns;     ///< Bytes lost to USART overrun
+extern volatile uint32_t uart_rx_dropped;      ///< Bytes discarded while the command queue was full
+extern volatile uint32_t uart_rx_stalls;       ///< Times RTS held the PC back
+extern volatile uint32_t uart_tx_dropped;      ///< Bytes refused because the transmit ring was full
+extern volatile uint16_t uart_tx_peak;         ///< Highest transmit ring fill in bytes
+
+/**
+ * @brief Initialize UART1 on PA9 (TX) and PA10 (RX) with DMA reception.
+ *
+ * DMA1 channel 5 fills a circular buffer; the idle-line interrupt and the DMA
+ * half/full-transfer interrupts hand new bytes to the deframer (frame.h), so there is
+ * one interrupt per burst instead of one per byte.
  */
 void UART1_Init(void);
 
 /**
- * @brief Send a single character over UART1.
+ * @brief Resume reception after a command slot was freed. Call from the main loop.
+ */
+void UART1_RxResume(void);
+
+/**
+ * @brief Queue bytes for transmission. Returns at once; DMA1 channel 4 sends
+ *        them in the background. Call from the main loop only.
+ *
+ * All or nothing: if the ring cannot take every byte, none are queued and
+ * the count is added to uart_tx_dropped, so a line or frame never goes out cut.
+ *
+ * @param data  Bytes to send
+ * @param n     Number of bytes
+ * @return      n if queued, 0 if dropped
+ */
+uint16_t UART1_Write(const uint8_t *data, uint16_t n);
+
+/**
+ * @brief Free space in the transmit ring in bytes.
+ */
+uint16_t UART1_TxFree(void);
+
+/**
+ * @brief Wait until the transmit ring has room for n bytes. For replies that
+ *        must not be dropped; call from the main loop only.
+ */
+void UART1_TxWait(uint16_t n);
+
+/**
+ * @brief Queue a single character (see UART1_Write).
  * @param c Character to be sent
+ * @return  1 if queued, 0 if dropped
  */
-void UART1_SendChar(char c);
+uint8_t UART1_SendChar(char c);
 
 /**
- * @brief Send a null-terminated string over UART1.
+ * @brief Queue a null-terminated string (see UART1_Write).
  * @param s Pointer to the string
+ * @return  Number of bytes queued (0 if dropped)
+ */
+uint16_t UART1_SendString(const char *s);
+
+/**
+ * @brief UART1 interrupt handler: idle line and overrun.
+ */
+void USART1_IRQHandler(void);
+
+/**
+ * @brief DMA1 channel 5 interrupt handler: receive buffer half / completely filled.
  */
-void UART1_SendString(const char *s);
+void DMA1_Channel5_IRQHandler(void);
 
 /**
- * @brief UART1 interrupt handler for receiving data.
+ * @brief DMA1 channel 4 interrupt handler: transmit segment done, start the next one.
  */
-void UART_IRQHandler(void);
+void DMA1_Channel4_IRQHandler(void);
 
 /**
  * @brief Receive a single character (blocking mode).
@@ -8,10 +8,75 @@
  * Include files
  */
 #include <can.h>           // Include CAN header for function declarations
-#include <can_buffer.h>    // Include CAN buffer to access shared variables
+#include <can_buffer.h>    // Received frames are queued for the main loop
+#include "timebase.h"      // Reception time of a frame
+#include "clock.h"         // APB1 clock for the bit timing
+#include "uart.h"          // UART_FLOW_CONTROL decides the CAN pins
+
+#define CAN_DEFAULT_BITRATE 500000   // Bit rate used until another one is configured
+
+// Current bus settings (kept so they can be saved to flash)
+static uint32_t can_bitrate = CAN_DEFAULT_BITRATE;
+static uint32_t can_filter_id = 0;      // Filter ID (0 with mask 0 = accept all)
+static uint32_t can_filter_mask = 0;
+static uint8_t can_filter_ext = 0;      // 1 = filter matches extended IDs only
+
+// Calculate BTR for a bit rate from the APB1 clock: largest quanta count in 8..25, ~87.5% sample point
+static uint32_t CAN_CalcBTR(uint32_t bitrate) {
+    uint32_t pclk1 = Clock_PCLK1();
+    if (bitrate == 0) return 0;
+
+    for (uint32_t tq = 25; tq >= 8; tq--) {
+        if (pclk1 % (bitrate * tq)) continue;                   // Bit rate must be exact
+        uint32_t brp = pclk1 / (bitrate * tq);
+        if (brp == 0 || brp > 1024) continue;
+
+        uint32_t ts2 = (tq + 4) / 8;                            // Phase segment 2 = 12.5% of the bit
+        uint32_t ts1 = tq - 1 - ts2;                            // Sync segment takes 1 quantum
+        if (ts1 > 16) continue;
+        return ((ts2 - 1) << 20) | ((ts1 - 1) << 16) | (brp - 1);   // SJW = 1
+    }
+    return 0;
+}
+
+// Write filter 0 from the stored settings (filter init mode must not be active)
+static void CAN_WriteFilter(void) {
+    uint32_t fr1, fr2;
+    if (can_filter_ext) {
+        fr1 = (can_filter_id << 3) | (1 << 2);                  // Extended ID + IDE
+        fr2 = (can_filter_mask << 3) | (1 << 2);                // Match IDE too
+    } else {
+        fr1 = can_filter_id << 21;                              // Standard ID
+        fr2 = (can_filter_mask << 21) | (can_filter_mask ? (1 << 2) : 0);  // Match IDE unless accept-all
+    }
 
-// === Initialize GPIO pins for CAN (PA11 - RX, PA12 - TX) ===
+    CAN1->FMR |= CAN_FMR_FINIT;                // Enter filter init mode
+    CAN1->FA1R &= ~(1 << 0);                   // Deactivate filter 0 while changing it
+    CAN1->FS1R |= (1 << 0);                    // Set filter 0 to 32-bit mode
+    CAN1->FM1R &= ~(1 << 0);                   // Set filter 0 to mask mode
+    CAN1->sFilterRegister[0].FR1 = fr1;        // Filter ID
+    CAN1->sFilterRegister[0].FR2 = fr2;        // Filter mask
+    CAN1->FA1R |= (1 << 0);                    // Activate filter 0
+    CAN1->FMR &= ~CAN_FMR_FINIT;               // Exit filter init mode
+}
+
+// === Initialize GPIO pins for CAN (PA11 - RX, PA12 - TX, or PB8 / PB9 with UART flow control) ===
 void CAN_GPIO_Init(void) {
+#if UART_FLOW_CONTROL
+    // PA11 / PA12 carry USART1 CTS / RTS, so use the CAN remap to PB8 / PB9
+    RCC->APB2ENR |= RCC_APB2ENR_IOPBEN | RCC_APB2ENR_AFIOEN;  // Enable clock for GPIOB and AFIO
+    AFIO->MAPR = (AFIO->MAPR & ~AFIO_MAPR_CAN_REMAP) | AFIO_MAPR_CAN_REMAP_REMAP2;
+
+    // Configure PB8 (CAN_RX) as input with pull-up
+    GPIOB->CRH &= ~(GPIO_CRH_MODE8 | GPIO_CRH_CNF8);
+    GPIOB->CRH |= (0b10 << GPIO_CRH_CNF8_Pos);
+    GPIOB->ODR |= (1 << 8);
+
+    // Configure PB9 (CAN_TX) as alternate function push-pull output
+    GPIOB->CRH &= ~(GPIO_CRH_MODE9 | GPIO_CRH_CNF9);
+    GPIOB->CRH |= (0b10 << GPIO_CRH_MODE9_Pos)
+                | (0b10 << GPIO_CRH_CNF9_Pos);
+#else
     RCC->APB2ENR |= RCC_APB2ENR_IOPAEN | RCC_APB2ENR_AFIOEN;  // Enable clock for GPIOA and AFIO
     AFIO->MAPR &= ~AFIO_MAPR_CAN_REMAP;  // Use default CAN pin mapping (PA11, PA12)
 
@@ -24,6 +89,7 @@ void CAN_GPIO_Init(void) {
     GPIOA->CRH &= ~(GPIO_CRH_MODE12 | GPIO_CRH_CNF12);              // Clear mode and config bits
     GPIOA->CRH |= (0b10 << GPIO_CRH_MODE12_Pos)                     // Output mode, 2 MHz
                 | (0b10 << GPIO_CRH_CNF12_Pos);                     // Alternate function push-pull
+#endif
 }
 
 // === Configure CAN in normal mode ===
@@ -34,20 +100,11 @@ void CAN_Config(void) {
     while (!(CAN1->MSR & CAN_MSR_INAK)); // Wait until initialization mode is acknowledged
     CAN1->MCR &= ~CAN_MCR_SLEEP;         // Exit sleep mode
 
-    // Set CAN bit timing (prescaler, segment1, segment2) for 500kbps or as needed
-    CAN1->BTR = (0b00 << 24)       // Normal mode (no loopback or silent)
-              | (0 << 20)          // SJW = 1
-              | (5 << 16)          // TS1 = 6
-              | (1);               // TS2 = 2, Prescaler = 1 (divide clock accordingly)
+    // Set CAN bit timing (prescaler, segment1, segment2) from the APB1 clock, normal mode
+    CAN1->BTR = CAN_CalcBTR(can_bitrate);
 
-    // === Configure filter to accept all messages ===
-    CAN1->FMR |= CAN_FMR_FINIT;                // Enter filter init mode
-    CAN1->FA1R |= (1 << 0);                    // Activate filter 0
-    CAN1->FS1R |= (1 << 0);                    // Set filter 0 to 32-bit mode
-    CAN1->FM1R &= ~(1 << 0);                   // Set filter 0 to mask mode
-    CAN1->sFilterRegister[0].FR1 = 0;          // Filter ID = 0
-    CAN1->sFilterRegister[0].FR2 = 0;          // Filter mask = 0 (accept all)
-    CAN1->FMR &= ~CAN_FMR_FINIT;               // Exit filter init mode
+    // === Configure filter (accepts all messages by default) ===
+    CAN_WriteFilter();
 
     CAN1->MCR &= ~CAN_MCR_INRQ;                // Leave initialization mode
 
@@ -59,33 +116,89 @@ void CAN_Config(void) {
     while (CAN1->MSR & CAN_MSR_INAK);          // Wait until initialization mode is exited
 }
 
+// === Change the bus bit rate ===
+// Rewrite BTR (bit timing and silent mode), which only changes in init mode
+static void CAN_WriteBTR(uint32_t btr) {
+    CAN1->MCR |= CAN_MCR_INRQ;
+    while (!(CAN1->MSR & CAN_MSR_INAK));
+    CAN1->BTR = btr;
+    CAN1->MCR &= ~CAN_MCR_INRQ;
+    while (CAN1->MSR & CAN_MSR_INAK);
+}
+
+uint8_t CAN_SetBitrate(uint32_t bitrate) {
+    uint32_t btr = CAN_CalcBTR(bitrate);
+    if (btr == 0) return 0;                    // Not reachable from the current clock
+
+    CAN_WriteBTR(btr | (CAN1->BTR & CAN_BTR_SILM));
+    can_bitrate = bitrate;
+    return 1;
+}
+
+// === Listen-only (silent) mode ===
+void CAN_SetSilent(uint8_t silent) {
+    if (silent) {
+        // A silent node cannot transmit: drop what is still waiting for the bus
+        CAN1->TSR = CAN_TSR_ABRQ0 | CAN_TSR_ABRQ1 | CAN_TSR_ABRQ2;
+        CAN_WriteBTR(CAN1->BTR | CAN_BTR_SILM);
+    } else {
+        CAN_WriteBTR(CAN1->BTR & ~CAN_BTR_SILM);
+    }
+}
+
+// === Change the acceptance filter ===
+void CAN_SetFilter(uint32_t id, uint32_t mask, uint8_t is_extended) {
+    can_filter_id = id;
+    can_filter_mask = mask;
+    can_filter_ext = is_extended ? 1 : 0;
+    CAN_WriteFilter();
+}
+
+// === Read back current settings ===
+uint32_t CAN_GetBitrate(void) {
+    return can_bitrate;
+}
+
+void CAN_GetFilter(uint32_t *id, uint32_t *mask, uint8_t *is_extended) {
+    *id = can_filter_id;
+    *mask = can_filter_mask;
+    *is_extended = can_filter_ext;
+}
+
+// Wait for an empty TX mailbox and return its number; all three are used so
+// back-to-back cyclic frames do not wait for each other to leave the bus
+static uint8_t CAN_FreeMailbox(void) {
+    while ((CAN1->TSR & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)) == 0);
+    return (uint8_t)((CAN1->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos);   // Hardware picks the free one
+}
+
 // === Send CAN frame with standard ID ===
 void CAN_Send_STD(uint16_t std_id, uint8_t *data, uint8_t len) {
-    while ((CAN1->TSR & CAN_TSR_TME0) == 0);   // Wait until TX mailbox 0 is empty
+    uint8_t mb = CAN_FreeMailbox();            // Wait for any empty TX mailbox
 
-    CAN1->sTxMailBox[0].TIR = (std_id << 21);  // Set standard ID in TIR (bits 21–31)
-    CAN1->sTxMailBox[0].TDTR = len & 0xF;      // Set data length (0–8 bytes)
+    CAN1->sTxMailBox[mb].TIR = (std_id << 21); // Set standard ID in TIR (bits 21–31)
+    CAN1->sTxMailBox[mb].TDTR = len & 0xF;     // Set data length (0–8 bytes)
 
     // Write data to lower and higher data registers
-    CAN1->sTxMailBox[0].TDLR = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
-    CAN1->sTxMailBox[0].TDHR = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
+    CAN1->sTxMailBox[mb].TDLR = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+    CAN1->sTxMailBox[mb].TDHR = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
 
-    CAN1->sTxMailBox[0].TIR |= CAN_TI0R_TXRQ;  // Request transmission
+    CAN1->sTxMailBox[mb].TIR |= CAN_TI0R_TXRQ; // Request transmission
 }
 
 // === Send CAN frame with extended ID ===
 void CAN_Send_EXT(uint32_t ext_id, uint8_t *data, uint8_t len) {
-    while ((CAN1->TSR & CAN_TSR_TME0) == 0);   // Wait until TX mailbox 0 is empty
+    uint8_t mb = CAN_FreeMailbox();            // Wait for any empty TX mailbox
 
     // Set extended ID and IDE bit (bit 2 = 1 for extended)
-    CAN1->sTxMailBox[0].TIR = (ext_id << 3) | (1 << 2);
-    CAN1->sTxMailBox[0].TDTR = len & 0xF;      // Set data length
+    CAN1->sTxMailBox[mb].TIR = (ext_id << 3) | (1 << 2);
+    CAN1->sTxMailBox[mb].TDTR = len & 0xF;     // Set data length
 
     // Load data into data registers
-    CAN1->sTxMailBox[0].TDLR = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
-    CAN1->sTxMailBox[0].TDHR = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
+    CAN1->sTxMailBox[mb].TDLR = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+    CAN1->sTxMailBox[mb].TDHR = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
 
-    CAN1->sTxMailBox[0].TIR |= CAN_TI0R_TXRQ;  // Request transmission
+    CAN1->sTxMailBox[mb].TIR |= CAN_TI0R_TXRQ; // Request transmission
 }
 
 // === Receive CAN message (polling method) ===
@@ -116,25 +229,30 @@ uint8_t CAN_Receive(uint8_t *data_out, uint32_t *id_out, uint8_t *is_extended) {
 }
 
 // === CAN1 RX0 interrupt handler ===
+// Queues the frame with its reception time; the main loop forwards it when the UART has room
 void CAN1_RX0_IRQHandler(void) {
-    if ((CAN1->RF0R & 0x03) == 0) return;  // No message pending
+    uint32_t rf0r = CAN1->RF0R;
+    if ((rf0r & 0x03) == 0) return;  // No message pending
+    if (rf0r & CAN_RF0R_FOVR0) CAN_Buffer_Overrun();   // A frame arrived to a full FIFO (cleared below)
 
+    CanFrame f;
+    f.time = Timebase_Now();
     uint32_t rir = CAN1->sFIFOMailBox[0].RIR;  // Read identifier register
-    is_ext = (rir & (1 << 2)) ? 1 : 0;         // Determine if extended ID
-    rx_id = is_ext ? ((rir >> 3) & 0x1FFFFFFF) // Extract extended ID
-                   : ((rir >> 21) & 0x7FF);    // Extract standard ID
+    f.is_ext = (rir & (1 << 2)) ? 1 : 0;       // Determine if extended ID
+    f.id = f.is_ext ? ((rir >> 3) & 0x1FFFFFFF) // Extract extended ID
+                    : ((rir >> 21) & 0x7FF);    // Extract standard ID
 
-    rx_len = CAN1->sFIFOMailBox[0].RDTR & 0xF; // Read data length
+    f.len = CAN1->sFIFOMailBox[0].RDTR & 0xF;  // Read data length
     uint32_t dlr = CAN1->sFIFOMailBox[0].RDLR; // Lower data
     uint32_t dhr = CAN1->sFIFOMailBox[0].RDHR; // Higher data
 
-    // Copy received data into rx_data buffer
-    for (int i = 0; i < 4 && i < rx_len; i++) rx_data[i] = (dlr >> (8 * i)) & 0xFF;
-    for (int i = 4; i < 8 && i < rx_len; i++) rx_data[i] = (dhr >> (8 * (i - 4))) & 0xFF;
+    // Copy received data into the frame
+    for (int i = 0; i < 4 && i < f.len; i++) f.data[i] = (dlr >> (8 * i)) & 0xFF;
+    for (int i = 4; i < 8 && i < f.len; i++) f.data[i] = (dhr >> (8 * (i - 4))) & 0xFF;
 
-    CAN1->RF0R |= CAN_RF0R_RFOM0;   // Release FIFO 0 output mailbox
+    CAN1->RF0R |= CAN_RF0R_RFOM0;   // Release FIFO 0 output mailbox (also clears FOVR0 and FULL0)
 
-    can_rx_flag = 1;  // Set flag to indicate a message has been received
+    CAN_Buffer_Push(&f);            // Queue it, or lose a frame as the overflow policy says
 }
 
 /*
@@ -8,22 +8,173 @@
 /*
  * Include file
  */
-#include "can_buffer.h"  // Include header file that declares shared CAN buffer variables
+#include "can_buffer.h"     // Queue of received frames and loss counters
+#include "stm32f1xx.h"      // NVIC, CAN1 RX0 interrupt number
+#include <string.h>         // For memset
 
-// Global flag indicating if a new CAN frame has been received (set in interrupt handler)
-volatile uint8_t can_rx_flag = 0;
+#ifndef CAN_BUFFER_POLICY
+#define CAN_BUFFER_POLICY CAN_BUF_LATEST    // Policy after reset
+#endif
 
-// Buffer to store received CAN data (up to 8 bytes for both standard and extended frames)
-uint8_t rx_data[8];
+_Static_assert(CAN_BUFFER_DEPTH >= 2 && CAN_BUFFER_DEPTH <= 255, "CAN_BUFFER_DEPTH must be 2-255");
+_Static_assert(CAN_BUFFER_LOSS_IDS >= 1 && CAN_BUFFER_LOSS_IDS <= 255, "CAN_BUFFER_LOSS_IDS must be 1-255");
 
-// Variable to store received CAN identifier (either standard or extended)
-uint32_t rx_id;
+// Key of a frame in the loss table and the LATEST lookup
+#define BUF_KEY(f) ((f)->id | ((f)->is_ext ? CAN_BUF_EXT : 0))
 
-// Flag indicating if the received ID is an extended ID (1) or a standard ID (0)
-uint8_t is_ext;
+// Queue; the interrupt adds at the end and, when full, may drop at the front, so
+// the main loop only touches it with the interrupt disabled
+static CanFrame buf_q[CAN_BUFFER_DEPTH];
+static uint8_t buf_head = 0;                // Oldest frame
+static volatile uint8_t buf_count = 0;
+static uint8_t buf_peak = 0;
+static uint8_t buf_policy = CAN_BUFFER_POLICY;
 
-// Length of the received CAN data (0 to 8 bytes)
-uint8_t rx_len;
+// Loss counters; the last entry counts every ID that found the table full
+static CanLoss buf_loss[CAN_BUFFER_LOSS_IDS + 1] = { [CAN_BUFFER_LOSS_IDS] = { CAN_BUF_OTHER_IDS, 0 } };
+static uint8_t buf_loss_changed[CAN_BUFFER_LOSS_IDS + 1];   // Changed since CAN_Buffer_Losses
+static uint8_t buf_loss_used = 0;
+static uint8_t buf_loss_next = 0;                           // Where CAN_Buffer_Losses goes on
+static uint32_t buf_received = 0;
+static uint32_t buf_lost = 0;
+static uint32_t buf_overrun = 0;
+
+// Keep the receive interrupt out while the main loop works on the queue
+static void CAN_Buffer_Lock(void) {
+    NVIC_DisableIRQ(USB_LP_CAN1_RX0_IRQn);
+    __DSB();
+    __ISB();
+}
+
+static void CAN_Buffer_Unlock(void) {
+    NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+}
+
+// Next queue position
+static uint8_t CAN_Buffer_Next(uint8_t i) {
+    return (uint8_t)(i + 1 == CAN_BUFFER_DEPTH ? 0 : i + 1);
+}
+
+// Count a lost frame against its ID
+static void CAN_Buffer_Lose(const CanFrame *f) {
+    uint32_t key = BUF_KEY(f);
+    uint8_t i;
+
+    buf_lost++;
+    for (i = 0; i < buf_loss_used && buf_loss[i].id != key; i++);
+    if (i == buf_loss_used) {
+        if (buf_loss_used < CAN_BUFFER_LOSS_IDS) {
+            buf_loss[i].id = key;
+            buf_loss_used++;
+        } else {
+            i = CAN_BUFFER_LOSS_IDS;
+        }
+    }
+    buf_loss[i].lost++;
+    buf_loss_changed[i] = 1;
+}
+
+// === Queue a received frame ===
+void CAN_Buffer_Push(const CanFrame *f) {
+    uint8_t i, n;
+
+    buf_received++;
+    if (buf_count == CAN_BUFFER_DEPTH) {
+        if (buf_policy == CAN_BUF_DROP_NEWEST) {
+            CAN_Buffer_Lose(f);
+            return;
+        }
+        if (buf_policy == CAN_BUF_LATEST) {
+            // Newest queued frame of the ID, so the frames of one ID stay in order
+            uint32_t key = BUF_KEY(f);
+            for (n = CAN_BUFFER_DEPTH; n; n--) {
+                i = (uint8_t)((buf_head + n - 1) % CAN_BUFFER_DEPTH);
+                if (BUF_KEY(&buf_q[i]) == key) {
+                    CAN_Buffer_Lose(&buf_q[i]);
+                    buf_q[i] = *f;
+                    return;
+                }
+            }
+        }
+        CAN_Buffer_Lose(&buf_q[buf_head]);
+        buf_head = CAN_Buffer_Next(buf_head);
+        buf_count--;
+    }
+    buf_q[(buf_head + buf_count) % CAN_BUFFER_DEPTH] = *f;
+    buf_count++;
+    if (buf_count > buf_peak) buf_peak = buf_count;
+}
+
+// === Count a controller FIFO overrun ===
+void CAN_Buffer_Overrun(void) {
+    buf_overrun++;
+}
+
+// === Take the oldest queued frame ===
+uint8_t CAN_Buffer_Pop(CanFrame *out) {
+    uint8_t got = 0;
+
+    if (!buf_count) return 0;
+    CAN_Buffer_Lock();
+    if (buf_count) {
+        *out = buf_q[buf_head];
+        buf_head = CAN_Buffer_Next(buf_head);
+        buf_count--;
+        got = 1;
+    }
+    CAN_Buffer_Unlock();
+    return got;
+}
+
+// === Select the overflow policy and clear the counters ===
+uint8_t CAN_Buffer_SetPolicy(uint8_t policy) {
+    if (policy > CAN_BUF_LATEST) return 0;
+    CAN_Buffer_Lock();
+    buf_policy = policy;
+    memset(buf_loss, 0, sizeof(buf_loss));
+    memset(buf_loss_changed, 0, sizeof(buf_loss_changed));
+    buf_loss[CAN_BUFFER_LOSS_IDS].id = CAN_BUF_OTHER_IDS;
+    buf_loss_used = 0;
+    buf_received = 0;
+    buf_lost = 0;
+    buf_overrun = 0;
+    buf_peak = buf_count;
+    CAN_Buffer_Unlock();
+    return 1;
+}
+
+// === Read the totals ===
+void CAN_Buffer_Stats(CanBufferStats *out) {
+    CAN_Buffer_Lock();
+    out->received = buf_received;
+    out->lost = buf_lost;
+    out->overrun = buf_overrun;
+    out->peak = buf_peak;
+    out->policy = buf_policy;
+    buf_peak = buf_count;
+    CAN_Buffer_Unlock();
+}
+
+// === Read the loss counters that changed ===
+uint8_t CAN_Buffer_Losses(CanLoss *out, uint8_t max) {
+    uint8_t n = 0;
+
+    CAN_Buffer_Lock();
+    for (uint16_t k = 0; k <= CAN_BUFFER_LOSS_IDS && n < max; k++) {
+        uint8_t i = buf_loss_next;
+        buf_loss_next = (uint8_t)(i == CAN_BUFFER_LOSS_IDS ? 0 : i + 1);
+        if (!buf_loss_changed[i]) continue;
+        buf_loss_changed[i] = 0;
+        out[n++] = buf_loss[i];
+    }
+    CAN_Buffer_Unlock();
+    return n;
+}
+
+// === Frames lost so far ===
+uint32_t CAN_Buffer_Lost(void) {
+    return buf_lost + buf_overrun;
+}
 /*
  * End of file
  */
@@ -10,23 +10,413 @@
 
 #include "can_cyclic.h"   // Header for this module
 #include "can.h"          // Provides CAN_Send_STD / CAN_Send_EXT
+#include "crc.h"          // CRC8 tables for E2E checksums
+#include "signal_gen.h"   // Waveform generators for simulated signals
+#include "timebase.h"     // Microsecond clock and scheduler alarm
 #include <string.h>       // For memcpy
-#define MAX_CYCLIC_MSGS 10  // Maximum number of cyclic messages we can store
-// Structure to hold each cyclic message entry
+#define MAX_CYCLIC_MSGS CAN_CYCLIC_CAPACITY       // Message slots (active + staged)
+#define MAX_CYCLIC_EXTS CAN_CYCLIC_EXT_CAPACITY   // Counter / checksum / mode records
+#define MAX_CYCLIC_GENS CAN_CYCLIC_GEN_CAPACITY   // Signal generators shared by all messages
+#define MAX_CYCLIC_GROUP CAN_CYCLIC_GROUP_CAPACITY // Payloads staged by one group update
+#define CYCLIC_MIN_INTERVAL_US 50   // Shortest interval, about one frame at 1 Mbit/s
+#define CYCLIC_NONE 0xFFFF          // No slot
+
+// Slot states
+#define SLOT_FREE   0       // Slot can be allocated
+#define SLOT_ACTIVE 1       // Slot is scheduled
+#define SLOT_STAGED 2       // Slot belongs to a bulk-loaded table waiting to be swapped in
+
+// Per-slot flag bits
+#define F_STATE     0x03    // SLOT_xxx
+#define F_MODE      0x0C    // CYCLIC_MODE_xxx << F_MODE_POS
+#define F_MODE_POS  2
+#define F_CHANGED   0x10    // An on-change payload is waiting to be sent
+#define F_EXT       0x20    // Slot owns a CyclicExt record
+#define F_GEN       0x40    // At least one generator drives this slot
+#define F_MODEL_EXT 0x80    // Extended (29-bit) identifier
+
+// Optional per-message settings, only allocated for messages that use them
 typedef struct {
-    uint8_t in_use;         // 1 if slot is used, 0 if free
-    uint8_t model;          // 0 = Standard ID, 1 = Extended ID
-    uint32_t id;            // CAN ID
-    uint8_t data[8];        // Data payload (up to 8 bytes)
-    uint8_t len;            // Actual data length
-    uint16_t interval;      // Repeat interval in milliseconds (cyclic)
-    uint16_t counter;       // Counts 10ms ticks to trigger sending
-} CyclicMsg;
-// Static array to hold all active cyclic messages
-static CyclicMsg msgs[MAX_CYCLIC_MSGS];
-// Add a new cyclic message or update an existing one by ID
-void CAN_Cyclic_AddOrUpdate(uint8_t model, uint32_t id, uint8_t *data, uint8_t len, uint16_t cyclic_ms) {
-    if (cyclic_ms == 0) {
+    uint32_t last_tx;       // Timebase_Now() value of the last transmission
+    uint16_t owner;         // Slot + 1, 0 = record is free
+    uint16_t data_id;       // E2E Data ID mixed into the checksum
+    uint16_t shots;         // Burst length (CYCLIC_MODE_BURST)
+    uint16_t remaining;     // Transmissions left in the current burst
+    uint16_t min_ms;        // Minimum time between on-change transmissions
+    uint8_t ctr_start;      // Start bit of the rolling counter (Intel bit numbering)
+    uint8_t ctr_len;        // Rolling counter width in bits (0 = no counter)
+    uint8_t ctr_max;        // Counter wraps to 0 after this value
+    uint8_t ctr_value;      // Next counter value to transmit
+    uint8_t crc_type;       // CYCLIC_CRC_xxx
+    uint8_t crc_byte;       // Byte position of the checksum in the payload
+} CyclicExt;
+// Signal generator bound to a bit field of one cyclic message
+typedef struct {
+    uint8_t in_use;         // 1 if generator is active
+    uint8_t start_bit;      // Start bit of the signal (Intel bit numbering)
+    uint16_t slot;          // Index of the owning message
+    uint8_t bit_len;        // Signal width in bits (1–16)
+    uint16_t period_ms;     // Waveform period
+    SigGen gen;             // Generator state
+} CyclicGen;
+// Payload staged by a group update, applied together with the rest of the group
+typedef struct {
+    uint32_t id;            // CAN ID the payload was staged for
+    uint16_t slot;          // Slot that held the ID when it was staged
+    uint8_t len;            // New data length
+    uint8_t data[8];        // New payload
+} CyclicStaged;
+
+// Message table as a struct of arrays. The scheduler only walks the deadline
+// heap; payload and settings are touched when a message is actually sent.
+static struct {
+    // Hot: binary min-heap of deadlines, root = next message due
+    uint32_t heap_due[MAX_CYCLIC_MSGS];   // Deadline (Timebase_Now() time) of each heap entry
+    uint16_t heap_slot[MAX_CYCLIC_MSGS];  // Message slot of each heap entry
+    uint16_t heap_pos[MAX_CYCLIC_MSGS];   // Heap index + 1 of each slot, 0 = not scheduled
+    // Cold: one entry per slot
+    uint32_t interval[MAX_CYCLIC_MSGS];   // Repeat interval in microseconds
+    uint32_t id[MAX_CYCLIC_MSGS];         // CAN ID
+    uint8_t data[MAX_CYCLIC_MSGS][8];     // Data payload (up to 8 bytes)
+    uint8_t len[MAX_CYCLIC_MSGS];         // Actual data length
+    uint8_t flags[MAX_CYCLIC_MSGS];       // F_xxx
+    // Shared pools
+    CyclicExt ext[MAX_CYCLIC_EXTS];
+    CyclicGen gens[MAX_CYCLIC_GENS];
+    CyclicStaged group[MAX_CYCLIC_GROUP];
+} tab;
+static uint16_t heap_len = 0;             // Number of scheduled slots
+// Set when a staged table must replace the active one at the next pass
+static volatile uint8_t bulk_commit_pending = 0;
+static uint8_t group_len = 0;             // Payloads staged in tab.group
+// Set when the staged group must be applied at the next pass
+static volatile uint8_t group_commit_pending = 0;
+static uint8_t cyc_paused = 0;            // No transmissions until CAN_Cyclic_Resume
+static uint32_t cyc_paused_at;            // Timebase_Now() when the pause began
+
+_Static_assert(MAX_CYCLIC_MSGS < CYCLIC_NONE, "CAN_CYCLIC_CAPACITY must be below 65535");
+_Static_assert(sizeof(tab) <= CAN_CYCLIC_RAM_BUDGET,
+               "Cyclic table uses more RAM than CAN_CYCLIC_RAM_BUDGET "
+               "(26 bytes per message, 20 per extension record, 24 per generator, 16 per group entry)");
+
+static uint8_t Cyclic_State(uint16_t slot) {
+    return tab.flags[slot] & F_STATE;
+}
+
+static uint8_t Cyclic_Mode(uint16_t slot) {
+    return (tab.flags[slot] & F_MODE) >> F_MODE_POS;
+}
+
+// Find the slot holding a given ID, or CYCLIC_NONE if there is none
+static uint16_t Cyclic_Find(uint32_t id) {
+    for (uint16_t i = 0; i < MAX_CYCLIC_MSGS; i++) {
+        if (tab.id[i] == id && Cyclic_State(i) == SLOT_ACTIVE) return i;
+    }
+    return CYCLIC_NONE;
+}
+
+// First free slot, or CYCLIC_NONE if the table is full
+static uint16_t Cyclic_Alloc(void) {
+    for (uint16_t i = 0; i < MAX_CYCLIC_MSGS; i++) {
+        if (Cyclic_State(i) == SLOT_FREE) return i;
+    }
+    return CYCLIC_NONE;
+}
+
+// Extension record of a slot, NULL if it has none
+static CyclicExt *Cyclic_Ext(uint16_t slot) {
+    if (!(tab.flags[slot] & F_EXT)) return 0;
+    for (int i = 0; i < MAX_CYCLIC_EXTS; i++) {
+        if (tab.ext[i].owner == slot + 1) return &tab.ext[i];
+    }
+    return 0;
+}
+
+// Extension record of a slot, allocating a zeroed one if needed; NULL if the pool is exhausted.
+// last_tx only matters in CYCLIC_MODE_ON_CHANGE_MINMAX, which sets it
+static CyclicExt *Cyclic_ExtAlloc(uint16_t slot) {
+    CyclicExt *x = Cyclic_Ext(slot);
+    if (x) return x;
+    for (int i = 0; i < MAX_CYCLIC_EXTS; i++) {
+        if (tab.ext[i].owner == 0) {
+            x = &tab.ext[i];
+            memset(x, 0, sizeof(*x));
+            x->owner = slot + 1;
+            tab.flags[slot] |= F_EXT;
+            return x;
+        }
+    }
+    return 0;
+}
+
+// === Deadline heap ===
+
+// Store a heap entry and remember where its slot went
+static void Heap_Place(uint16_t i, uint32_t due, uint16_t slot) {
+    tab.heap_due[i] = due;
+    tab.heap_slot[i] = slot;
+    tab.heap_pos[slot] = i + 1;
+}
+
+// Move an entry towards the root while it is due before its parent (wrap-safe)
+static void Heap_Up(uint16_t i) {
+    uint32_t due = tab.heap_due[i];
+    uint16_t slot = tab.heap_slot[i];
+    while (i > 0) {
+        uint16_t parent = (i - 1) / 2;
+        if ((int32_t)(due - tab.heap_due[parent]) >= 0) break;
+        Heap_Place(i, tab.heap_due[parent], tab.heap_slot[parent]);
+        i = parent;
+    }
+    Heap_Place(i, due, slot);
+}
+
+// Move an entry towards the leaves while a child is due before it
+static void Heap_Down(uint16_t i) {
+    uint32_t due = tab.heap_due[i];
+    uint16_t slot = tab.heap_slot[i];
+    for (;;) {
+        uint32_t child = 2u * i + 1;
+        if (child >= heap_len) break;
+        if (child + 1 < heap_len && (int32_t)(tab.heap_due[child + 1] - tab.heap_due[child]) < 0) child++;
+        if ((int32_t)(tab.heap_due[child] - due) >= 0) break;
+        Heap_Place(i, tab.heap_due[child], tab.heap_slot[child]);
+        i = (uint16_t)child;
+    }
+    Heap_Place(i, due, slot);
+}
+
+// Schedule a slot at an absolute time, inserting or moving its heap entry
+static void Cyclic_Schedule(uint16_t slot, uint32_t due) {
+    if (tab.heap_pos[slot] == 0) {
+        Heap_Place(heap_len, due, slot);
+        Heap_Up(heap_len++);
+        return;
+    }
+    uint16_t i = tab.heap_pos[slot] - 1;
+    int32_t earlier = (int32_t)(due - tab.heap_due[i]) < 0;
+    tab.heap_due[i] = due;
+    if (earlier) Heap_Up(i); else Heap_Down(i);
+}
+
+// Take a slot out of the heap
+static void Cyclic_Unschedule(uint16_t slot) {
+    if (tab.heap_pos[slot] == 0) return;
+    uint16_t i = tab.heap_pos[slot] - 1;
+    tab.heap_pos[slot] = 0;
+    if (i == --heap_len) return;
+    Heap_Place(i, tab.heap_due[heap_len], tab.heap_slot[heap_len]);   // Last entry fills the hole
+    Heap_Up(i);
+    Heap_Down(i);
+}
+
+// Write a bit field (up to 32 bits) into the payload, Intel bit order
+static void Cyclic_WriteBits(uint8_t *data, uint8_t start, uint8_t len, uint32_t value) {
+    while (len) {
+        uint8_t shift = start & 7;                       // Bit offset inside current byte
+        uint8_t n = 8 - shift;                           // Bits available in this byte
+        if (n > len) n = len;
+        uint8_t mask = (uint8_t)(((1u << n) - 1) << shift);
+        data[start >> 3] = (data[start >> 3] & ~mask) | ((value << shift) & mask);
+        value >>= n;
+        start += n;
+        len -= n;
+    }
+}
+
+// Compute the configured checksum over the payload (checksum byte excluded)
+static uint8_t Cyclic_Checksum(const uint8_t *d, uint8_t len, const CyclicExt *x) {
+    uint8_t pos = x->crc_byte;
+    uint8_t crc;
+
+    switch (x->crc_type) {
+    case CYCLIC_CRC_J1850:
+        // Plain SAE-J1850: init 0xFF, final XOR 0xFF
+        crc = CRC8_J1850_Update(0xFF, d, pos);
+        crc = CRC8_J1850_Update(crc, d + pos + 1, len - pos - 1);
+        return crc ^ 0xFF;
+    case CYCLIC_CRC_E2E_P1: {
+        // AUTOSAR E2E Profile 1: Data ID (low, high) then payload, init 0x00, no final XOR
+        uint8_t id[2] = { (uint8_t)x->data_id, (uint8_t)(x->data_id >> 8) };
+        crc = CRC8_J1850_Update(0x00, id, 2);
+        crc = CRC8_J1850_Update(crc, d, pos);
+        return CRC8_J1850_Update(crc, d + pos + 1, len - pos - 1);
+    }
+    case CYCLIC_CRC_E2E_P2: {
+        // AUTOSAR E2E Profile 2: payload then Data ID byte, CRC8H2F init 0xFF, final XOR 0xFF
+        uint8_t id = (uint8_t)x->data_id;
+        crc = CRC8_H2F_Update(0xFF, d, pos);
+        crc = CRC8_H2F_Update(crc, d + pos + 1, len - pos - 1);
+        crc = CRC8_H2F_Update(crc, &id, 1);
+        return crc ^ 0xFF;
+    }
+    default:
+        return d[pos];
+    }
+}
+
+// Recalculate generator phase steps after the message interval changed
+static void Cyclic_RetuneGens(uint16_t slot) {
+    if (!(tab.flags[slot] & F_GEN)) return;
+    for (int g = 0; g < MAX_CYCLIC_GENS; g++) {
+        CyclicGen *gen = &tab.gens[g];
+        if (gen->in_use && gen->slot == slot)
+            gen->gen.step = SigGen_PhaseStep(tab.interval[slot], gen->period_ms * 1000u);
+    }
+}
+
+// Free a message slot together with its heap entry, extension record and generators
+static void Cyclic_Release(uint16_t slot) {
+    CyclicExt *x = Cyclic_Ext(slot);
+    if (x) x->owner = 0;
+    if (tab.flags[slot] & F_GEN) {
+        for (int g = 0; g < MAX_CYCLIC_GENS; g++) {
+            if (tab.gens[g].slot == slot) tab.gens[g].in_use = 0;
+        }
+    }
+    Cyclic_Unschedule(slot);
+    tab.flags[slot] = SLOT_FREE;
+}
+
+// Apply generators, rolling counter and checksum right before the payload goes on the bus
+static void Cyclic_ApplyMutators(uint16_t slot, CyclicExt *x) {
+    uint8_t *d = tab.data[slot];
+    if (tab.flags[slot] & F_GEN) {
+        for (int g = 0; g < MAX_CYCLIC_GENS; g++) {
+            CyclicGen *gen = &tab.gens[g];
+            if (gen->in_use && gen->slot == slot)
+                Cyclic_WriteBits(d, gen->start_bit, gen->bit_len, SigGen_Next(&gen->gen));
+        }
+    }
+    if (!x) return;
+    if (x->ctr_len) {
+        Cyclic_WriteBits(d, x->ctr_start, x->ctr_len, x->ctr_value);
+        x->ctr_value = (x->ctr_value >= x->ctr_max) ? 0 : x->ctr_value + 1;
+    }
+    if (x->crc_type != CYCLIC_CRC_NONE && x->crc_byte < tab.len[slot]) {
+        d[x->crc_byte] = Cyclic_Checksum(d, tab.len[slot], x);
+    }
+}
+
+// Send a stored message and schedule the next transmission one interval after base;
+// finished bursts are retired
+static void Cyclic_Transmit(uint16_t slot, uint32_t now, uint32_t base) {
+    CyclicExt *x = Cyclic_Ext(slot);
+
+    if (cyc_paused) {
+        Cyclic_Schedule(slot, cyc_paused_at);             // Goes out first thing after the resume
+        return;
+    }
+    Cyclic_ApplyMutators(slot, x);
+    if (tab.flags[slot] & F_MODEL_EXT)
+        CAN_Send_EXT(tab.id[slot], tab.data[slot], tab.len[slot]);             // Send Extended ID
+    else
+        CAN_Send_STD((uint16_t)tab.id[slot], tab.data[slot], tab.len[slot]);   // Send Standard ID
+
+    tab.flags[slot] &= ~F_CHANGED;
+    if (x) x->last_tx = now;
+
+    switch (Cyclic_Mode(slot)) {
+    case CYCLIC_MODE_ON_CHANGE:
+        Cyclic_Unschedule(slot);                          // Not scheduled (held during a pause)
+        break;
+    case CYCLIC_MODE_BURST:
+        if (x && --x->remaining == 0) {
+            Cyclic_Release(slot);                         // Burst done, slot reclaimed
+            break;
+        }
+        /* fall through */
+    default:
+        Cyclic_Schedule(slot, base + tab.interval[slot]);
+        break;
+    }
+}
+
+// Store new payload; for on-change modes only mark it pending when it really differs
+static void Cyclic_StorePayload(uint16_t slot, uint8_t *data, uint8_t len) {
+    if (tab.len[slot] != len || memcmp(tab.data[slot], data, len) != 0) tab.flags[slot] |= F_CHANGED;
+    memcpy(tab.data[slot], data, len);
+    tab.len[slot] = len;
+}
+
+// Clamp an interval to what the scheduler can keep up with
+static uint32_t Cyclic_Interval(uint32_t interval_us) {
+    return (interval_us < CYCLIC_MIN_INTERVAL_US) ? CYCLIC_MIN_INTERVAL_US : interval_us;
+}
+
+// Initialize a free slot with a fresh periodic message (not scheduled yet)
+static void Cyclic_Fill(uint16_t slot, uint8_t state, uint8_t model, uint32_t id,
+                        uint8_t *data, uint8_t len, uint32_t interval_us) {
+    tab.id[slot] = id;                                    // Save CAN ID
+    memcpy(tab.data[slot], data, len);                    // Copy data
+    tab.len[slot] = len;                                  // Set length
+    tab.interval[slot] = Cyclic_Interval(interval_us);    // Set cyclic interval
+    tab.flags[slot] = state | (model ? F_MODEL_EXT : 0);  // Periodic, no counter / checksum / generator
+}
+
+// Swap the staged table in: free every active slot and activate the staged ones
+static void Cyclic_ApplyBulk(uint32_t now) {
+    heap_len = 0;                                         // Every active slot leaves the heap
+    for (uint16_t i = 0; i < MAX_CYCLIC_MSGS; i++) {
+        if (Cyclic_State(i) == SLOT_ACTIVE) {
+            tab.heap_pos[i] = 0;
+            Cyclic_Release(i);
+        } else if (Cyclic_State(i) == SLOT_STAGED) {
+            tab.flags[i] = (tab.flags[i] & ~F_STATE) | SLOT_ACTIVE;
+            Cyclic_Schedule(i, now + tab.interval[i]);    // First transmission one interval after the swap
+        }
+    }
+    bulk_commit_pending = 0;
+}
+
+// Send a changed on-change payload now, or once its inhibit time is over;
+// periodic and burst messages carry it in their next frame
+static void Cyclic_NotifyChange(uint16_t slot, uint32_t now) {
+    if (!(tab.flags[slot] & F_CHANGED)) return;
+    CyclicExt *x = Cyclic_Ext(slot);
+
+    switch (Cyclic_Mode(slot)) {
+    case CYCLIC_MODE_ON_CHANGE:
+        Cyclic_Transmit(slot, now, now);
+        break;
+    case CYCLIC_MODE_ON_CHANGE_MINMAX:
+        if (!x || now - x->last_tx >= x->min_ms * 1000u)
+            Cyclic_Transmit(slot, now, now);
+        else if (x->min_ms * 1000u < tab.interval[slot])
+            Cyclic_Schedule(slot, x->last_tx + x->min_ms * 1000u);   // Inhibited: released by the scheduler
+        break;
+    default:
+        break;
+    }
+}
+
+// Apply every staged group payload in the same pass, then send the on-change ones
+static void Cyclic_ApplyGroup(uint32_t now) {
+    for (uint8_t k = 0; k < group_len; k++) {
+        CyclicStaged *s = &tab.group[k];
+        if (Cyclic_State(s->slot) == SLOT_ACTIVE && tab.id[s->slot] == s->id)
+            Cyclic_StorePayload(s->slot, s->data, s->len);
+        else
+            s->slot = CYCLIC_NONE;                        // Message was removed meanwhile
+    }
+    for (uint8_t k = 0; k < group_len; k++) {
+        if (tab.group[k].slot != CYCLIC_NONE) Cyclic_NotifyChange(tab.group[k].slot, now);
+    }
+    group_len = 0;
+    group_commit_pending = 0;
+}
+
+// Add a new cyclic message or update an existing one by ID (interval in milliseconds)
+uint8_t CAN_Cyclic_AddOrUpdate(uint8_t model, uint32_t id, uint8_t *data, uint8_t len, uint16_t cyclic_ms) {
+    return CAN_Cyclic_AddOrUpdateUs(model, id, data, len, cyclic_ms * 1000u);
+}
+
+// Add a new cyclic message or update an existing one by ID (interval in microseconds)
+uint8_t CAN_Cyclic_AddOrUpdateUs(uint8_t model, uint32_t id, uint8_t *data, uint8_t len, uint32_t interval_us) {
+    uint32_t now = Timebase_Now();
+    uint16_t i = Cyclic_Find(id);
+
+    if (interval_us == 0) {
         // Gửi một lần
         if (model == 0)
             CAN_Send_STD((uint16_t)id, data, len);
@@ -34,63 +424,360 @@ void CAN_Cyclic_AddOrUpdate(uint8_t model, uint32_t id, uint8_t *data, uint8_t l
             CAN_Send_EXT(id, data, len);
 
         // Nếu đã tồn tại message cùng ID -> xóa đi để tránh giữ lại
-        for (int i = 0; i < MAX_CYCLIC_MSGS; i++) {
-            if (msgs[i].in_use && msgs[i].id == id) {
-                msgs[i].in_use = 0;  // Giải phóng slot
-                break;
-            }
-        }
-        return;
+        if (i != CYCLIC_NONE) Cyclic_Release(i);   // Giải phóng slot
+        return 1;
     }
-    // First pass: Check if message with same ID already exists
-    for (int i = 0; i < MAX_CYCLIC_MSGS; i++) {
-        if (msgs[i].in_use && msgs[i].id == id) {
-            // Update existing message
-            memcpy(msgs[i].data, data, len);     // Copy new data
-            msgs[i].len = len;                   // Update length
-            msgs[i].interval = cyclic_ms;        // Update cyclic interval
-            msgs[i].counter = 0;                 // Reset timer
-            if (model == 0)
-                CAN_Send_STD((uint16_t)id, data, len);
-            else
-                CAN_Send_EXT(id, data, len);
-            return;                              // Done
+    if (i != CYCLIC_NONE) {
+        // Update existing message
+        CyclicExt *x = Cyclic_Ext(i);
+        Cyclic_StorePayload(i, data, len);              // Copy new data and length
+        tab.interval[i] = Cyclic_Interval(interval_us); // Update cyclic interval
+        Cyclic_RetuneGens(i);                           // Keep waveform periods in real time
+
+        switch (Cyclic_Mode(i)) {
+        case CYCLIC_MODE_ON_CHANGE:
+        case CYCLIC_MODE_ON_CHANGE_MINMAX:
+            Cyclic_NotifyChange(i, now);
+            break;
+        case CYCLIC_MODE_BURST:
+            if (x) x->remaining = x->shots;             // Restart the burst
+            Cyclic_Transmit(i, now, now);
+            break;
+        default:
+            Cyclic_Transmit(i, now, now);               // Counter/CRC are kept across updates
+            break;
         }
+        return 1;                                       // Done
+    }
+    // Add a new message in the first free slot
+    i = Cyclic_Alloc();
+    if (i == CYCLIC_NONE) return 0;                     // Table full
+    Cyclic_Fill(i, SLOT_ACTIVE, model, id, data, len, interval_us);
+    Cyclic_Transmit(i, now, now);
+    return 1;
+}
+// Send every due message and program the timer for the next deadline (TIM2 interrupt)
+void CAN_Cyclic_Update(void) {
+    uint32_t now = Timebase_Now();
+
+    if (bulk_commit_pending) Cyclic_ApplyBulk(now);   // Table swap happens only between passes
+    if (group_commit_pending) Cyclic_ApplyGroup(now); // So do group payload updates
+    if (cyc_paused) return;                           // Resume sets the next alarm
+
+    // Pop expired deadlines; each transmission reschedules or retires its slot
+    while (heap_len && (int32_t)(now - tab.heap_due[0]) >= 0) {
+        uint16_t slot = tab.heap_slot[0];
+        uint32_t due = tab.heap_due[0];
+        // Keep the phase so ISR latency does not add up, unless a whole period was missed;
+        // on-change messages restart their maximum repetition time from now
+        uint32_t base = (Cyclic_Mode(slot) != CYCLIC_MODE_ON_CHANGE_MINMAX &&
+                         now - due < tab.interval[slot]) ? due : now;
+        Cyclic_Transmit(slot, now, base);
+    }
+
+    if (heap_len) Timebase_SetAlarm(tab.heap_due[0]);
+}
+
+// Remove one message
+uint8_t CAN_Cyclic_Delete(uint32_t id) {
+    uint16_t i = Cyclic_Find(id);
+    if (i == CYCLIC_NONE) return 0;
+    Cyclic_Release(i);
+    return 1;
+}
+
+// Remove every active message; a staged bulk table is kept
+void CAN_Cyclic_Clear(void) {
+    for (uint16_t i = 0; i < MAX_CYCLIC_MSGS; i++) {
+        if (Cyclic_State(i) == SLOT_ACTIVE) Cyclic_Release(i);
     }
-    // Second pass: Add a new message in the first free slot
-    for (int i = 0; i < MAX_CYCLIC_MSGS; i++) {
-        if (!msgs[i].in_use) {
-            msgs[i].in_use = 1;                  // Mark slot as used
-            msgs[i].model = model;               // Save ID model
-            msgs[i].id = id;                     // Save CAN ID
-            memcpy(msgs[i].data, data, len);     // Copy data
-            msgs[i].len = len;                   // Set length
-            msgs[i].interval = cyclic_ms;        // Set cyclic interval
-            msgs[i].counter = 0;                 // Initialize counter
-            if (model == 0)
-                CAN_Send_STD((uint16_t)id, data, len);
-            else
-                CAN_Send_EXT(id, data, len);
-            return;                              // Done
+}
+
+// Number of active messages
+uint16_t CAN_Cyclic_Count(void) {
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < MAX_CYCLIC_MSGS; i++) n += (Cyclic_State(i) == SLOT_ACTIVE);
+    return n;
+}
+
+// Stop all transmissions, keeping the schedule
+void CAN_Cyclic_Pause(void) {
+    if (cyc_paused) return;
+    cyc_paused_at = Timebase_Now();
+    cyc_paused = 1;
+}
+
+// Continue where the pause left off: every deadline moves by the paused time
+void CAN_Cyclic_Resume(void) {
+    if (!cyc_paused) return;
+    uint32_t shift = Timebase_Now() - cyc_paused_at;
+    for (uint16_t i = 0; i < heap_len; i++) tab.heap_due[i] += shift;   // Same shift keeps the heap order
+    cyc_paused = 0;
+}
+
+uint8_t CAN_Cyclic_Paused(void) {
+    return cyc_paused;
+}
+
+// Keep the scheduler interrupt away while the table is changed from the main loop
+void CAN_Cyclic_Lock(void) {
+    NVIC_DisableIRQ(TIM2_IRQn);
+    __DSB();
+    __ISB();
+}
+
+// Allow the scheduler again and let it pick up the changes right away
+void CAN_Cyclic_Unlock(void) {
+    NVIC_EnableIRQ(TIM2_IRQn);
+    Timebase_Kick();
+}
+// Attach a rolling counter to an existing cyclic message
+uint8_t CAN_Cyclic_SetCounter(uint32_t id, uint8_t start_bit, uint8_t bit_len, uint8_t max) {
+    uint16_t slot = Cyclic_Find(id);
+    if (slot == CYCLIC_NONE || bit_len > 8 || start_bit + bit_len > 64) return 0;
+    CyclicExt *x = Cyclic_ExtAlloc(slot);
+    if (!x) return 0;                                      // Extension pool exhausted
+
+    uint8_t limit = (uint8_t)((1u << bit_len) - 1);       // Largest value the field can hold
+    x->ctr_start = start_bit;
+    x->ctr_len = bit_len;
+    x->ctr_max = (max == 0 || max > limit) ? limit : max;
+    x->ctr_value = 0;
+    return 1;
+}
+
+// Attach a checksum to an existing cyclic message
+uint8_t CAN_Cyclic_SetChecksum(uint32_t id, uint8_t type, uint8_t crc_byte, uint16_t data_id) {
+    uint16_t slot = Cyclic_Find(id);
+    if (slot == CYCLIC_NONE || type > CYCLIC_CRC_E2E_P2 || crc_byte > 7) return 0;
+    CyclicExt *x = Cyclic_ExtAlloc(slot);
+    if (!x) return 0;                                      // Extension pool exhausted
+
+    x->crc_type = type;
+    x->crc_byte = crc_byte;
+    x->data_id = data_id;
+    return 1;
+}
+// Start a new staged table, dropping anything staged before
+void CAN_Cyclic_BulkBegin(void) {
+    bulk_commit_pending = 0;
+    for (uint16_t i = 0; i < MAX_CYCLIC_MSGS; i++) {
+        if (Cyclic_State(i) == SLOT_STAGED) tab.flags[i] = SLOT_FREE;   // Staged slots own nothing else
+    }
+}
+
+// Add one entry to the staged table
+uint8_t CAN_Cyclic_BulkAdd(uint8_t model, uint32_t id, uint8_t *data, uint8_t len, uint32_t interval_us) {
+    if (len > 8 || interval_us == 0 || bulk_commit_pending) return 0;
+
+    uint16_t slot = CYCLIC_NONE;
+    for (uint16_t i = 0; i < MAX_CYCLIC_MSGS; i++) {
+        if (tab.id[i] == id && Cyclic_State(i) == SLOT_STAGED) { slot = i; break; }   // Last entry for an ID wins
+    }
+    if (slot == CYCLIC_NONE) slot = Cyclic_Alloc();
+    if (slot == CYCLIC_NONE) return 0;          // No room next to the active table
+
+    Cyclic_Fill(slot, SLOT_STAGED, model, id, data, len, interval_us);
+    return 1;
+}
+
+// Request the staged table to replace the active one at the next scheduler pass
+void CAN_Cyclic_BulkCommit(void) {
+    bulk_commit_pending = 1;
+}
+
+// Overwrite part of the payload of an existing message, keeping its schedule
+uint8_t CAN_Cyclic_PatchBytes(uint32_t id, uint8_t pos, const uint8_t *data, uint8_t count) {
+    uint16_t slot = Cyclic_Find(id);
+    if (slot == CYCLIC_NONE || count == 0 || pos + count > tab.len[slot]) return 0;
+
+    if (memcmp(&tab.data[slot][pos], data, count) != 0) tab.flags[slot] |= F_CHANGED;
+    memcpy(&tab.data[slot][pos], data, count);
+    Cyclic_NotifyChange(slot, Timebase_Now());           // Only on-change messages react
+    return 1;
+}
+
+// Overwrite a bit field of the payload of an existing message, keeping its schedule
+uint8_t CAN_Cyclic_PatchBits(uint32_t id, uint8_t start_bit, uint8_t bit_len, uint32_t value) {
+    uint16_t slot = Cyclic_Find(id);
+    if (slot == CYCLIC_NONE || bit_len == 0 || bit_len > 32 || start_bit + bit_len > tab.len[slot] * 8) return 0;
+
+    uint8_t old[8];
+    memcpy(old, tab.data[slot], sizeof(old));
+    Cyclic_WriteBits(tab.data[slot], start_bit, bit_len, value);
+    if (memcmp(old, tab.data[slot], sizeof(old)) != 0) tab.flags[slot] |= F_CHANGED;
+    Cyclic_NotifyChange(slot, Timebase_Now());
+    return 1;
+}
+
+// Start a new payload group, dropping anything staged before
+void CAN_Cyclic_GroupBegin(void) {
+    group_commit_pending = 0;
+    group_len = 0;
+}
+
+// Stage a new payload for an existing message
+uint8_t CAN_Cyclic_GroupStage(uint32_t id, const uint8_t *data, uint8_t len) {
+    uint16_t slot = Cyclic_Find(id);
+    if (slot == CYCLIC_NONE || len > 8 || group_commit_pending) return 0;
+
+    uint8_t k = 0;
+    while (k < group_len && tab.group[k].id != id) k++;    // Staging an ID again replaces its payload
+    if (k == MAX_CYCLIC_GROUP) return 0;                   // Group full
+    if (k == group_len) group_len++;
+
+    tab.group[k].id = id;
+    tab.group[k].slot = slot;
+    tab.group[k].len = len;
+    memcpy(tab.group[k].data, data, len);
+    return 1;
+}
+
+// Request the staged payloads to be applied together at the next scheduler pass
+void CAN_Cyclic_GroupCommit(void) {
+    group_commit_pending = 1;
+}
+
+// Export one slot for saving
+uint8_t CAN_Cyclic_GetEntry(uint16_t slot, CyclicEntry *out) {
+    if (slot >= MAX_CYCLIC_MSGS) return 0xFF;
+    if (Cyclic_State(slot) != SLOT_ACTIVE) return 0;
+    const CyclicExt *x = Cyclic_Ext(slot);
+
+    memset(out, 0, sizeof(*out));
+    out->id = tab.id[slot];
+    out->interval_us = tab.interval[slot];
+    out->model = (tab.flags[slot] & F_MODEL_EXT) ? 1 : 0;
+    out->len = tab.len[slot];
+    out->mode = Cyclic_Mode(slot);
+    memcpy(out->data, tab.data[slot], tab.len[slot]);
+    if (x) {
+        out->shots = x->shots;
+        out->min_ms = x->min_ms;
+        out->data_id = x->data_id;
+        out->ctr_start = x->ctr_start;
+        out->ctr_len = x->ctr_len;
+        out->ctr_max = x->ctr_max;
+        out->crc_type = x->crc_type;
+        out->crc_byte = x->crc_byte;
+    }
+    return 1;
+}
+
+// Export one generator for saving
+uint8_t CAN_Cyclic_GetGenerator(uint16_t index, CyclicGenEntry *out) {
+    if (index >= MAX_CYCLIC_GENS) return 0xFF;
+    const CyclicGen *g = &tab.gens[index];
+    if (!g->in_use) return 0;
+
+    memset(out, 0, sizeof(*out));                 // Padding too, so saved records compare equal
+    out->id = tab.id[g->slot];
+    out->period_ms = g->period_ms;
+    out->min = g->gen.min;
+    out->max = g->gen.max;
+    out->wave = g->gen.wave;
+    out->start_bit = g->start_bit;
+    out->bit_len = g->bit_len;
+    return 1;
+}
+
+// Re-create a saved message without sending it
+uint8_t CAN_Cyclic_Restore(const CyclicEntry *e) {
+    if (e->len > 8 || e->model > 1 || e->interval_us == 0 || e->mode > CYCLIC_MODE_ON_CHANGE_MINMAX ||
+        (e->mode == CYCLIC_MODE_BURST && e->shots == 0))
+        return 0;                                          // Same checks as CAN_Cyclic_SetMode
+
+    uint16_t old = Cyclic_Find(e->id);
+    if (old != CYCLIC_NONE) Cyclic_Release(old);
+
+    uint16_t slot = Cyclic_Alloc();
+    if (slot == CYCLIC_NONE) return 0;
+
+    // Filled while still marked free, published only when complete
+    uint32_t now = Timebase_Now();
+    Cyclic_Fill(slot, SLOT_FREE, e->model, e->id, (uint8_t *)e->data, e->len, e->interval_us);
+    tab.flags[slot] |= e->mode << F_MODE_POS;
+    if (e->ctr_len || e->crc_type || e->mode == CYCLIC_MODE_BURST || e->mode == CYCLIC_MODE_ON_CHANGE_MINMAX) {
+        CyclicExt *x = Cyclic_ExtAlloc(slot);
+        if (!x) {
+            Cyclic_Release(slot);
+            return 0;
         }
+        x->shots = e->shots;
+        x->remaining = e->shots;
+        x->min_ms = e->min_ms;
+        x->last_tx = now;
+        x->ctr_start = e->ctr_start;
+        x->ctr_len = (e->ctr_len <= 8) ? e->ctr_len : 0;
+        x->ctr_max = e->ctr_max;
+        x->crc_type = (e->crc_type <= CYCLIC_CRC_E2E_P2) ? e->crc_type : CYCLIC_CRC_NONE;
+        x->crc_byte = e->crc_byte & 7;
+        x->data_id = e->data_id;
     }
+    tab.flags[slot] |= SLOT_ACTIVE;
+    if (e->mode != CYCLIC_MODE_ON_CHANGE) Cyclic_Schedule(slot, now + tab.interval[slot]);
+    return 1;
 }
-// This function should be called every 10ms to check and send due messages
-void CAN_Cyclic_Update(void) {
-    for (int i = 0; i < MAX_CYCLIC_MSGS; i++) {
-        if (msgs[i].in_use && msgs[i].interval > 0) {
-            msgs[i].counter++;  // Count each 10ms tick
-
-            // Check if it's time to send this message
-            if (msgs[i].counter * 10 >= msgs[i].interval) {
-                if (msgs[i].model == 0)
-                    CAN_Send_STD((uint16_t)msgs[i].id, msgs[i].data, msgs[i].len); // Send Standard ID
-                else
-                    CAN_Send_EXT(msgs[i].id, msgs[i].data, msgs[i].len);           // Send Extended ID
-                msgs[i].counter = 0; // Reset the timer after sending
-            }
+
+// Change how the scheduler transmits an existing cyclic message
+uint8_t CAN_Cyclic_SetMode(uint32_t id, uint8_t mode, uint16_t shots, uint16_t min_ms) {
+    uint16_t slot = Cyclic_Find(id);
+    if (slot == CYCLIC_NONE || mode > CYCLIC_MODE_ON_CHANGE_MINMAX || (mode == CYCLIC_MODE_BURST && shots == 0))
+        return 0;
+
+    // Burst and min/max need their parameters stored; the other modes keep them if present
+    uint8_t needs_ext = (mode == CYCLIC_MODE_BURST || mode == CYCLIC_MODE_ON_CHANGE_MINMAX);
+    CyclicExt *x = needs_ext ? Cyclic_ExtAlloc(slot) : Cyclic_Ext(slot);
+    if (needs_ext && !x) return 0;                         // Extension pool exhausted
+
+    uint32_t now = Timebase_Now();
+    if (x) {
+        x->shots = shots;
+        x->remaining = shots;
+        x->min_ms = min_ms;
+        x->last_tx = now;
+    }
+    tab.flags[slot] = (tab.flags[slot] & ~(F_MODE | F_CHANGED)) | mode << F_MODE_POS;
+    if (mode == CYCLIC_MODE_ON_CHANGE)
+        Cyclic_Unschedule(slot);                           // Sent by updates only
+    else
+        Cyclic_Schedule(slot, now + tab.interval[slot]);   // Burst phase starts now
+    return 1;
+}
+
+// Attach, replace or remove a signal generator on a bit field of a cyclic message
+uint8_t CAN_Cyclic_SetGenerator(uint32_t id, uint8_t wave, uint8_t start_bit, uint8_t bit_len,
+                                uint16_t period_ms, uint16_t min, uint16_t max) {
+    uint16_t slot = Cyclic_Find(id);
+    if (slot == CYCLIC_NONE || wave > SIGGEN_NOISE || bit_len == 0 || bit_len > 16 || start_bit + bit_len > 64)
+        return 0;
+
+    // Reuse the generator already driving this field, otherwise take a free one
+    CyclicGen *g = 0;
+    for (int i = 0; i < MAX_CYCLIC_GENS; i++) {
+        CyclicGen *gen = &tab.gens[i];
+        if (gen->in_use && gen->slot == slot && gen->start_bit == start_bit) { g = gen; break; }
+        if (!gen->in_use && !g) g = gen;
+    }
+    if (!g) return 0;                                      // Pool exhausted
+
+    if (wave == SIGGEN_OFF) {
+        g->in_use = 0;                                     // Remove generator from this field
+        tab.flags[slot] &= ~F_GEN;
+        for (int i = 0; i < MAX_CYCLIC_GENS; i++) {
+            if (tab.gens[i].in_use && tab.gens[i].slot == slot) tab.flags[slot] |= F_GEN;
         }
+        return 1;
     }
+
+    g->slot = slot;
+    g->start_bit = start_bit;
+    g->bit_len = bit_len;
+    g->period_ms = period_ms;
+    SigGen_Init(&g->gen, wave, min, max, SigGen_PhaseStep(tab.interval[slot], period_ms * 1000u));
+    g->in_use = 1;
+    tab.flags[slot] |= F_GEN;
+    return 1;
 }
 /******************************************************
  * End of file
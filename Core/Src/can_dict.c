@@ -0,0 +1,98 @@
+/*
+ * can_dict.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "can_dict.h"
+#include "can_record.h"     // Record flags and the delta varint
+#include <string.h>         // For memcpy / memset
+
+_Static_assert(CAN_DICT_SIZE >= 1 && CAN_DICT_SIZE <= CAN_DICT_SLOT + 1, "CAN_DICT_SIZE must be 1-64");
+_Static_assert(CAN_DICT_REFRESH >= 1 && CAN_DICT_REFRESH <= 255, "CAN_DICT_REFRESH must be 1-255");
+
+// Key of a slot: ID, 29-bit flag and a used flag, so that 0 is an empty slot
+#define DICT_KEY_USED   0x40000000u
+#define DICT_KEY_EXT    0x80000000u
+
+typedef struct {
+    uint8_t data[8];        // Last payload sent
+    uint8_t dlc;
+    uint8_t hits;           // Frames sent as hits since the definition
+} DictSlot;
+
+// Keys apart from the rest: the lookup only scans this array
+static uint32_t dict_key[CAN_DICT_SIZE];
+static DictSlot dict_slot[CAN_DICT_SIZE];
+static uint8_t dict_next = 0;               // Slot the next new ID replaces
+
+// === Forget every ID ===
+void CAN_Dict_Reset(void) {
+    memset(dict_key, 0, sizeof(dict_key));
+    dict_next = 0;
+}
+
+// === Encode one frame ===
+uint8_t CAN_Dict_Encode(uint8_t *out, uint8_t room, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len,
+                        int32_t delta_us) {
+    uint32_t key = id | DICT_KEY_USED | (is_ext ? DICT_KEY_EXT : 0);
+    uint8_t n = len > 8 ? 8 : len;
+    uint8_t delta[4], dn = 0;
+    uint8_t diff[8], changed = 0, mask = 0;
+    uint8_t slot, size, *p = out;
+
+    if (delta_us >= 0) dn = CAN_Record_PutDelta(delta, (uint32_t)delta_us);
+
+    for (slot = 0; slot < CAN_DICT_SIZE && dict_key[slot] != key; slot++);
+    DictSlot *s = &dict_slot[slot < CAN_DICT_SIZE ? slot : dict_next];
+    uint8_t hit = slot < CAN_DICT_SIZE && s->dlc == len && s->hits + 1 < CAN_DICT_REFRESH;
+
+    if (hit) {
+        for (uint8_t i = 0; i < n; i++) {
+            diff[changed] = data[i] ^ s->data[i];
+            if (diff[changed]) {
+                mask |= (uint8_t)(1u << i);
+                changed++;
+            }
+        }
+        size = (uint8_t)(2 + changed + dn);
+    } else {
+        size = (uint8_t)(2 + (is_ext ? 4 : 2) + n + dn);
+    }
+    if (size > room) return 0;
+
+    if (hit) {
+        *p++ = CAN_DICT_HIT | (dn ? CAN_DICT_DELTA : 0) | slot;
+        *p++ = mask;
+        memcpy(p, diff, changed);
+        p += changed;
+        s->hits++;
+    } else {
+        if (slot == CAN_DICT_SIZE) {                // New ID: replace the oldest definition
+            slot = dict_next;
+            dict_next = (uint8_t)((dict_next + 1) % CAN_DICT_SIZE);
+            dict_key[slot] = key;
+        }
+        *p++ = (dn ? CAN_REC_DELTA : 0) | (is_ext ? CAN_REC_EXT : 0) | (len & CAN_REC_DLC);
+        *p++ = slot;
+        if (is_ext) {
+            *p++ = (uint8_t)(id >> 24);
+            *p++ = (uint8_t)(id >> 16);
+        }
+        *p++ = (uint8_t)(id >> 8);
+        *p++ = (uint8_t)id;
+        memcpy(p, data, n);
+        p += n;
+        s->dlc = len;
+        s->hits = 0;
+    }
+    memcpy(s->data, data, n);
+    memcpy(p, delta, dn);
+    return size;
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,253 @@
+/*
+ * can_forward.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "can_forward.h"
+#include "can_text.h"       // Text lines
+#include "can_record.h"     // Compact records
+#include "can_dict.h"       // Dictionary-coded records
+#include "can_buffer.h"     // Loss counters for the report
+#include "frame.h"          // Binary output travels in frames
+#include "slcan.h"          // SLCAN mode has its own line format
+#include "uart.h"           // Text lines go straight to the UART
+#include "timebase.h"       // Record timestamps and batch timeout
+#include <string.h>         // For memcpy
+
+static uint8_t fwd_format = CAN_FWD_DEFAULT;
+static uint8_t fwd_flags = 0;
+static uint32_t fwd_last_us;                // Time of the last record sent
+
+// Batch being filled
+static uint8_t fwd_batch[FRAME_TX_MAX];
+static uint8_t fwd_batch_len = 0;           // 0 = no batch open
+static uint32_t fwd_batch_start;            // Time of its first record
+static uint8_t fwd_batch_bytes = CAN_FWD_BATCH_BYTES;
+static uint16_t fwd_batch_us = CAN_FWD_BATCH_US;
+
+// Loss report
+static uint16_t fwd_report_ms = CAN_FWD_REPORT_MS;
+static uint32_t fwd_report_last;            // Time the last period started
+static uint8_t fwd_report_due = 0;          // Waiting for room in the UART ring
+#if !SLCAN_MODE
+static uint32_t fwd_report_received;        // Totals in the last report
+static uint32_t fwd_report_lost;
+#endif
+
+volatile uint32_t can_fwd_dropped = 0;
+
+// Send the open batch, if any; 0 if it is still open. A batch is never dropped
+// (the PC would lose step with the dictionary): it waits for room in the UART
+// ring instead, as a refused frame would still use up a sequence number
+static uint8_t CAN_Forward_Flush(void) {
+    if (!fwd_batch_len) return 1;
+    if (UART1_TxFree() < FRAME_WIRE_MAX) return 0;
+    Frame_Send(fwd_batch, fwd_batch_len);
+    fwd_batch_len = 0;
+    return 1;
+}
+
+// Time since the last record, saturated, or -1 without timestamps. A frame that
+// replaced a queued one of its ID (CAN_BUF_LATEST) can be younger than the frames
+// queued after it; they are sent as 0 µs after it
+static int32_t CAN_Forward_Delta(uint32_t now) {
+    uint32_t gap = now - fwd_last_us;
+    if (!(fwd_flags & CAN_FWD_TIMESTAMP)) return -1;
+    if ((int32_t)gap < 0) return 0;
+    return (int32_t)(gap > CAN_REC_DELTA_MAX ? CAN_REC_DELTA_MAX : gap);
+}
+
+// Move the timestamp base to a record sent with a delta
+static void CAN_Forward_Advance(uint32_t now) {
+    if ((int32_t)(now - fwd_last_us) > 0) fwd_last_us = now;
+}
+
+static void CAN_Forward_Put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// === Select the output format ===
+uint8_t CAN_Forward_SetFormat(uint8_t format, uint8_t flags) {
+    if (format > CAN_FWD_DICT || (flags & ~CAN_FWD_TIMESTAMP)) return 0;
+    // The open batch still goes out in the old format; like a command reply it
+    // waits for room in the UART ring rather than being lost
+    if (fwd_batch_len) {
+        UART1_TxWait(FRAME_WIRE_MAX);
+        CAN_Forward_Flush();
+    }
+    CAN_Dict_Reset();
+    fwd_format = format;
+    fwd_flags = flags;
+    fwd_last_us = Timebase_Now();
+    return 1;
+}
+
+// === Set the batch limits ===
+uint8_t CAN_Forward_SetBatch(uint8_t bytes, uint16_t timeout_us) {
+    if (bytes == 0 || bytes > FRAME_TX_MAX) return 0;
+    fwd_batch_bytes = bytes;
+    fwd_batch_us = timeout_us;
+    return 1;
+}
+
+// === Set the loss report period ===
+void CAN_Forward_SetReport(uint16_t ms) {
+    fwd_report_ms = ms;
+    fwd_report_due = 0;
+    fwd_report_last = Timebase_Now();
+}
+
+#if !SLCAN_MODE
+// Loss report: the totals and up to CAN_FWD_LOSS_ENTRIES of the IDs that lost
+// frames since they were last reported, taken in turn. One frame per period
+// keeps the report from crowding out the frames on a saturated link; an ID
+// left out now is in a later report with its count up to date. Nothing is sent
+// while nothing happened
+static void CAN_Forward_Report(void) {
+    uint8_t r[CAN_FWD_LOSS_HDR_LEN + CAN_FWD_LOSS_ENTRIES * 8];
+    CanLoss loss[CAN_FWD_LOSS_ENTRIES];
+    CanBufferStats st;
+
+    CAN_Buffer_Stats(&st);
+    uint8_t n = CAN_Buffer_Losses(loss, CAN_FWD_LOSS_ENTRIES);
+    fwd_report_due = 0;
+    if (!n && st.received == fwd_report_received && st.lost + st.overrun == fwd_report_lost) return;
+    fwd_report_received = st.received;
+    fwd_report_lost = st.lost + st.overrun;
+
+    r[0] = CAN_FWD_REPORT_LOSS;
+    r[1] = st.policy;
+    r[2] = st.peak;
+    CAN_Forward_Put32(&r[3], st.received);
+    CAN_Forward_Put32(&r[7], st.lost);
+    CAN_Forward_Put32(&r[11], st.overrun);
+    r[15] = n;
+    for (uint8_t i = 0; i < n; i++) {
+        CAN_Forward_Put32(&r[CAN_FWD_LOSS_HDR_LEN + 8 * i], loss[i].id);
+        CAN_Forward_Put32(&r[CAN_FWD_LOSS_HDR_LEN + 8 * i + 4], loss[i].lost);
+    }
+    Frame_Send(r, (uint8_t)(CAN_FWD_LOSS_HDR_LEN + 8 * n));
+}
+#endif
+
+// === Send a batch whose time is up, and the loss report ===
+// An idle UART gains nothing from waiting, so a batch only grows while the previous
+// output is still going out: single frames at low rates, full batches under load
+void CAN_Forward_Poll(void) {
+#if !SLCAN_MODE
+    uint32_t now = Timebase_Now();
+    if (fwd_report_ms && now - fwd_report_last >= (uint32_t)fwd_report_ms * 1000u) {
+        fwd_report_last = now;
+        fwd_report_due = 1;
+    }
+    if (fwd_report_due && UART1_TxFree() >= FRAME_WIRE_MAX) CAN_Forward_Report();
+#endif
+    if (!fwd_batch_len) return;
+    if (UART1_TxFree() == UART_TX_RING_SIZE || Timebase_Now() - fwd_batch_start >= fwd_batch_us) CAN_Forward_Flush();
+}
+
+// === Whether a frame can be forwarded without loss ===
+uint8_t CAN_Forward_Ready(void) {
+#if SLCAN_MODE
+    return UART1_TxFree() >= SLCAN_LINE_MAX;
+#else
+    if (fwd_report_due) return 0;
+    if (fwd_format >= CAN_FWD_BATCH && fwd_batch_len && fwd_batch_len + CAN_DICT_RECORD_MAX <= FRAME_TX_MAX) return 1;
+    return UART1_TxFree() >= FRAME_WIRE_MAX;
+#endif
+}
+
+// Compact record; the timestamp base only moves when the record went out
+static void CAN_Forward_Record(uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, uint32_t now) {
+    uint8_t rec[CAN_RECORD_MAX];
+
+    if (Frame_Send(rec, CAN_Record_Encode(rec, id, is_ext, data, len, CAN_Forward_Delta(now)))) CAN_Forward_Advance(now);
+}
+
+// Append a record to the open batch; 0 if it does not fit
+static uint8_t CAN_Forward_Append(uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, int32_t delta_us) {
+    uint8_t room = (uint8_t)(FRAME_TX_MAX - fwd_batch_len);
+    uint8_t *out = &fwd_batch[fwd_batch_len];
+    uint8_t n;
+
+    if (fwd_format == CAN_FWD_DICT) {
+        n = CAN_Dict_Encode(out, room, id, is_ext, data, len, delta_us);
+    } else {
+        uint8_t rec[CAN_RECORD_MAX];
+        n = CAN_Record_Encode(rec, id, is_ext, data, len, delta_us);
+        if (n > room) return 0;
+        memcpy(out, rec, n);
+    }
+    fwd_batch_len += n;
+    return n;
+}
+
+// Add a record to the open batch; a new batch starts with the absolute time and
+// its first record needs no delta. Frames that find a full batch still waiting
+// are dropped before they reach the dictionary
+static void CAN_Forward_Batch(uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, uint32_t now) {
+    if (fwd_batch_len && CAN_Forward_Append(id, is_ext, data, len, CAN_Forward_Delta(now))) {
+        CAN_Forward_Advance(now);
+    } else {
+        if (!CAN_Forward_Flush()) {
+            can_fwd_dropped++;
+            return;
+        }
+        fwd_batch[0] = (fwd_format == CAN_FWD_DICT) ? CAN_DICT_BATCH : CAN_REC_BATCH;
+        fwd_batch_len = 1;
+        if (fwd_flags & CAN_FWD_TIMESTAMP) {
+            fwd_batch[0] |= CAN_REC_BATCH_TIME;
+            CAN_Forward_Put32(&fwd_batch[1], now);
+            fwd_batch_len = 5;
+        }
+        fwd_batch_start = Timebase_Now();
+        CAN_Forward_Append(id, is_ext, data, len, -1);
+        fwd_last_us = now;
+    }
+
+    if (fwd_batch_len >= fwd_batch_bytes) CAN_Forward_Flush();
+}
+
+// === Send one received frame to the PC ===
+void CAN_Forward(uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, uint32_t rx_us) {
+#if SLCAN_MODE
+    // t/T line, with timestamp if enabled
+    SLCAN_Forward(id, is_ext, data, len > 8 ? 8 : len, rx_us);
+    return;
+#endif
+    if (fwd_format == CAN_FWD_RECORD) {
+        CAN_Forward_Record(id, is_ext, data, len, rx_us);
+        return;
+    }
+    if (fwd_format >= CAN_FWD_BATCH) {
+        CAN_Forward_Batch(id, is_ext, data, len, rx_us);
+        return;
+    }
+#if FRAME_COBS
+    // Full binary record [Ext][ID 4][Len][Data]
+    uint8_t rec[6 + 8];
+    uint8_t n = len > 8 ? 8 : len;
+    rec[0] = is_ext;
+    rec[1] = (uint8_t)(id >> 24);
+    rec[2] = (uint8_t)(id >> 16);
+    rec[3] = (uint8_t)(id >> 8);
+    rec[4] = (uint8_t)id;
+    rec[5] = n;
+    for (uint8_t i = 0; i < n; i++) rec[6 + i] = data[i];
+    Frame_Send(rec, 6 + n);
+#else
+    // CAN ID, frame type (Std/Ext) and data bytes in hexadecimal
+    char line[CAN_TEXT_LINE_MAX];
+    UART1_Write((const uint8_t *)line, CAN_Text_Format(line, id, is_ext, data, len));
+#endif
+}
+/*
+ * End of file
+ */
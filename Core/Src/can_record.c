@@ -0,0 +1,47 @@
+/*
+ * can_record.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "can_record.h"
+#include <string.h>         // For memcpy
+
+// === Encode one frame ===
+uint8_t CAN_Record_Encode(uint8_t *out, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len,
+                          int32_t delta_us) {
+    uint8_t *p = out;
+    uint8_t n = len > 8 ? 8 : len;
+
+    *p++ = CAN_REC_MARK | (is_ext ? CAN_REC_EXT : 0) | (delta_us >= 0 ? CAN_REC_DELTA : 0) | (len & CAN_REC_DLC);
+    if (is_ext) {
+        *p++ = (uint8_t)(id >> 24);
+        *p++ = (uint8_t)(id >> 16);
+    }
+    *p++ = (uint8_t)(id >> 8);
+    *p++ = (uint8_t)id;
+    memcpy(p, data, n);
+    p += n;
+
+    if (delta_us >= 0) p += CAN_Record_PutDelta(p, (uint32_t)delta_us);
+    return (uint8_t)(p - out);
+}
+
+// === Write a time delta ===
+uint8_t CAN_Record_PutDelta(uint8_t *out, uint32_t delta_us) {
+    uint8_t *p = out;
+    uint32_t d = delta_us > CAN_REC_DELTA_MAX ? CAN_REC_DELTA_MAX : delta_us;
+
+    while (d >= 0x80) {
+        *p++ = (uint8_t)(d | 0x80);
+        d >>= 7;
+    }
+    *p++ = (uint8_t)d;
+    return (uint8_t)(p - out);
+}
+/*
+ * End of file
+ */
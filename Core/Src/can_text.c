@@ -0,0 +1,50 @@
+/*
+ * can_text.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "can_text.h"
+#include <string.h>         // For memcpy
+
+static const char txt_hex[16] = "0123456789ABCDEF";
+
+// Fixed parts of the line, indexed by is_ext
+static const char txt_type[2][15] = { " [Std], Data: ", " [Ext], Data: " };
+
+// === Format one frame ===
+uint8_t CAN_Text_Format(char *out, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len) {
+    char *p = out;
+
+    memcpy(p, "ID: 0x", 6);
+    p += 6;
+
+    // At least 3 digits, more only as far as the ID needs them (%03lX)
+    uint8_t digits = 3;
+    while (digits < 8 && (id >> (4 * digits))) digits++;
+    for (uint8_t i = digits; i-- > 0;) {
+        p[i] = txt_hex[id & 0xF];
+        id >>= 4;
+    }
+    p += digits;
+
+    memcpy(p, txt_type[is_ext ? 1 : 0], 14);
+    p += 14;
+
+    if (len > 8) len = 8;                           // DLC 9-15 still carries 8 bytes
+    for (uint8_t i = 0; i < len; i++) {
+        p[0] = txt_hex[data[i] >> 4];
+        p[1] = txt_hex[data[i] & 0xF];
+        p[2] = ' ';
+        p += 3;
+    }
+    p[0] = '\r';
+    p[1] = '\n';
+    return (uint8_t)(p + 2 - out);
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,71 @@
+/*
+ * clock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "clock.h"
+
+#define CLOCK_STARTUP_LOOPS 100000u     // ~50 ms at 8 MHz for HSE / PLL to become ready
+
+// Wait for a ready flag in RCC->CR, 0 on timeout
+static uint8_t Clock_WaitReady(uint32_t flag) {
+    for (uint32_t i = 0; i < CLOCK_STARTUP_LOOPS; i++) {
+        if (RCC->CR & flag) return 1;
+    }
+    return 0;
+}
+
+// === Clock tree setup ===
+uint8_t Clock_Init(void) {
+    uint32_t pll;
+
+    RCC->CR |= RCC_CR_HSEON;                          // Start the 8 MHz crystal
+    uint8_t hse = Clock_WaitReady(RCC_CR_HSERDY);
+    if (hse) {
+        pll = RCC_CFGR_PLLSRC | RCC_CFGR_PLLMULL9;    // 8 MHz x 9 = 72 MHz
+    } else {
+        RCC->CR &= ~RCC_CR_HSEON;
+        pll = RCC_CFGR_PLLMULL16;                     // HSI / 2 x 16 = 64 MHz
+    }
+
+    // Two wait states above 48 MHz, with the prefetch buffer on
+    FLASH->ACR = FLASH_ACR_PRFTBE | FLASH_ACR_LATENCY_2;
+
+    // AHB /1, APB1 /2 (max 36 MHz), APB2 /1, ADC /6, USB /1.5
+    RCC->CFGR = RCC_CFGR_HPRE_DIV1 | RCC_CFGR_PPRE1_DIV2 | RCC_CFGR_PPRE2_DIV1 |
+                RCC_CFGR_ADCPRE_DIV6 | pll;
+
+    RCC->CR |= RCC_CR_PLLON;
+    if (!Clock_WaitReady(RCC_CR_PLLRDY)) {
+        FLASH->ACR = FLASH_ACR_PRFTBE;                // Stay on HSI at 8 MHz, zero wait states
+        SystemCoreClockUpdate();
+        return 0;
+    }
+
+    RCC->CFGR |= RCC_CFGR_SW_PLL;                     // Switch SYSCLK to the PLL
+    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+
+    SystemCoreClockUpdate();
+    return hse;
+}
+
+// === Bus clocks ===
+uint32_t Clock_PCLK1(void) {
+    return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+uint32_t Clock_PCLK2(void) {
+    return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+}
+
+uint32_t Clock_TimerAPB1(void) {
+    uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+    return APBPrescTable[ppre1] ? Clock_PCLK1() * 2 : Clock_PCLK1();
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,63 @@
+/*
+ * cmd_queue.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "cmd_queue.h"
+#include "command.h"        // CMD_MAX_LEN
+#include "stm32f1xx.h"      // __DMB
+
+// Packet slots; head is written by the ISR only, tail by the main loop only
+static uint8_t slots[CMD_QUEUE_SLOTS][CMD_MAX_LEN];
+static uint16_t lengths[CMD_QUEUE_SLOTS];
+static uint8_t seqs[CMD_QUEUE_SLOTS];
+static volatile uint8_t head = 0;           // Slot being received
+static volatile uint8_t tail = 0;           // Oldest queued slot
+static volatile uint32_t dropped = 0;       // Packets lost to a full queue
+
+// === Producer ===
+uint8_t *CmdQueue_Current(void) {
+    return slots[head];
+}
+
+uint8_t CmdQueue_Push(uint16_t len, uint8_t seq) {
+    uint8_t next = (head + 1) % CMD_QUEUE_SLOTS;
+    if (next == tail) {
+        dropped++;                          // Keep receiving into the same slot
+        return 0;
+    }
+    lengths[head] = len;
+    seqs[head] = seq;
+    __DMB();                                // Packet contents visible before the index moves
+    head = next;
+    return 1;
+}
+
+uint8_t CmdQueue_Full(void) {
+    return (head + 1) % CMD_QUEUE_SLOTS == tail;
+}
+
+// === Consumer ===
+uint8_t *CmdQueue_Peek(uint16_t *len, uint8_t *seq) {
+    if (tail == head) return 0;
+    __DMB();
+    *len = lengths[tail];
+    *seq = seqs[tail];
+    return slots[tail];
+}
+
+void CmdQueue_Pop(void) {
+    __DMB();                                // Finish using the slot before handing it back
+    tail = (tail + 1) % CMD_QUEUE_SLOTS;
+}
+
+uint32_t CmdQueue_Dropped(void) {
+    return dropped;
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,90 @@
+/*
+ * cobs.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "cobs.h"
+#include <string.h>         // For memcpy
+
+#define COBS_MAX_RUN 254    // Data bytes in a full block (code 0xFF)
+
+static const uint8_t cobs_zero = 0;
+
+// Copy the zero-free run at src (at most max bytes): a word at a time, then bytewise
+static uint16_t COBS_CopyRun(uint8_t *dst, const uint8_t *src, uint16_t max) {
+    uint16_t run = 0;
+    while (run + 4 <= max) {
+        uint32_t w;
+        memcpy(&w, src + run, 4);                   // Single (unaligned) load on Cortex-M3
+        if ((w - 0x01010101u) & ~w & 0x80808080u) break;    // Word holds a zero byte
+        memcpy(dst + run, &w, 4);
+        run += 4;
+    }
+    while (run < max && src[run]) {
+        dst[run] = src[run];
+        run++;
+    }
+    return run;
+}
+
+// === Encode ===
+uint16_t COBS_Encode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    uint8_t *out = dst;
+
+    for (;;) {
+        uint16_t max = len < COBS_MAX_RUN ? len : COBS_MAX_RUN;
+        uint16_t run = COBS_CopyRun(out + 1, src, max);
+        uint8_t zero = run < max;                   // Run ended at a zero, not at the block limit
+
+        *out = (uint8_t)(run + 1);                  // Code: distance to the next zero
+        out += 1 + run;
+        src += run;
+        len -= run;
+
+        if (zero) {
+            src++;                                  // The zero itself is the code byte
+            len--;
+        } else if (!len) {
+            break;                                  // A full block at the end needs no extra code
+        }
+    }
+    return (uint16_t)(out - dst);
+}
+
+// === Decode ===
+void COBS_DecodeReset(CobsDecoder *d) {
+    d->left = 0;
+    d->zero = 0;
+}
+
+uint16_t COBS_DecodeNext(CobsDecoder *d, const uint8_t *src, uint16_t n,
+                         const uint8_t **seg, uint16_t *seg_len) {
+    if (d->left) {
+        uint16_t run = d->left < n ? d->left : n;  // Data bytes pass through unchanged
+        d->left -= run;
+        *seg = src;
+        *seg_len = run;
+        return run;
+    }
+    if (d->zero) {
+        d->zero = 0;                                // Another block follows: the zero was real
+        *seg = &cobs_zero;
+        *seg_len = 1;
+        return 0;
+    }
+    d->left = src[0] - 1;                           // Code byte
+    d->zero = src[0] != 0xFF;
+    *seg_len = 0;
+    return 1;
+}
+
+uint8_t COBS_DecodeComplete(const CobsDecoder *d) {
+    return d->left == 0;
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,534 @@
+/*
+ * command.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "command.h"
+#include "cmd_queue.h"
+#include "can.h"
+#include "can_cyclic.h"
+#include "config_store.h"
+#include "crc.h"
+#include "uart.h"
+#include "frame.h"
+#include "can_forward.h"
+#include "can_buffer.h"
+#include <string.h>         // For memcpy
+
+// Packet types selected by the first byte of each command packet
+#define CMD_STD            0x00             // [0][ID 2][Len][Data][Cyclic 2]
+#define CMD_EXT            0x01             // [1][ID 4][Len][Data][Cyclic 2]
+#define CMD_SET_COUNTER    0x02             // [2][ID 4][StartBit][BitLen][Max]
+#define CMD_SET_CHECKSUM   0x03             // [3][ID 4][Type][CrcByte][DataID 2]
+#define CMD_SET_GENERATOR  0x04             // [4][ID 4][Wave][StartBit][BitLen][Period 2][Min 2][Max 2]
+#define CMD_SET_MODE       0x05             // [5][ID 4][Mode][Shots 2][Min 2]
+#define CMD_BULK_LOAD      0x06             // [6][Flags][Bytes 2][Entries][CRC8]
+#define CMD_SAVE_CONFIG    0x07             // [7]
+#define CMD_ERASE_CONFIG   0x08             // [8]
+#define CMD_SET_BITRATE    0x09             // [9][Bitrate 4]
+#define CMD_SET_FILTER     0x0A             // [A][Ext][ID 4][Mask 4]
+#define CMD_FRAME_US       0x0B             // [B][Model][ID 4][Len][Data][Interval_us 4]
+#define CMD_GROUP_UPDATE   0x0C             // [C][Flags][Bytes 2][Entries][CRC8]
+#define CMD_PATCH          0x0D             // [D][Ctl][ID 2 or 4][Bytes] or [D][Ctl][ID 2 or 4][StartBit][Value]
+#define CMD_DELETE         0x0E             // [E][ID 4]
+#define CMD_CLEAR          0x0F             // [F]
+#define CMD_PAUSE          0x10             // [10]
+#define CMD_RESUME         0x11             // [11]
+#define CMD_LIST           0x12             // [12][First slot 2]
+#define CMD_INFO           0x13             // [13]
+#define CMD_SET_OUTPUT     0x14             // [14][Format][Flags]
+#define CMD_SET_BATCH      0x15             // [15][Bytes][Timeout_us 2]
+#define CMD_SET_OVERFLOW   0x16             // [16][Policy][Report_ms 2]
+
+// Bulk load flags and entry layout: [Model][ID 4][Len][Data][Cyclic 2 or Interval_us 4]
+#define CMD_BULK_BEGIN     0x01             // Discard previously staged entries first
+#define CMD_BULK_COMMIT    0x02             // Swap the staged table in after this packet
+#define CMD_BULK_US        0x04             // Entry intervals are 4-byte microsecond values
+#define CMD_BULK_ENTRY_HDR 6                // Model + ID + Len
+
+// Group update entry layout: [ID 4][Len][Data], flags as for bulk load
+#define CMD_GROUP_ENTRY_HDR 5               // ID + Len
+
+// Patch control byte: [Ext][Bits][Pos 3][Count-1 3] or [Ext][Bits][BitLen-1 6]
+#define CMD_PATCH_EXT      0x80             // 4-byte (extended) ID follows, else 2-byte ID
+#define CMD_PATCH_BITS     0x40             // Bit field: start bit and big-endian value follow
+
+// List reply entries use the bulk load layout with a microsecond interval
+#define CMD_LIST_ENTRY_MAX (CMD_BULK_ENTRY_HDR + 8 + 4)
+
+// Dispatch table flags
+#define CMD_F_LOCK         0x01             // Changes the schedule: run with the scheduler interrupt blocked
+
+// Command window: sequence numbers win_base + i with bit i of win_done set are executed
+static uint8_t win_base;                    // Oldest sequence number not executed yet
+static uint16_t win_done;
+static uint8_t win_status[2 * CMD_WINDOW];  // Result by seq, covering the window and the one before it
+static uint8_t win_synced;                  // A first frame has set win_base
+static uint8_t cmd_seq;                     // Sequence number of the command being executed, for replies
+
+// Position of a sequence number relative to the window
+enum { WIN_NEW, WIN_DUPLICATE, WIN_OUTSIDE };
+
+// Read a big-endian 32-bit value from a packet
+static uint32_t Cmd_Get32(const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+// Status from a 1/0 driver result
+static uint8_t Cmd_Status(uint8_t ok) {
+    return ok ? CMD_OK : CMD_ERR_REJECTED;
+}
+
+// =====================================================================
+// Packet lengths of the variable-size packets; CMD_LEN_UNKNOWN until the length field arrived
+
+static uint16_t Cmd_LenStd(const uint8_t *cmd, uint16_t received) {
+    if (received < 4) return CMD_LEN_UNKNOWN;
+    return (cmd[3] > 8) ? CMD_LEN_INVALID : 4 + cmd[3] + 2;
+}
+
+static uint16_t Cmd_LenExt(const uint8_t *cmd, uint16_t received) {
+    if (received < 6) return CMD_LEN_UNKNOWN;
+    return (cmd[5] > 8) ? CMD_LEN_INVALID : 6 + cmd[5] + 2;
+}
+
+static uint16_t Cmd_LenFrameUs(const uint8_t *cmd, uint16_t received) {
+    if (received < 7) return CMD_LEN_UNKNOWN;
+    return (cmd[1] > 1 || cmd[6] > 8) ? CMD_LEN_INVALID : 7 + cmd[6] + 4;
+}
+
+static uint16_t Cmd_LenBulk(const uint8_t *cmd, uint16_t received) {
+    if (received < 4) return CMD_LEN_UNKNOWN;
+    uint16_t total = 4 + (cmd[2] << 8 | cmd[3]) + 1;
+    return (total > CMD_MAX_LEN) ? CMD_LEN_INVALID : total;
+}
+
+static uint16_t Cmd_LenPatch(const uint8_t *cmd, uint16_t received) {
+    if (received < 2) return CMD_LEN_UNKNOWN;
+    uint8_t ctl = cmd[1];
+    uint16_t hdr = (ctl & CMD_PATCH_EXT) ? 6 : 4;
+    if (ctl & CMD_PATCH_BITS) {
+        uint8_t bits = (ctl & 0x3F) + 1;
+        return (bits > 32) ? CMD_LEN_INVALID : hdr + 1 + (bits + 7) / 8;
+    }
+    uint8_t pos = (ctl >> 3) & 7, count = (ctl & 7) + 1;
+    return (pos + count > 8) ? CMD_LEN_INVALID : hdr + count;
+}
+
+// =====================================================================
+// Handlers, one per packet type
+
+// Check a bulk load packet completely before staging any of its entries
+static uint8_t Cmd_BulkValid(const uint8_t *cmd, uint16_t total_len) {
+    if (CRC8_J1850_Update(0xFF, cmd, total_len - 1) != cmd[total_len - 1]) return 0;
+
+    uint8_t ival = (cmd[1] & CMD_BULK_US) ? 4 : 2;  // Size of the interval field
+    uint16_t pos = 4;
+    uint16_t end = total_len - 1;
+    while (pos < end) {
+        if (pos + CMD_BULK_ENTRY_HDR > end) return 0;
+        uint8_t len = cmd[pos + 5];
+        if (cmd[pos] > 1 || len > 8) return 0;
+        pos += CMD_BULK_ENTRY_HDR + len + ival;
+    }
+    return pos == end;                              // Entries must fill the packet exactly
+}
+
+// Stage all entries of a bulk load packet and commit if requested
+static uint8_t Cmd_BulkLoad(uint8_t *cmd, uint16_t total_len) {
+    uint8_t flags = cmd[1];
+    uint8_t ival = (flags & CMD_BULK_US) ? 4 : 2;
+
+    if (!Cmd_BulkValid(cmd, total_len)) {
+        CAN_Cyclic_BulkBegin();                     // Corrupt chunk poisons the whole transaction
+        return CMD_ERR_CHECK;
+    }
+    if (flags & CMD_BULK_BEGIN) CAN_Cyclic_BulkBegin();
+
+    uint16_t pos = 4;
+    while (pos < total_len - 1) {
+        uint8_t *e = &cmd[pos];
+        uint8_t len = e[5];
+        uint8_t *t = &e[CMD_BULK_ENTRY_HDR + len];
+        uint32_t interval_us = (flags & CMD_BULK_US) ? Cmd_Get32(t) : (uint32_t)(t[0] << 8 | t[1]) * 1000u;
+        if (!CAN_Cyclic_BulkAdd(e[0], Cmd_Get32(&e[1]), &e[CMD_BULK_ENTRY_HDR], len, interval_us)) {
+            CAN_Cyclic_BulkBegin();                 // Table does not fit: abort
+            return CMD_ERR_REJECTED;
+        }
+        pos += CMD_BULK_ENTRY_HDR + len + ival;
+    }
+
+    if (flags & CMD_BULK_COMMIT) CAN_Cyclic_BulkCommit();
+    return CMD_OK;
+}
+
+// Check a group update packet completely before staging any of its payloads
+static uint8_t Cmd_GroupValid(const uint8_t *cmd, uint16_t total_len) {
+    if (CRC8_J1850_Update(0xFF, cmd, total_len - 1) != cmd[total_len - 1]) return 0;
+
+    uint16_t pos = 4;
+    uint16_t end = total_len - 1;
+    while (pos < end) {
+        if (pos + CMD_GROUP_ENTRY_HDR > end || cmd[pos + 4] > 8) return 0;
+        pos += CMD_GROUP_ENTRY_HDR + cmd[pos + 4];
+    }
+    return pos == end;                              // Entries must fill the packet exactly
+}
+
+// Stage the payloads of a group update packet and commit if requested
+static uint8_t Cmd_GroupUpdate(uint8_t *cmd, uint16_t total_len) {
+    uint8_t flags = cmd[1];
+
+    if (!Cmd_GroupValid(cmd, total_len)) {
+        CAN_Cyclic_GroupBegin();                    // Never apply part of a group
+        return CMD_ERR_CHECK;
+    }
+    if (flags & CMD_BULK_BEGIN) CAN_Cyclic_GroupBegin();
+
+    uint16_t pos = 4;
+    while (pos < total_len - 1) {
+        uint8_t *e = &cmd[pos];
+        if (!CAN_Cyclic_GroupStage(Cmd_Get32(e), &e[CMD_GROUP_ENTRY_HDR], e[4])) {
+            CAN_Cyclic_GroupBegin();                // Unknown ID or group full: abort
+            return CMD_ERR_REJECTED;
+        }
+        pos += CMD_GROUP_ENTRY_HDR + e[4];
+    }
+
+    if (flags & CMD_BULK_COMMIT) CAN_Cyclic_GroupCommit();
+    return CMD_OK;
+}
+
+// Write a byte range or bit field into a cyclic payload without touching its timing
+static uint8_t Cmd_Patch(uint8_t *cmd, uint16_t total_len) {
+    uint8_t ctl = cmd[1];
+    uint32_t id = (ctl & CMD_PATCH_EXT) ? Cmd_Get32(&cmd[2]) : (uint32_t)(cmd[2] << 8 | cmd[3]);
+    uint8_t *p = &cmd[(ctl & CMD_PATCH_EXT) ? 6 : 4];
+
+    if (ctl & CMD_PATCH_BITS) {
+        uint32_t value = 0;
+        for (uint8_t *v = p + 1; v < cmd + total_len; v++) value = value << 8 | *v;
+        return Cmd_Status(CAN_Cyclic_PatchBits(id, p[0], (ctl & 0x3F) + 1, value));
+    }
+    return Cmd_Status(CAN_Cyclic_PatchBytes(id, (ctl >> 3) & 7, p, (ctl & 7) + 1));
+}
+
+// 0x00 / 0x01: add, update or send once (interval in ms)
+static uint8_t Cmd_Frame(uint8_t *cmd, uint16_t total_len) {
+    uint8_t model = cmd[0];
+    uint8_t header_len = (model == CMD_STD) ? 4 : 6;                  // Determine header size
+    uint8_t len = cmd[header_len - 1];                                // Get data length
+    uint32_t id = (model == CMD_STD)
+        ? (uint32_t)(cmd[1] << 8 | cmd[2])                            // STD ID: 11-bit
+        : Cmd_Get32(&cmd[1]);                                         // EXT ID: 29-bit
+    uint16_t cyclic = cmd[total_len - 2] << 8 | cmd[total_len - 1];   // Cyclic interval
+
+    // Add or update entry in CAN cyclic buffer
+    return Cmd_Status(CAN_Cyclic_AddOrUpdate(model, id, &cmd[header_len], len, cyclic));
+}
+
+static uint8_t Cmd_FrameUs(uint8_t *cmd, uint16_t total_len) {
+    return Cmd_Status(CAN_Cyclic_AddOrUpdateUs(cmd[1], Cmd_Get32(&cmd[2]), &cmd[7], cmd[6],
+                                               Cmd_Get32(&cmd[total_len - 4])));
+}
+
+static uint8_t Cmd_SetCounter(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    return Cmd_Status(CAN_Cyclic_SetCounter(Cmd_Get32(&cmd[1]), cmd[5], cmd[6], cmd[7]));
+}
+
+static uint8_t Cmd_SetChecksum(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    return Cmd_Status(CAN_Cyclic_SetChecksum(Cmd_Get32(&cmd[1]), cmd[5], cmd[6], cmd[7] << 8 | cmd[8]));
+}
+
+static uint8_t Cmd_SetGenerator(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    return Cmd_Status(CAN_Cyclic_SetGenerator(Cmd_Get32(&cmd[1]), cmd[5], cmd[6], cmd[7],
+                                              cmd[8] << 8 | cmd[9],
+                                              cmd[10] << 8 | cmd[11],
+                                              cmd[12] << 8 | cmd[13]));
+}
+
+static uint8_t Cmd_SetMode(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    return Cmd_Status(CAN_Cyclic_SetMode(Cmd_Get32(&cmd[1]), cmd[5], cmd[6] << 8 | cmd[7], cmd[8] << 8 | cmd[9]));
+}
+
+static uint8_t Cmd_SaveConfig(uint8_t *cmd, uint16_t total_len) {
+    (void)cmd;
+    (void)total_len;
+    return Config_Save() ? CMD_OK : CMD_ERR_FLASH;
+}
+
+static uint8_t Cmd_EraseConfig(uint8_t *cmd, uint16_t total_len) {
+    (void)cmd;
+    (void)total_len;
+    return Config_Erase() ? CMD_OK : CMD_ERR_FLASH;
+}
+
+static uint8_t Cmd_SetBitrate(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    return Cmd_Status(CAN_SetBitrate(Cmd_Get32(&cmd[1])));
+}
+
+static uint8_t Cmd_SetFilter(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    CAN_SetFilter(Cmd_Get32(&cmd[2]), Cmd_Get32(&cmd[6]), cmd[1]);
+    return CMD_OK;
+}
+
+// 0x0E: remove one message without sending it
+static uint8_t Cmd_Delete(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    return Cmd_Status(CAN_Cyclic_Delete(Cmd_Get32(&cmd[1])));
+}
+
+static uint8_t Cmd_Clear(uint8_t *cmd, uint16_t total_len) {
+    (void)cmd;
+    (void)total_len;
+    CAN_Cyclic_Clear();
+    return CMD_OK;
+}
+
+static uint8_t Cmd_Pause(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    if (cmd[0] == CMD_PAUSE) CAN_Cyclic_Pause();
+    else CAN_Cyclic_Resume();
+    return CMD_OK;
+}
+
+// Queue a reply frame; waits for room instead of dropping it like forwarded traffic
+static void Cmd_Reply(const uint8_t *r, uint8_t n) {
+    UART1_TxWait(FRAME_WIRE_MAX);
+    Frame_Send(r, n);
+}
+
+// 0x12: stream the active table from a slot on, as bulk load entries
+// [Model][ID 4][Len][Data][Interval_us 4] in reports [Type][Seq][Next 2][Count][Entries];
+// Next is the slot to continue from, 0xFFFF in the last report
+static uint8_t Cmd_List(uint8_t *cmd, uint16_t total_len) {
+    uint8_t r[FRAME_TX_MAX];
+    uint16_t slot = (uint16_t)(cmd[1] << 8 | cmd[2]);
+    (void)total_len;
+
+    for (;;) {
+        uint8_t n = CMD_LIST_HDR_LEN, count = 0;
+        uint8_t more;
+        CyclicEntry e;
+
+        // A report's worth of entries is read with the scheduler blocked, the
+        // report is sent without
+        CAN_Cyclic_Lock();
+        while (n + CMD_LIST_ENTRY_MAX <= FRAME_TX_MAX) {
+            more = CAN_Cyclic_GetEntry(slot, &e);
+            if (more == 0xFF) break;                    // End of the table
+            slot++;
+            if (!more) continue;                        // Free slot
+
+            uint8_t *p = &r[n];
+            p[0] = e.model;
+            p[1] = (uint8_t)(e.id >> 24);
+            p[2] = (uint8_t)(e.id >> 16);
+            p[3] = (uint8_t)(e.id >> 8);
+            p[4] = (uint8_t)e.id;
+            p[5] = e.len;
+            memcpy(&p[6], e.data, e.len);
+            p += CMD_BULK_ENTRY_HDR + e.len;
+            p[0] = (uint8_t)(e.interval_us >> 24);
+            p[1] = (uint8_t)(e.interval_us >> 16);
+            p[2] = (uint8_t)(e.interval_us >> 8);
+            p[3] = (uint8_t)e.interval_us;
+            n += CMD_BULK_ENTRY_HDR + e.len + 4;
+            count++;
+        }
+        CAN_Cyclic_Unlock();
+
+        uint16_t next = (more == 0xFF) ? 0xFFFF : slot;
+        r[0] = CMD_REPORT_LIST;
+        r[1] = cmd_seq;
+        r[2] = (uint8_t)(next >> 8);
+        r[3] = (uint8_t)next;
+        r[4] = count;
+        Cmd_Reply(r, n);
+        if (more == 0xFF) return CMD_OK;
+    }
+}
+
+// 0x13: firmware version, table sizes and build options
+static uint8_t Cmd_Info(uint8_t *cmd, uint16_t total_len) {
+    uint16_t used = CAN_Cyclic_Count();
+    uint8_t flags = (CAN_Cyclic_Paused() ? CMD_INFO_PAUSED : 0)
+                  | (FRAME_COBS ? CMD_INFO_COBS : 0)
+                  | (UART_FLOW_CONTROL ? CMD_INFO_FLOW_CONTROL : 0);
+    uint8_t r[CMD_INFO_LEN] = {
+        CMD_REPORT_INFO, cmd_seq, CMD_VERSION_MAJOR, CMD_VERSION_MINOR,
+        (uint8_t)(CAN_CYCLIC_CAPACITY >> 8), (uint8_t)CAN_CYCLIC_CAPACITY,
+        (uint8_t)(used >> 8), (uint8_t)used,
+        CAN_CYCLIC_EXT_CAPACITY, CAN_CYCLIC_GEN_CAPACITY, CMD_WINDOW,
+        (uint8_t)(CMD_MAX_LEN >> 8), (uint8_t)CMD_MAX_LEN, flags,
+    };
+    (void)cmd;
+    (void)total_len;
+    Cmd_Reply(r, CMD_INFO_LEN);
+    return CMD_OK;
+}
+
+// 0x14: format of the received frames forwarded to the PC
+static uint8_t Cmd_SetOutput(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    return CAN_Forward_SetFormat(cmd[1], cmd[2]) ? CMD_OK : CMD_ERR_REJECTED;
+}
+
+// 0x15: when a batch of forwarded frames is sent
+static uint8_t Cmd_SetBatch(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    return CAN_Forward_SetBatch(cmd[1], (uint16_t)(cmd[2] << 8 | cmd[3])) ? CMD_OK : CMD_ERR_REJECTED;
+}
+
+// 0x16: overflow policy of the receive queue and loss report period; clears the loss counters
+static uint8_t Cmd_SetOverflow(uint8_t *cmd, uint16_t total_len) {
+    (void)total_len;
+    if (!CAN_Buffer_SetPolicy(cmd[1])) return CMD_ERR_REJECTED;
+    CAN_Forward_SetReport((uint16_t)(cmd[2] << 8 | cmd[3]));
+    return CMD_OK;
+}
+
+/*
+ * Dispatch table indexed by the packet type byte: fixed length (0 = ask the
+ * length function), flags and handler
+ */
+typedef struct {
+    uint8_t len;
+    uint8_t flags;
+    uint16_t (*length)(const uint8_t *cmd, uint16_t received);
+    uint8_t (*execute)(uint8_t *cmd, uint16_t total_len);
+} CmdEntry;
+
+static const CmdEntry cmd_table[] = {
+    [CMD_STD]           = { 0,  CMD_F_LOCK, Cmd_LenStd,     Cmd_Frame },
+    [CMD_EXT]           = { 0,  CMD_F_LOCK, Cmd_LenExt,     Cmd_Frame },
+    [CMD_SET_COUNTER]   = { 8,  CMD_F_LOCK, 0,              Cmd_SetCounter },
+    [CMD_SET_CHECKSUM]  = { 9,  CMD_F_LOCK, 0,              Cmd_SetChecksum },
+    [CMD_SET_GENERATOR] = { 14, CMD_F_LOCK, 0,              Cmd_SetGenerator },
+    [CMD_SET_MODE]      = { 10, CMD_F_LOCK, 0,              Cmd_SetMode },
+    [CMD_BULK_LOAD]     = { 0,  CMD_F_LOCK, Cmd_LenBulk,    Cmd_BulkLoad },
+    [CMD_SAVE_CONFIG]   = { 1,  CMD_F_LOCK, 0,              Cmd_SaveConfig },
+    [CMD_ERASE_CONFIG]  = { 1,  0,          0,              Cmd_EraseConfig },
+    [CMD_SET_BITRATE]   = { 5,  CMD_F_LOCK, 0,              Cmd_SetBitrate },
+    [CMD_SET_FILTER]    = { 10, 0,          0,              Cmd_SetFilter },
+    [CMD_FRAME_US]      = { 0,  CMD_F_LOCK, Cmd_LenFrameUs, Cmd_FrameUs },
+    [CMD_GROUP_UPDATE]  = { 0,  CMD_F_LOCK, Cmd_LenBulk,    Cmd_GroupUpdate },
+    [CMD_PATCH]         = { 0,  CMD_F_LOCK, Cmd_LenPatch,   Cmd_Patch },
+    [CMD_DELETE]        = { 5,  CMD_F_LOCK, 0,              Cmd_Delete },
+    [CMD_CLEAR]         = { 1,  CMD_F_LOCK, 0,              Cmd_Clear },
+    [CMD_PAUSE]         = { 1,  CMD_F_LOCK, 0,              Cmd_Pause },
+    [CMD_RESUME]        = { 1,  CMD_F_LOCK, 0,              Cmd_Pause },
+    [CMD_LIST]          = { 3,  0,          0,              Cmd_List },
+    [CMD_INFO]          = { 1,  0,          0,              Cmd_Info },
+    [CMD_SET_OUTPUT]    = { 3,  0,          0,              Cmd_SetOutput },
+    [CMD_SET_BATCH]     = { 4,  0,          0,              Cmd_SetBatch },
+    [CMD_SET_OVERFLOW]  = { 4,  0,          0,              Cmd_SetOverflow },
+};
+
+#define CMD_TYPES (sizeof(cmd_table) / sizeof(cmd_table[0]))
+
+// === Work out the full length of a packet from its first bytes ===
+uint16_t Command_Length(const uint8_t *cmd, uint16_t received) {
+    if (cmd[0] >= CMD_TYPES || !cmd_table[cmd[0]].execute) return CMD_LEN_INVALID;
+    const CmdEntry *e = &cmd_table[cmd[0]];
+    return e->len ? e->len : e->length(cmd, received);
+}
+
+// === Execute one complete packet ===
+uint8_t Command_Execute(uint8_t *cmd, uint16_t total_len) {
+    if (cmd[0] >= CMD_TYPES || !cmd_table[cmd[0]].execute) return CMD_ERR_REJECTED;
+    const CmdEntry *e = &cmd_table[cmd[0]];
+
+    if (!(e->flags & CMD_F_LOCK)) return e->execute(cmd, total_len);
+    CAN_Cyclic_Lock();                              // Scheduler runs from TIM2, keep it out meanwhile
+    uint8_t status = e->execute(cmd, total_len);
+    CAN_Cyclic_Unlock();
+    return status;
+}
+
+// Send an ACK / NACK report with the current window state
+static void Cmd_Report(uint8_t type, uint8_t seq, uint8_t status) {
+    uint8_t r[CMD_REPORT_LEN] = { type, seq, status, win_base, (uint8_t)(win_done >> 8), (uint8_t)win_done };
+    Cmd_Reply(r, CMD_REPORT_LEN);
+}
+
+// Classify a received sequence number against the window
+static uint8_t Cmd_WindowCheck(uint8_t seq) {
+    uint8_t d = (uint8_t)(seq - win_base);
+
+    if (!win_synced) {                                              // First frame after reset
+        win_base = seq;
+        win_done = 0;
+        win_synced = 1;
+        return WIN_NEW;
+    }
+    if (d < CMD_WINDOW) return (win_done & (1u << d)) ? WIN_DUPLICATE : WIN_NEW;
+    if (d >= (uint8_t)(256 - CMD_WINDOW)) return WIN_DUPLICATE;     // Retransmission of an old command
+    return WIN_OUTSIDE;
+}
+
+// Mark a command executed and slide the window over the completed prefix
+static void Cmd_WindowDone(uint8_t seq, uint8_t status) {
+    win_done |= 1u << (uint8_t)(seq - win_base);
+    win_status[seq % (2 * CMD_WINDOW)] = status;
+    while (win_done & 1) {
+        win_done >>= 1;
+        win_base++;
+    }
+}
+
+// Execute one queued packet at most once per sequence number
+static uint8_t Cmd_Run(uint8_t *cmd, uint16_t len, uint8_t seq) {
+    uint8_t status;
+
+    if (len == 0) {                                 // Empty frame: the host (re)starts its window after it
+        win_base = seq + 1;
+        win_done = 0;
+        win_synced = 1;
+        return CMD_OK;
+    }
+
+    switch (Cmd_WindowCheck(seq)) {
+    case WIN_NEW:
+        cmd_seq = seq;
+        status = Command_Execute(cmd, len);
+        Cmd_WindowDone(seq, status);
+        return status;
+    case WIN_DUPLICATE:
+        return win_status[seq % (2 * CMD_WINDOW)];  // Already done: repeat the original answer
+    default:
+        return CMD_ERR_SEQUENCE;
+    }
+}
+
+// === Execute everything the receiver queued (main loop) ===
+void Command_Process(void) {
+    uint16_t len;
+    uint8_t seq, last;
+    uint8_t *cmd;
+
+    if (!CmdQueue_Peek(&len, &seq)) return;
+
+    while ((cmd = CmdQueue_Peek(&len, &seq)) != 0) {
+        uint8_t status = Cmd_Run(cmd, len, seq);
+        CmdQueue_Pop();
+        UART1_RxResume();                           // A slot is free for frames held in the UART buffer
+
+        if (status != CMD_OK) Cmd_Report(CMD_REPORT_NACK, seq, status);
+        last = seq;
+    }
+    Cmd_Report(CMD_REPORT_ACK, last, CMD_OK);       // One cumulative ACK per pass
+}
+/*
+ * End of file
+ */
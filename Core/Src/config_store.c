@@ -0,0 +1,174 @@
+/*
+ * config_store.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "config_store.h"
+#include "flash_store.h"    // Key-value log in flash
+#include "can.h"            // Bit rate and filter
+#include "can_cyclic.h"     // Schedule export / restore
+#include "stm32f1xx_hal.h"  // HAL flash driver
+
+// Flash area: last CONFIG_FLASH_PAGES pages of the 64 KB part, excluded from FLASH in the linker script
+#define CONFIG_FLASH_BASE   0x0800F000u
+
+// Record keys
+#define CFG_KEY_LAYOUT      0x0001      // Layout version of the records below
+#define CFG_KEY_BITRATE     0x0002      // uint32_t bit rate
+#define CFG_KEY_FILTER      0x0003      // uint32_t id, uint32_t mask, uint8_t is_extended
+#define CFG_KEY_MSG_COUNT   0x0004      // uint16_t number of saved messages
+#define CFG_KEY_GEN_COUNT   0x0005      // uint16_t number of saved generators
+#define CFG_KEY_MSG_BASE    0x1000      // + n: CyclicEntry
+#define CFG_KEY_GEN_BASE    0x2000      // + n: CyclicGenEntry
+
+#define CFG_LAYOUT_VERSION  2           // Bump when CyclicEntry / CyclicGenEntry change
+
+// Filter record
+typedef struct {
+    uint32_t id;
+    uint32_t mask;
+    uint8_t is_extended;
+} CfgFilter;
+
+_Static_assert(CONFIG_FLASH_PAGE_SIZE == FLASH_PAGE_SIZE, "CONFIG_FLASH_PAGE_SIZE must match the part");
+_Static_assert(CONFIG_SAVE_FIXED_SIZE == FLASH_STORE_RECORD_SIZE(sizeof(uint8_t)) + FLASH_STORE_RECORD_SIZE(sizeof(uint32_t)) +
+               FLASH_STORE_RECORD_SIZE(sizeof(CfgFilter)) + 2 * FLASH_STORE_RECORD_SIZE(sizeof(uint16_t)),
+               "CONFIG_SAVE_FIXED_SIZE must match the records besides the lists");
+_Static_assert(CONFIG_SAVE_MAX_MESSAGES >= 16, "Flash store too small for a useful schedule");
+
+// === Flash access through the HAL driver ===
+static uint8_t Config_FlashErase(uint8_t page) {
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_PAGES,
+        .PageAddress = CONFIG_FLASH_BASE + (uint32_t)page * FLASH_PAGE_SIZE,
+        .NbPages = 1
+    };
+    uint32_t page_error;
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef st = HAL_FLASHEx_Erase(&erase, &page_error);
+    HAL_FLASH_Lock();
+    return st == HAL_OK;
+}
+
+static uint8_t Config_FlashProgram(uint32_t offset, const uint16_t *data, uint16_t count) {
+    HAL_StatusTypeDef st = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    for (uint16_t i = 0; i < count && st == HAL_OK; i++)
+        st = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, CONFIG_FLASH_BASE + offset + 2 * i, data[i]);
+    HAL_FLASH_Lock();
+    return st == HAL_OK;
+}
+
+static const FlashStoreDev config_flash = {
+    (const uint8_t *)CONFIG_FLASH_BASE,
+    CONFIG_FLASH_PAGE_SIZE,
+    CONFIG_FLASH_PAGES,
+    Config_FlashErase,
+    Config_FlashProgram
+};
+
+// Length of a saved list: its count, plus entries a save cut short left behind it
+static uint16_t Config_ListLength(uint16_t count_key, uint16_t base_key) {
+    uint16_t n = 0;
+    uint8_t none;
+
+    FlashStore_Read(count_key, &n, sizeof(n));
+    while (FlashStore_Read(base_key + n, &none, 0)) n++;
+    return n;
+}
+
+// Delete the entries of a longer list that was saved before, then store the count
+static uint8_t Config_TrimList(uint16_t count_key, uint16_t base_key, uint16_t count) {
+    for (uint16_t i = Config_ListLength(count_key, base_key); i > count; i--) {
+        if (!FlashStore_Delete(base_key + i - 1)) return 0;
+    }
+    return FlashStore_Write(count_key, &count, sizeof(count));
+}
+
+// === Restore at boot ===
+void Config_Restore(void) {
+    uint8_t layout = 0;
+    uint32_t bitrate;
+    CfgFilter filter;
+    uint16_t count = 0;
+
+    if (!FlashStore_Init(&config_flash)) return;
+    if (!FlashStore_Read(CFG_KEY_LAYOUT, &layout, sizeof(layout)) || layout != CFG_LAYOUT_VERSION) return;
+
+    if (FlashStore_Read(CFG_KEY_BITRATE, &bitrate, sizeof(bitrate)) == sizeof(bitrate))
+        CAN_SetBitrate(bitrate);
+    if (FlashStore_Read(CFG_KEY_FILTER, &filter, sizeof(filter)) == sizeof(filter))
+        CAN_SetFilter(filter.id, filter.mask, filter.is_extended);
+
+    FlashStore_Read(CFG_KEY_MSG_COUNT, &count, sizeof(count));
+    for (uint16_t i = 0; i < count; i++) {
+        CyclicEntry e;
+        if (FlashStore_Read(CFG_KEY_MSG_BASE + i, &e, sizeof(e)) == sizeof(e)) CAN_Cyclic_Restore(&e);
+    }
+
+    count = 0;
+    FlashStore_Read(CFG_KEY_GEN_COUNT, &count, sizeof(count));
+    for (uint16_t i = 0; i < count; i++) {
+        CyclicGenEntry g;
+        if (FlashStore_Read(CFG_KEY_GEN_BASE + i, &g, sizeof(g)) == sizeof(g))
+            CAN_Cyclic_SetGenerator(g.id, g.wave, g.start_bit, g.bit_len, g.period_ms, g.min, g.max);
+    }
+}
+
+// === Save running configuration ===
+uint8_t Config_Save(void) {
+    uint8_t layout = CFG_LAYOUT_VERSION;
+    uint32_t bitrate = CAN_GetBitrate();
+    CfgFilter filter = { 0 };
+    CyclicEntry e;
+    CyclicGenEntry g;
+    uint16_t msgs = 0, gens = 0, n;
+    uint8_t st;
+
+    for (uint16_t slot = 0; (st = CAN_Cyclic_GetEntry(slot, &e)) != 0xFF; slot++) msgs += (st == 1);
+    for (uint16_t i = 0; (st = CAN_Cyclic_GetGenerator(i, &g)) != 0xFF; i++) gens += (st == 1);
+
+    // Everything must fit before anything is written, counting the old entries
+    // of a longer list, which stay live until they are deleted at the end
+    uint16_t old_msgs = Config_ListLength(CFG_KEY_MSG_COUNT, CFG_KEY_MSG_BASE);
+    uint16_t old_gens = Config_ListLength(CFG_KEY_GEN_COUNT, CFG_KEY_GEN_BASE);
+    uint32_t need = CONFIG_SAVE_FIXED_SIZE
+                  + (uint32_t)(msgs > old_msgs ? msgs : old_msgs) * FLASH_STORE_RECORD_SIZE(sizeof(e))
+                  + (uint32_t)(gens > old_gens ? gens : old_gens) * FLASH_STORE_RECORD_SIZE(sizeof(g));
+    if (need > FlashStore_Capacity()) return 0;
+
+    // The layout key goes first and comes back last: a save cut short by a
+    // reset restores nothing rather than a mix of the old and new schedule
+    if (!FlashStore_Delete(CFG_KEY_LAYOUT)) return 0;
+
+    CAN_GetFilter(&filter.id, &filter.mask, &filter.is_extended);
+    if (!FlashStore_Write(CFG_KEY_BITRATE, &bitrate, sizeof(bitrate))) return 0;
+    if (!FlashStore_Write(CFG_KEY_FILTER, &filter, sizeof(filter))) return 0;
+
+    n = 0;
+    for (uint16_t slot = 0; (st = CAN_Cyclic_GetEntry(slot, &e)) != 0xFF; slot++) {
+        if (st == 1 && !FlashStore_Write(CFG_KEY_MSG_BASE + n++, &e, sizeof(e))) return 0;
+    }
+    n = 0;
+    for (uint16_t i = 0; (st = CAN_Cyclic_GetGenerator(i, &g)) != 0xFF; i++) {
+        if (st == 1 && !FlashStore_Write(CFG_KEY_GEN_BASE + n++, &g, sizeof(g))) return 0;
+    }
+
+    if (!Config_TrimList(CFG_KEY_MSG_COUNT, CFG_KEY_MSG_BASE, msgs)) return 0;
+    if (!Config_TrimList(CFG_KEY_GEN_COUNT, CFG_KEY_GEN_BASE, gens)) return 0;
+    return FlashStore_Write(CFG_KEY_LAYOUT, &layout, sizeof(layout));
+}
+
+// === Forget saved configuration ===
+uint8_t Config_Erase(void) {
+    return FlashStore_Format();
+}
+/*
+ * End of file
+ */
@@ -11,7 +11,7 @@
 
 // Function to create a delay in milliseconds
 void delay_ms(uint32_t ms) {
-    SysTick->LOAD = 8000 - 1;           // Set reload value for 1ms delay (assuming 8 MHz system clock)
+    SysTick->LOAD = SystemCoreClock / 1000 - 1; // Set reload value for 1ms delay at the current core clock
     SysTick->VAL = 0;                   // Clear current SysTick counter value
     SysTick->CTRL = 5;                  // Enable SysTick with processor clock, no interrupt (CLKSOURCE = 1, ENABLE = 1)
 
@@ -0,0 +1,261 @@
+/*
+ * flash_store.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "flash_store.h"
+#include "crc.h"          // CRC8 protects every record
+#include <string.h>       // For memcpy / memcmp / memset
+
+/*
+ * Layout
+ *
+ * Page:   [Magic 2][State 2][Seq 4][Record][Record]...[0xFF...]
+ * Record: [Key 2][Len 1][CRC8 1][Data, padded to an even length]
+ *
+ * Pages form a ring. The page with the highest sequence number is active, the
+ * page_count - 2 pages before it hold older records and the page after it is
+ * the spare that gets erased next. When a page is opened, the live records of
+ * the page that drops out of the window are copied into it (State = 0xFFFF
+ * while this is in progress, 0x0000 when done).
+ *
+ * A record is programmed length and CRC first, then the data, then the key: a
+ * record cut short by a reset has an erased key, so it is never found, and its
+ * length still tells where the next record starts.
+ */
+#define FS_MAGIC        0x5346u          // "FS"
+#define FS_STATE_READY  0x0000u          // Relocation into this page finished
+#define FS_HDR_SIZE     8                // Page header size (FLASH_STORE_CAPACITY)
+#define FS_REC_HDR      4                // Record header size (FLASH_STORE_RECORD_SIZE)
+#define FS_KEY_ERASED   0xFFFFu          // Erased flash (key of a record that was cut short)
+
+static const FlashStoreDev *fs;          // Flash area
+static uint8_t fs_active;                // Index of the active page
+static uint32_t fs_seq;                  // Sequence number of the active page
+static uint16_t fs_offset;               // Next free byte in the active page
+
+// Little-endian readers (flash may hold records at any even offset)
+static uint16_t FS_Get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t FS_Get32(const uint8_t *p) {
+    return (uint32_t)FS_Get16(p) | (uint32_t)FS_Get16(p + 2) << 16;
+}
+
+// Start address of a page
+static const uint8_t *FS_Page(uint8_t page) {
+    return fs->base + (uint32_t)page * fs->page_size;
+}
+
+// Size a record occupies in flash
+static uint16_t FS_RecSize(const uint8_t *rec) {
+    return FS_REC_HDR + ((rec[2] + 1) & ~1u);
+}
+
+// CRC8 SAE-J1850 over key, length and value
+static uint8_t FS_RecCrc(uint16_t key, const uint8_t *data, uint8_t len) {
+    uint8_t hdr[3] = { (uint8_t)key, (uint8_t)(key >> 8), len };
+    uint8_t crc = CRC8_J1850_Update(0xFF, hdr, 3);
+    return CRC8_J1850_Update(crc, data, len) ^ 0xFF;
+}
+
+// Check that a record was completely written
+static uint8_t FS_RecValid(const uint8_t *rec) {
+    return FS_Get16(rec) != FS_KEY_ERASED && rec[2] <= FLASH_STORE_MAX_VALUE &&
+           FS_RecCrc(FS_Get16(rec), rec + FS_REC_HDR, rec[2]) == rec[3];
+}
+
+// Ring position of the page k pages older than the active one
+static uint8_t FS_Older(uint8_t k) {
+    return (uint8_t)((fs_active + fs->page_count - k) % fs->page_count);
+}
+
+// Check that a page carries a header with the expected sequence number
+static uint8_t FS_PageIs(uint8_t page, uint32_t seq) {
+    const uint8_t *p = FS_Page(page);
+    return FS_Get16(p) == FS_MAGIC && FS_Get32(p + 4) == seq;
+}
+
+// Check for an erased record header, the end of the page log
+static uint8_t FS_HdrErased(const uint8_t *rec) {
+    return FS_Get16(rec) == FS_KEY_ERASED && FS_Get16(rec + 2) == 0xFFFFu;
+}
+
+// Offset of the next record after off, 0 at the end of the page log
+static uint16_t FS_Next(const uint8_t *page, uint16_t off) {
+    if (off + FS_REC_HDR > fs->page_size || FS_HdrErased(page + off)) return 0;
+    uint16_t next = off + FS_RecSize(page + off);
+    return (next > fs->page_size) ? 0 : next;           // Torn record header: treat page as full
+}
+
+// First free offset in a page
+static uint16_t FS_End(const uint8_t *page) {
+    uint16_t off = FS_HDR_SIZE;
+    for (uint16_t next; (next = FS_Next(page, off)) != 0; off = next);
+    // A torn record makes FS_Next stop early; never write over it
+    return (off + FS_REC_HDR <= fs->page_size && !FS_HdrErased(page + off)) ? fs->page_size : off;
+}
+
+// Newest valid record of key within the newest depth pages, NULL if none
+static const uint8_t *FS_Find(uint16_t key, uint8_t depth) {
+    for (uint8_t k = 0; k < depth; k++) {
+        uint8_t page = FS_Older(k);
+        if (!FS_PageIs(page, fs_seq - k)) break;         // Older pages are not part of the log
+
+        const uint8_t *p = FS_Page(page);
+        const uint8_t *hit = 0;
+        for (uint16_t off = FS_HDR_SIZE, next; (next = FS_Next(p, off)) != 0; off = next) {
+            if (FS_Get16(p + off) == key && FS_RecValid(p + off)) hit = p + off;   // Later wins
+        }
+        if (hit) return hit;
+    }
+    return 0;
+}
+
+// Append one record to the active page (caller checks the space)
+static uint8_t FS_Append(uint16_t key, const uint8_t *data, uint8_t len) {
+    uint16_t buf[(FS_REC_HDR + FLASH_STORE_MAX_VALUE) / 2];
+    uint8_t *b = (uint8_t *)buf;
+    uint16_t size = FS_REC_HDR + ((len + 1) & ~1u);
+
+    memset(b, 0xFF, size);
+    b[0] = (uint8_t)key;
+    b[1] = (uint8_t)(key >> 8);
+    b[2] = len;
+    b[3] = FS_RecCrc(key, data, len);
+    memcpy(b + FS_REC_HDR, data, len);
+
+    uint32_t offset = (uint32_t)fs_active * fs->page_size + fs_offset;
+    fs_offset += size;                                   // Space is used even if programming fails
+    return fs->program(offset + 2, buf + 1, 1) &&        // Length and CRC
+           (size == FS_REC_HDR || fs->program(offset + FS_REC_HDR, buf + 2, (size - FS_REC_HDR) / 2)) &&
+           fs->program(offset, buf, 1);                  // Key last: the record is complete
+}
+
+// Copy the live records of the page that just left the window into the active page
+static uint8_t FS_Relocate(void) {
+    uint8_t dropped = FS_Older(fs->page_count - 1);
+    uint16_t ready = FS_STATE_READY;
+
+    if (FS_PageIs(dropped, fs_seq - (fs->page_count - 1))) {
+        const uint8_t *p = FS_Page(dropped);
+        for (uint16_t off = FS_HDR_SIZE, next; (next = FS_Next(p, off)) != 0; off = next) {
+            const uint8_t *rec = p + off;
+            if (rec[2] == 0 || !FS_RecValid(rec)) continue;               // Tombstones die here
+            if (FS_Find(FS_Get16(rec), fs->page_count) != rec) continue;  // Superseded
+            if (fs_offset + FS_RecSize(rec) > fs->page_size) return 0;    // Fits an empty page of the same size
+            if (!FS_Append(FS_Get16(rec), rec + FS_REC_HDR, rec[2])) return 0;
+        }
+    }
+    return fs->program((uint32_t)fs_active * fs->page_size + 2, &ready, 1);
+}
+
+// Erase a page, make it active with sequence number seq and pull the live records
+// of the page that drops out of the window into it
+static uint8_t FS_OpenPage(uint8_t page, uint32_t seq) {
+    uint16_t seq_hw[2] = { (uint16_t)seq, (uint16_t)(seq >> 16) };
+    uint16_t magic = FS_MAGIC;
+    uint32_t base = (uint32_t)page * fs->page_size;
+
+    // Sequence first, magic last: a page is only valid once its header is complete
+    if (!fs->erase(page) || !fs->program(base + 4, seq_hw, 2) || !fs->program(base, &magic, 1)) return 0;
+
+    fs_active = page;
+    fs_seq = seq;
+    fs_offset = FS_HDR_SIZE;
+    return FS_Relocate();
+}
+
+// Erase the spare page and make it active
+static uint8_t FS_OpenNextPage(void) {
+    return FS_OpenPage((uint8_t)((fs_active + 1) % fs->page_count), fs_seq + 1);
+}
+
+// Append a record, moving to new pages as needed
+static uint8_t FS_Store(uint16_t key, const uint8_t *data, uint8_t len) {
+    uint16_t size = FS_REC_HDR + ((len + 1) & ~1u);
+
+    for (uint8_t tries = 0; tries < fs->page_count; tries++) {
+        if (fs_offset + size <= fs->page_size) return FS_Append(key, data, len);
+        if (!FS_OpenNextPage()) return 0;
+    }
+    return 0;                                            // Live data does not fit any more
+}
+
+// === Erase the area and start with an empty first page ===
+uint8_t FlashStore_Format(void) {
+    for (uint8_t i = 0; i < fs->page_count; i++) {
+        if (!fs->erase(i)) return 0;
+    }
+    uint16_t hdr[4] = { FS_MAGIC, FS_STATE_READY, 1, 0 };    // Sequence 1
+    if (!fs->program(0, hdr, 4)) return 0;
+
+    fs_active = 0;
+    fs_seq = 1;
+    fs_offset = FS_HDR_SIZE;
+    return 1;
+}
+
+// === Find the active page and the write position ===
+uint8_t FlashStore_Init(const FlashStoreDev *dev) {
+    uint8_t found = 0;
+    fs = dev;
+
+    for (uint8_t i = 0; i < fs->page_count; i++) {
+        const uint8_t *p = FS_Page(i);
+        if (FS_Get16(p) != FS_MAGIC) continue;
+        if (!found || FS_Get32(p + 4) > fs_seq) {
+            fs_active = i;
+            fs_seq = FS_Get32(p + 4);
+            found = 1;
+        }
+    }
+    if (!found) return FlashStore_Format();
+
+    // Reset hit during a page change: the page only holds copies and the dropped
+    // page is still intact, so the relocation starts over on an erased page (a
+    // record cut short would use up room the page may need for the copies)
+    if (FS_Get16(FS_Page(fs_active) + 2) != FS_STATE_READY) return FS_OpenPage(fs_active, fs_seq);
+
+    fs_offset = FS_End(FS_Page(fs_active));
+    return 1;
+}
+
+// === Store a value ===
+uint8_t FlashStore_Write(uint16_t key, const void *data, uint8_t len) {
+    if (key == FS_KEY_ERASED || len == 0 || len > FLASH_STORE_MAX_VALUE) return 0;
+
+    const uint8_t *rec = FS_Find(key, fs->page_count - 1);
+    if (rec && rec[2] == len && memcmp(rec + FS_REC_HDR, data, len) == 0) return 1;   // Save a write
+    return FS_Store(key, data, len);
+}
+
+// === Read the latest value ===
+uint8_t FlashStore_Read(uint16_t key, void *data, uint8_t maxlen) {
+    const uint8_t *rec = FS_Find(key, fs->page_count - 1);
+    if (!rec || rec[2] == 0) return 0;
+
+    memcpy(data, rec + FS_REC_HDR, rec[2] < maxlen ? rec[2] : maxlen);
+    return rec[2];
+}
+
+// === Live bytes that always fit ===
+uint32_t FlashStore_Capacity(void) {
+    return FLASH_STORE_CAPACITY((uint32_t)fs->page_size, (uint32_t)fs->page_count);
+}
+
+// === Delete a key ===
+uint8_t FlashStore_Delete(uint16_t key) {
+    const uint8_t *rec = FS_Find(key, fs->page_count - 1);
+    uint8_t none = 0;
+    if (!rec || rec[2] == 0) return 1;                   // Nothing to delete
+    return FS_Store(key, &none, 0);                      // Tombstone: empty value
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,250 @@
+/*
+ * frame.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "frame.h"
+#include "command.h"        // Packet lengths
+#include "cmd_queue.h"      // Complete packets are handed to the main loop
+#include "crc.h"            // Header CRC8 and frame CRC16
+#include "cobs.h"           // Byte stuffing in COBS mode
+#include "uart.h"           // Frame_Send output
+#include <string.h>         // For memchr / memcpy / memmove
+
+/*
+ * SOF frame:   [SOF][Seq][Len 2][HdrCRC8][Body, Len bytes][CRC16 2]
+ * COBS frame:  COBS([Seq][Body][CRC16 2]) 0x00
+ *
+ * Multi-byte fields are big-endian. HdrCRC8 is CRC8 SAE-J1850 over Seq and Len;
+ * CRC16 is CRC-16/CCITT-FALSE over everything from Seq up to the end of the body.
+ */
+volatile uint32_t frame_errors = 0;
+
+static uint8_t fr_tx_seq;                   // Sequence number of the next frame sent
+
+// A complete frame was received: queue the packet if it is intact
+static void Frame_Deliver(uint8_t seq, uint16_t len, uint16_t rx_crc, uint16_t crc) {
+    if (rx_crc != crc || (len && Command_Length(CmdQueue_Current(), len) != len)) {
+        frame_errors++;
+        return;
+    }
+    CmdQueue_Push(len, seq);                        // Sequence is checked by the command window
+}
+
+#if FRAME_COBS
+// =====================================================================
+// COBS framing
+// =====================================================================
+static CobsDecoder fr_cobs;
+static uint16_t fr_pos;                     // Decoded bytes of the current frame
+static uint8_t fr_overflow;                 // Frame longer than the largest packet
+static uint8_t fr_seq;
+static uint8_t fr_spill[FRAME_CRC_LEN];     // Decoded bytes past the end of the queue slot
+
+// Decoded frame byte i (after Seq): packet and CRC share the slot, the CRC may spill
+static uint8_t Frame_Byte(uint16_t i) {
+    return i < CMD_MAX_LEN ? CmdQueue_Current()[i] : fr_spill[i - CMD_MAX_LEN];
+}
+
+// Store a decoded segment: Seq aside, packet (and CRC) straight into the queue slot
+static void Frame_Put(const uint8_t *p, uint16_t n) {
+    if (!n || fr_overflow) return;
+    if (fr_pos == 0) {
+        fr_seq = *p++;
+        n--;
+        fr_pos = 1;
+    }
+
+    uint16_t i = fr_pos - 1;
+    if (i + n > CMD_MAX_LEN + FRAME_CRC_LEN) {
+        fr_overflow = 1;
+        return;
+    }
+    fr_pos += n;
+    if (i < CMD_MAX_LEN) {
+        uint16_t chunk = (i + n <= CMD_MAX_LEN) ? n : CMD_MAX_LEN - i;
+        memcpy(CmdQueue_Current() + i, p, chunk);
+        p += chunk;
+        n -= chunk;
+        i += chunk;
+    }
+    memcpy(&fr_spill[i - CMD_MAX_LEN], p, n);
+}
+
+// Delimiter reached: check and deliver the frame, then start the next one
+static void Frame_End(void) {
+    if (fr_pos || fr_overflow) {                     // Empty frames (0x00 0x00) are ignored
+        if (fr_overflow || !COBS_DecodeComplete(&fr_cobs) || fr_pos < 1 + FRAME_CRC_LEN) {
+            frame_errors++;
+        } else {
+            uint16_t len = fr_pos - 1 - FRAME_CRC_LEN;
+            uint16_t crc = CRC16_CCITT_Update(0xFFFF, &fr_seq, 1);
+            crc = CRC16_CCITT_Update(crc, CmdQueue_Current(), len);
+            Frame_Deliver(fr_seq, len, (uint16_t)(Frame_Byte(len) << 8 | Frame_Byte(len + 1)), crc);
+        }
+    }
+    COBS_DecodeReset(&fr_cobs);
+    fr_pos = 0;
+    fr_overflow = 0;
+}
+
+// === Feed received bytes ===
+uint16_t Frame_Receive(const uint8_t *data, uint16_t n) {
+    const uint8_t *start = data;
+
+    while (n) {
+        if (fr_pos == 0 && !fr_overflow && CmdQueue_Full()) break;    // Hold the next frame back
+
+        const uint8_t *end = memchr(data, 0, n);    // Frame boundary
+        uint16_t run = end ? (uint16_t)(end - data) : n;
+
+        for (uint16_t used = 0; used < run; ) {
+            const uint8_t *seg;
+            uint16_t seg_len;
+            used += COBS_DecodeNext(&fr_cobs, data + used, run - used, &seg, &seg_len);
+            Frame_Put(seg, seg_len);
+        }
+        if (!end) return (uint16_t)(data - start) + run;    // Frame continues in the next run
+
+        Frame_End();
+        data = end + 1;
+        n -= run + 1;
+    }
+    return (uint16_t)(data - start);
+}
+
+// === Send a frame ===
+uint8_t Frame_Send(const uint8_t *body, uint8_t len) {
+    uint8_t raw[1 + FRAME_TX_MAX + FRAME_CRC_LEN];
+    uint8_t enc[COBS_MAX_ENCODED(sizeof(raw)) + 1];
+
+    raw[0] = fr_tx_seq++;
+    memcpy(&raw[1], body, len);
+    uint16_t crc = CRC16_CCITT_Update(0xFFFF, raw, 1 + len);
+    raw[1 + len] = (uint8_t)(crc >> 8);
+    raw[2 + len] = (uint8_t)crc;
+
+    uint16_t n = COBS_Encode(raw, 1 + len + FRAME_CRC_LEN, enc);
+    enc[n++] = 0;                                   // Delimiter
+    return UART1_Write(enc, n) != 0;
+}
+
+#else
+// =====================================================================
+// SOF framing
+// =====================================================================
+typedef enum {
+    FR_HUNT,                        // Looking for SOF
+    FR_HEADER,                      // Collecting the rest of the header
+    FR_PACKET,                      // Copying the packet into the queue slot
+    FR_TRAILER                      // Collecting the CRC16
+} FrameState;
+
+static FrameState fr_state = FR_HUNT;
+static uint8_t fr_hdr[FRAME_HDR_LEN];       // Header bytes received so far
+static uint8_t fr_hdr_len;
+static uint16_t fr_len;                     // Packet length from the header
+static uint16_t fr_index;                   // Packet bytes received
+static uint16_t fr_crc;                     // Running CRC16
+static uint8_t fr_trailer[FRAME_CRC_LEN];
+static uint8_t fr_trailer_len;
+
+// Header CRC8 over Seq and Len
+static uint8_t Frame_HeaderCrc(const uint8_t *hdr) {
+    return CRC8_J1850_Update(0xFF, &hdr[1], 3) ^ 0xFF;
+}
+
+// A header is complete: check it, or look for the next SOF inside it
+static void Frame_CheckHeader(void) {
+    fr_len = (uint16_t)(fr_hdr[2] << 8 | fr_hdr[3]);
+
+    if (Frame_HeaderCrc(fr_hdr) == fr_hdr[4] && fr_len <= CMD_MAX_LEN) {
+        fr_crc = CRC16_CCITT_Update(0xFFFF, &fr_hdr[1], FRAME_HDR_LEN - 1);
+        fr_index = 0;
+        fr_trailer_len = 0;
+        fr_state = fr_len ? FR_PACKET : FR_TRAILER;     // An empty frame only carries Seq
+        return;
+    }
+
+    // False SOF or corrupted header: resume at the next SOF already received
+    frame_errors++;
+    const uint8_t *sof = memchr(&fr_hdr[1], FRAME_SOF, FRAME_HDR_LEN - 1);
+    if (!sof) {
+        fr_state = FR_HUNT;
+        return;
+    }
+    fr_hdr_len = (uint8_t)(fr_hdr + FRAME_HDR_LEN - sof);
+    memmove(fr_hdr, sof, fr_hdr_len);
+}
+
+// === Feed received bytes ===
+uint16_t Frame_Receive(const uint8_t *data, uint16_t n) {
+    const uint8_t *start = data;
+
+    while (n) {
+        switch (fr_state) {
+        case FR_HUNT: {
+            if (CmdQueue_Full()) return (uint16_t)(data - start);   // Hold the next frame back
+            const uint8_t *sof = memchr(data, FRAME_SOF, n);
+            if (!sof) return (uint16_t)(data - start) + n;          // Nothing but noise
+            n -= (uint16_t)(sof - data) + 1;
+            data = sof + 1;
+            fr_hdr[0] = FRAME_SOF;
+            fr_hdr_len = 1;
+            fr_state = FR_HEADER;
+            break;
+        }
+        case FR_HEADER:
+            fr_hdr[fr_hdr_len++] = *data++;
+            n--;
+            if (fr_hdr_len == FRAME_HDR_LEN) Frame_CheckHeader();
+            break;
+
+        case FR_PACKET: {
+            // The packet body is copied in one block, straight into its queue slot
+            uint16_t chunk = fr_len - fr_index;
+            if (chunk > n) chunk = n;
+            memcpy(CmdQueue_Current() + fr_index, data, chunk);
+            fr_crc = CRC16_CCITT_Update(fr_crc, data, chunk);
+            fr_index += chunk;
+            data += chunk;
+            n -= chunk;
+            if (fr_index == fr_len) {
+                fr_trailer_len = 0;
+                fr_state = FR_TRAILER;
+            }
+            break;
+        }
+        case FR_TRAILER:
+            fr_trailer[fr_trailer_len++] = *data++;
+            n--;
+            if (fr_trailer_len == FRAME_CRC_LEN) {
+                // The header was good, so a bad frame is skipped whole and the next one follows directly
+                fr_state = FR_HUNT;
+                Frame_Deliver(fr_hdr[1], fr_len, (uint16_t)(fr_trailer[0] << 8 | fr_trailer[1]), fr_crc);
+            }
+            break;
+        }
+    }
+    return (uint16_t)(data - start);
+}
+
+// === Send a frame ===
+uint8_t Frame_Send(const uint8_t *body, uint8_t len) {
+    uint8_t f[FRAME_WIRE_MAX] = { FRAME_SOF, fr_tx_seq++, 0, len, 0 };
+    f[4] = Frame_HeaderCrc(f);
+    memcpy(&f[FRAME_HDR_LEN], body, len);
+    uint16_t crc = CRC16_CCITT_Update(0xFFFF, &f[1], FRAME_HDR_LEN - 1 + len);
+    f[FRAME_HDR_LEN + len] = (uint8_t)(crc >> 8);
+    f[FRAME_HDR_LEN + len + 1] = (uint8_t)crc;
+
+    return UART1_Write(f, FRAME_HDR_LEN + len + FRAME_CRC_LEN) != 0;
+}
+#endif
+/*
+ * End of file
+ */
@@ -1,24 +1,39 @@
 /**********************************************************************************************
  * Include files                                                                              *
  *********************************************************************************************/
+#include "clock.h"          // 72 MHz system clock
 #include "can.h"            // CAN peripheral initialization and handling
 #include "uart.h"           // UART1 initialization and data transmission
 #include "delay.h"          // Delay function using SysTick
 #include "can_cyclic.h"     // CAN cyclic buffer management
-#include <can_buffer.h>     // CAN buffer structures
-#include <stdio.h>          // For sprintf()
+#include "config_store.h"   // Saved configuration in flash
+#include "command.h"        // PC command execution
+#include "timebase.h"       // Microsecond timer driving the cyclic scheduler
+#include "slcan.h"          // SLCAN (Lawicel) mode
+#include "can_forward.h"    // Received frames to the PC
+#include <can_buffer.h>     // Queue of received frames
+
+// Longest forwarding of one received frame in CPU cycles (read with the debugger)
+volatile uint32_t fwd_max_cycles = 0;
 
 /**********************************************************************************************
  * Main                                                                                       *
  *********************************************************************************************/
 int main(void) {
 
-    char buf[512];          // Buffer for formatted UART output
+    // Run from the 72 MHz PLL; every peripheral divider below is derived from it
+    Clock_Init();
 
     // Initialize CAN GPIOs and configuration
     CAN_GPIO_Init();
     CAN_Config();
 
+    // Apply bit rate, filter and cyclic schedule saved in flash
+    Config_Restore();
+
+    // Start the cyclic scheduler (runs from the TIM2 interrupt)
+    Timebase_Init();
+
     // Initialize UART1
     UART1_Init();
 
@@ -28,29 +43,28 @@ int main(void) {
     // Main loop
     while (1) {
 
-        // If a new CAN frame has been received
-        if (can_rx_flag) {
-            can_rx_flag = 0;    // Reset flag
-
-            // Format and send CAN ID and frame type (Std/Ext) over UART
-            sprintf(buf, "ID: 0x%03lX [%s], Data: ", rx_id, is_ext ? "Ext" : "Std");
-            UART1_SendString(buf);
+        // Forward the oldest received frame once the UART can take it; until then
+        // frames wait in the receive queue, whose overflow policy picks the losses
+        CanFrame rx;
+        if (CAN_Forward_Ready() && CAN_Buffer_Pop(&rx)) {
+            uint32_t start = DWT->CYCCNT;
 
-            // Send data bytes one by one in hexadecimal
-            for (int i = 0; i < rx_len; i++) {
-                sprintf(buf, "%02X ", rx_data[i]);
-                UART1_SendString(buf);
-            }
+            // Text line, record or SLCAN line as selected
+            CAN_Forward(rx.id, rx.is_ext, rx.data, rx.len, rx.time);
 
-            // Send newline
-            UART1_SendString("\r\n");
+            uint32_t cycles = DWT->CYCCNT - start;
+            if (cycles > fwd_max_cycles) fwd_max_cycles = cycles;
         }
 
-        // Update cyclic transmission list
-        CAN_Cyclic_Update();
+        // Send a batch of forwarded frames that has waited long enough, and the loss report
+        CAN_Forward_Poll();
 
-        // Small delay to reduce CPU load
-        delay_ms(10);
+        // Execute commands received from the PC
+#if SLCAN_MODE
+        SLCAN_Process();
+#else
+        Command_Process();
+#endif
     }
 
     return 0;
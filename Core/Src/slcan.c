@@ -0,0 +1,328 @@
+/*
+ * slcan.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "slcan.h"
+#include "cmd_queue.h"      // Received lines wait in the command queue
+#include "uart.h"           // Replies and received frames go out on USART1
+#include "can.h"            // Transmit and bit rate
+#include "can_cyclic.h"     // A saved schedule also transmits, from TIM2
+#include "can_buffer.h"     // Lost received frames for the status flags
+#include <string.h>         // For memchr / memcpy
+
+/*
+ * Protocol (Lawicel CAN232 / CANUSB subset)
+ *
+ * PC to device, each line ended by CR:
+ *   Sn          bit rate, n = 0..8 (10k 20k 50k 100k 125k 250k 500k 800k 1M), closed only
+ *   O / L / C   open / open listen-only / close the channel
+ *   tiiiLdd..   transmit standard frame (reply z)
+ *   TiiiiiiiiLdd..  transmit extended frame (reply Z)
+ *   Zn          timestamps off (0) / on (1)
+ *   Mxxxxxxxx / mxxxxxxxx  acceptance code / mask: accepted, no effect
+ *   F / V / N   status flags / version / serial number
+ * Every line is answered with CR when executed and BEL when not.
+ *
+ * Device to PC: received frames as t/T lines, followed by a 4-digit
+ * millisecond timestamp (0..59999) when enabled.
+ */
+#define SLCAN_OK        '\r'
+#define SLCAN_ERROR     '\a'
+#define SLCAN_TOO_LONG  1           // Queue flag: line overflowed and was cut
+
+// Channel states
+enum { SLCAN_CLOSED, SLCAN_OPEN, SLCAN_LISTEN };
+
+volatile uint32_t slcan_errors = 0;
+
+static uint8_t sl_state = SLCAN_CLOSED;
+static uint8_t sl_timestamps;               // Z1: append the time to received frames
+static uint32_t sl_lost;                    // CAN_Buffer_Lost at the last F
+static uint8_t sl_paused;                   // L paused the saved schedule
+
+// Receive side (interrupt)
+static uint16_t sl_len;                     // Characters of the current line
+static uint8_t sl_overflow;                 // Current line is longer than SLCAN_LINE_MAX
+
+static const char sl_hex[16] = "0123456789ABCDEF";
+
+// ASCII hex digit value + 1, indexed from '0'; 0 = not a hex digit
+static const uint8_t sl_nibble['f' - '0' + 1] = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10,                  // '0'..'9'
+    [ 'A' - '0' ] = 11, 12, 13, 14, 15, 16,         // 'A'..'F'
+    [ 'a' - '0' ] = 11, 12, 13, 14, 15, 16,         // 'a'..'f'
+};
+
+static const uint32_t sl_bitrates[] = {
+    10000, 20000, 50000, 100000, 125000, 250000, 500000, 800000, 1000000,
+};
+
+/*
+ * Frame layout shared by the parser and the formatter: type character and
+ * identifier digits, indexed by is_ext
+ */
+typedef struct {
+    char type;                  // Line type character
+    char reply;                 // Reply to a transmit request
+    uint8_t id_digits;          // Identifier width in hex digits
+    uint32_t id_max;            // Largest identifier
+} SlcanLayout;
+
+static const SlcanLayout sl_layouts[2] = {
+    { 't', 'z', 3, 0x7FF },
+    { 'T', 'Z', 8, 0x1FFFFFFF },
+};
+
+// Parse digits hex characters; 0 if one is not a hex digit
+static uint8_t SLCAN_Hex(const uint8_t *s, uint8_t digits, uint32_t *out) {
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < digits; i++) {
+        uint8_t c = (uint8_t)(s[i] - '0');
+        if (c >= sizeof(sl_nibble) || !sl_nibble[c]) return 0;
+        v = v << 4 | (uint32_t)(sl_nibble[c] - 1);
+    }
+    *out = v;
+    return 1;
+}
+
+// Write digits hex characters of v, most significant first
+static char *SLCAN_PutHex(char *p, uint32_t v, uint8_t digits) {
+    for (uint8_t i = digits; i-- > 0;) {
+        p[i] = sl_hex[v & 0xF];
+        v >>= 4;
+    }
+    return p + digits;
+}
+
+static void SLCAN_Send(const char *s, uint8_t n) {
+    UART1_Write((const uint8_t *)s, n);
+}
+
+// === Format a frame line ===
+uint8_t SLCAN_Format(char *out, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, int32_t timestamp) {
+    const SlcanLayout *l = &sl_layouts[is_ext ? 1 : 0];
+    char *p = out;
+
+    *p++ = l->type;
+    p = SLCAN_PutHex(p, id, l->id_digits);
+    *p++ = sl_hex[len & 0xF];
+    for (uint8_t i = 0; i < len; i++) p = SLCAN_PutHex(p, data[i], 2);
+    if (timestamp >= 0) p = SLCAN_PutHex(p, (uint32_t)timestamp, 4);
+    *p++ = '\r';
+    return (uint8_t)(p - out);
+}
+
+// =====================================================================
+// Command handlers: line without CR, return 1 to answer CR, 0 for BEL
+
+// t / T: transmit a data frame
+static uint8_t SLCAN_Transmit(const uint8_t *line, uint16_t n) {
+    const SlcanLayout *l = &sl_layouts[line[0] == 'T'];
+    uint8_t data[8] = { 0 };
+    uint32_t id, len, byte;
+
+    if (sl_state != SLCAN_OPEN) return 0;
+    if (n < 2u + l->id_digits || !SLCAN_Hex(&line[1], l->id_digits, &id) || id > l->id_max) return 0;
+    if (!SLCAN_Hex(&line[1 + l->id_digits], 1, &len) || len > 8 || n != 2u + l->id_digits + 2 * len) return 0;
+    for (uint8_t i = 0; i < len; i++) {
+        if (!SLCAN_Hex(&line[2 + l->id_digits + 2 * i], 2, &byte)) return 0;
+        data[i] = (uint8_t)byte;
+    }
+
+    CAN_Cyclic_Lock();                  // Scheduler could pick the same mailbox
+    if (line[0] == 'T') CAN_Send_EXT(id, data, (uint8_t)len);
+    else CAN_Send_STD((uint16_t)id, data, (uint8_t)len);
+    CAN_Cyclic_Unlock();
+    UART1_SendChar(l->reply);
+    return 1;
+}
+
+// Sn: bit rate from the standard table
+static uint8_t SLCAN_Bitrate(const uint8_t *line, uint16_t n) {
+    uint8_t i = (uint8_t)(line[1] - '0');
+    (void)n;
+    if (sl_state != SLCAN_CLOSED || i >= sizeof(sl_bitrates) / sizeof(sl_bitrates[0])) return 0;
+    CAN_Cyclic_Lock();
+    uint8_t ok = CAN_SetBitrate(sl_bitrates[i]);
+    CAN_Cyclic_Unlock();
+    return ok;
+}
+
+// O / L: open the channel. L puts the controller in silent mode, so the node
+// neither acknowledges nor transmits; a saved schedule is paused meanwhile, as
+// its frames could not leave the mailboxes
+static uint8_t SLCAN_Open(const uint8_t *line, uint16_t n) {
+    (void)n;
+    if (sl_state != SLCAN_CLOSED) return 0;
+    if (line[0] == 'L') {
+        CAN_Cyclic_Lock();
+        sl_paused = !CAN_Cyclic_Paused();
+        if (sl_paused) CAN_Cyclic_Pause();
+        CAN_SetSilent(1);
+        CAN_Cyclic_Unlock();
+        sl_state = SLCAN_LISTEN;
+    } else {
+        sl_state = SLCAN_OPEN;
+    }
+    return 1;
+}
+
+// C: close the channel (also accepted when closed; slcand sends it first)
+static uint8_t SLCAN_Close(const uint8_t *line, uint16_t n) {
+    (void)line;
+    (void)n;
+    if (sl_state == SLCAN_LISTEN) {
+        CAN_Cyclic_Lock();
+        CAN_SetSilent(0);
+        if (sl_paused) CAN_Cyclic_Resume();
+        sl_paused = 0;
+        CAN_Cyclic_Unlock();
+    }
+    sl_state = SLCAN_CLOSED;
+    return 1;
+}
+
+// Zn: timestamps on received frames
+static uint8_t SLCAN_Timestamps(const uint8_t *line, uint16_t n) {
+    (void)n;
+    if (line[1] != '0' && line[1] != '1') return 0;
+    sl_timestamps = (uint8_t)(line[1] - '0');
+    return 1;
+}
+
+// M / m: SJA1000 acceptance code and mask; the bxCAN filter is set by the
+// binary protocol only, so the values are checked and ignored
+static uint8_t SLCAN_Acceptance(const uint8_t *line, uint16_t n) {
+    uint32_t v;
+    (void)n;
+    return SLCAN_Hex(&line[1], 8, &v);
+}
+
+// F: status flags; 0x08 (data overrun) when received frames were lost since the last F
+static uint8_t SLCAN_Flags(const uint8_t *line, uint16_t n) {
+    uint32_t lost = CAN_Buffer_Lost();
+    char reply[3] = { 'F', '0', lost != sl_lost ? '8' : '0' };
+    (void)line;
+    (void)n;
+    sl_lost = lost;
+    SLCAN_Send(reply, 3);
+    return 1;
+}
+
+// V: hardware and software version
+static uint8_t SLCAN_Version(const uint8_t *line, uint16_t n) {
+    (void)line;
+    (void)n;
+    SLCAN_Send("V0101", 5);
+    return 1;
+}
+
+// N: serial number
+static uint8_t SLCAN_Serial(const uint8_t *line, uint16_t n) {
+    (void)line;
+    (void)n;
+    SLCAN_Send("N" SLCAN_SERIAL, 5);
+    return 1;
+}
+
+/*
+ * Command table: first character, accepted line length (without CR) and handler
+ */
+typedef struct {
+    char cmd;
+    uint8_t min_len;
+    uint8_t max_len;
+    uint8_t (*handler)(const uint8_t *line, uint16_t n);
+} SlcanCommand;
+
+static const SlcanCommand sl_commands[] = {
+    { 't', 5,  21, SLCAN_Transmit },
+    { 'T', 10, 26, SLCAN_Transmit },
+    { 'S', 2,  2,  SLCAN_Bitrate },
+    { 'O', 1,  1,  SLCAN_Open },
+    { 'L', 1,  1,  SLCAN_Open },
+    { 'C', 1,  1,  SLCAN_Close },
+    { 'Z', 2,  2,  SLCAN_Timestamps },
+    { 'M', 9,  9,  SLCAN_Acceptance },
+    { 'm', 9,  9,  SLCAN_Acceptance },
+    { 'F', 1,  1,  SLCAN_Flags },
+    { 'V', 1,  1,  SLCAN_Version },
+    { 'N', 1,  1,  SLCAN_Serial },
+};
+
+// Look the command up and run it
+static uint8_t SLCAN_Execute(const uint8_t *line, uint16_t n) {
+    while (n && *line == '\n') {                    // LF left over from a CR LF line end
+        line++;
+        n--;
+    }
+    if (n == 0) return 1;                           // Empty line: just CR
+
+    for (uint8_t i = 0; i < sizeof(sl_commands) / sizeof(sl_commands[0]); i++) {
+        const SlcanCommand *c = &sl_commands[i];
+        if (c->cmd == (char)line[0]) return n >= c->min_len && n <= c->max_len && c->handler(line, n);
+    }
+    return 0;
+}
+
+// === Collect lines into the command queue (interrupt) ===
+uint16_t SLCAN_Receive(const uint8_t *data, uint16_t n) {
+    const uint8_t *start = data;
+    const uint8_t *end = data + n;
+
+    while (data < end) {
+        if (sl_len == 0 && !sl_overflow && CmdQueue_Full()) break;     // Hold the next line back
+
+        const uint8_t *cr = memchr(data, '\r', (size_t)(end - data));
+        uint16_t chunk = (uint16_t)((cr ? cr : end) - data);
+        if (sl_len + chunk > SLCAN_LINE_MAX - 1) {
+            sl_overflow = 1;                         // Keep reading up to the CR, then refuse the line
+        } else {
+            memcpy(CmdQueue_Current() + sl_len, data, chunk);
+            sl_len += chunk;
+        }
+        data += chunk;
+
+        if (cr) {
+            data++;
+            CmdQueue_Push(sl_overflow ? 0 : sl_len, sl_overflow ? SLCAN_TOO_LONG : 0);
+            sl_len = 0;
+            sl_overflow = 0;
+        }
+    }
+    return (uint16_t)(data - start);
+}
+
+// === Execute queued lines (main loop) ===
+void SLCAN_Process(void) {
+    uint16_t len;
+    uint8_t flags;
+    uint8_t *line;
+
+    while ((line = CmdQueue_Peek(&len, &flags)) != 0) {
+        UART1_TxWait(SLCAN_LINE_MAX);               // Room for the reply: it must not be dropped
+        uint8_t ok = (flags != SLCAN_TOO_LONG) && SLCAN_Execute(line, len);
+        CmdQueue_Pop();
+        UART1_RxResume();                           // A slot is free for lines held in the UART buffer
+
+        if (!ok) slcan_errors++;
+        UART1_SendChar(ok ? SLCAN_OK : SLCAN_ERROR);
+    }
+}
+
+// === Forward a received frame (dropped whole if the transmit ring is full) ===
+void SLCAN_Forward(uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len, uint32_t rx_us) {
+    char line[SLCAN_LINE_MAX];
+
+    if (sl_state == SLCAN_CLOSED) return;
+    int32_t ms = sl_timestamps ? (int32_t)((rx_us / 1000u) % 60000u) : -1;
+    SLCAN_Send(line, SLCAN_Format(line, id, is_ext, data, len, ms));
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,103 @@
+/*
+ * timebase.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "timebase.h"
+#include "can_cyclic.h"     // Alarm runs the cyclic scheduler
+#include "clock.h"          // Timer input clock
+
+#define TIMEBASE_HZ        1000000u     // 1 tick = 1 us
+#define TIMEBASE_IRQ_PRIO  2            // Below USART1 and CAN RX
+
+static volatile uint32_t tb_high = 0;   // Upper 16 bits of the time, in units of 0x10000
+static volatile uint32_t tb_alarm;      // Alarm deadline
+static volatile uint8_t tb_armed = 0;   // 1 while an alarm is pending
+
+// === TIM2 setup: PA-free, internal clock only ===
+void Timebase_Init(void) {
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;  // Enable TIM2 clock
+
+    TIM2->CR1 = 0;
+    TIM2->PSC = Clock_TimerAPB1() / TIMEBASE_HZ - 1;    // 1 MHz count
+    TIM2->ARR = 0xFFFF;                      // Full 16-bit range
+    TIM2->CCMR1 = 0;                         // Channel 1: output compare, frozen (flag only)
+    TIM2->EGR = TIM_EGR_UG;                  // Load prescaler
+    TIM2->SR = 0;
+    TIM2->DIER = TIM_DIER_UIE;               // Overflow extends the count
+    TIM2->CR1 = TIM_CR1_CEN;
+
+    NVIC_SetPriority(TIM2_IRQn, TIMEBASE_IRQ_PRIO);
+    NVIC_EnableIRQ(TIM2_IRQn);
+    Timebase_Kick();                         // First scheduler pass sets the real alarm
+}
+
+// === 32-bit microsecond time ===
+uint32_t Timebase_Now(void) {
+    uint32_t high, low;
+    do {
+        high = tb_high;
+        low = TIM2->CNT;
+        // Overflow that the ISR has not counted yet (TIM2 masked, in the ISR or in
+        // an interrupt that preempted it)
+        if ((TIM2->SR & TIM_SR_UIF) && low < 0x8000) high += 0x10000;
+    } while (high != tb_high);
+    return high | low;
+}
+
+// === Program the compare channel for the next deadline ===
+void Timebase_SetAlarm(uint32_t deadline) {
+    tb_alarm = deadline;
+    tb_armed = 1;
+
+    int32_t delta = (int32_t)(deadline - Timebase_Now());
+    if (delta > 0 && delta < 0x10000) {
+        TIM2->CCR1 = (uint16_t)deadline;
+        TIM2->SR = ~TIM_SR_CC1IF;
+        TIM2->DIER |= TIM_DIER_CC1IE;
+        delta = (int32_t)(deadline - Timebase_Now());  // Deadline may have passed while programming
+    } else {
+        TIM2->DIER &= ~TIM_DIER_CC1IE;               // Far away: re-checked on every overflow
+    }
+    if (delta <= 0) NVIC_SetPendingIRQ(TIM2_IRQn);
+}
+
+// === Force a scheduler pass ===
+void Timebase_Kick(void) {
+    tb_alarm = Timebase_Now();
+    tb_armed = 1;
+    NVIC_SetPendingIRQ(TIM2_IRQn);
+}
+
+// === TIM2 interrupt ===
+void TIM2_IRQHandler(void) {
+    uint32_t sr = TIM2->SR;
+
+    if (sr & TIM_SR_UIF) {
+        // Timebase_Now in a higher priority interrupt (CAN RX time stamps) must
+        // not see the flag cleared before the overflow is counted
+        __disable_irq();
+        TIM2->SR = ~TIM_SR_UIF;
+        tb_high += 0x10000;
+        __enable_irq();
+    }
+    if (sr & TIM_SR_CC1IF) {
+        TIM2->SR = ~TIM_SR_CC1IF;
+        TIM2->DIER &= ~TIM_DIER_CC1IE;             // One-shot
+    }
+
+    if (!tb_armed) return;
+    if ((int32_t)(tb_alarm - Timebase_Now()) <= 0) {
+        tb_armed = 0;
+        CAN_Cyclic_Update();                         // Sends due messages and sets the next alarm
+    } else if (!(TIM2->DIER & TIM_DIER_CC1IE)) {
+        Timebase_SetAlarm(tb_alarm);                 // Deadline now within compare range?
+    }
+}
+/*
+ * End of file
+ */
@@ -8,14 +8,32 @@
  * Include files
  */
 #include "uart.h"
-#include "can_cyclic.h"
+#include "frame.h"          // Received bytes go to the deframer
+#include "slcan.h"          // ... or to the SLCAN line collector
+#include "clock.h"          // APB2 clock for the baud rate
+#include "stm32f1xx_ll_dma.h"   // DMA1 channel 4 / 5 register access
+#include <string.h>         // For memcpy / strlen
 
-#define UART_BUFFER_SIZE 300                         // Maximum size of UART receive buffer
+#define UART_RX_IRQ_PRIO 0                           // USART1 and its DMA channel never preempt each other
+#define UART_TX_IRQ_PRIO 3                           // Chaining the next segment can wait for everything else
+#define UART_TX_MASK (UART_TX_RING_SIZE - 1)
 
-uint8_t rx_buffer[UART_BUFFER_SIZE];                 // Receive buffer
-volatile uint8_t rx_index = 0;                       // Current receive index
+static uint8_t rx_ring[UART_RX_RING_SIZE];           // Written by DMA1 channel 5 in circular mode
+static uint16_t rx_tail = 0;                         // Next ring byte to parse
 
-volatile uint8_t uart_rx_complete_flag = 0;          // Flag to indicate full message received
+volatile uint32_t uart_isr_max_cycles = 0;           // Longest USART1 ISR run (CPU cycles)
+volatile uint32_t uart_rx_overruns = 0;              // Bytes lost to USART overrun
+volatile uint32_t uart_rx_dropped = 0;               // Bytes discarded while the command queue was full
+volatile uint32_t uart_rx_stalls = 0;                // Times RTS held the PC back
+static volatile uint8_t rx_stalled = 0;              // Received bytes wait in the ring for a command slot
+
+// Transmit ring; free-running indices, head written by the main loop only, tail by the DMA ISR only
+static uint8_t tx_ring[UART_TX_RING_SIZE];
+static volatile uint16_t tx_head = 0;                // Next byte to queue
+static volatile uint16_t tx_tail = 0;                // Oldest byte not sent yet
+static volatile uint16_t tx_busy = 0;                // Length of the segment DMA1 channel 4 is sending
+volatile uint32_t uart_tx_dropped = 0;               // Bytes refused because the ring was full
+volatile uint16_t uart_tx_peak = 0;                  // Highest ring fill
 
 // === UART1 Initialization: PA9 (TX), PA10 (RX) ===
 void UART1_Init(void) {
@@ -30,33 +48,114 @@ void UART1_Init(void) {
     GPIOA->CRH &= ~(GPIO_CRH_MODE10 | GPIO_CRH_CNF10);
     GPIOA->CRH |= (0b10 << GPIO_CRH_CNF10_Pos);
 
-    // Set baud rate for 115200 bps (assuming 8 MHz clock)
-    USART1->BRR = 8000000 / 115200;
+#if UART_FLOW_CONTROL
+    // PA11 = CTS input with pull-down (an unconnected CTS does not block TX)
+    GPIOA->CRH &= ~(GPIO_CRH_MODE11 | GPIO_CRH_CNF11);
+    GPIOA->CRH |= (0b10 << GPIO_CRH_CNF11_Pos);
+    GPIOA->BRR = (1 << 11);
+
+    // PA12 = RTS, driven by software from the receive buffer state, low = ready
+    GPIOA->BRR = (1 << 12);
+    GPIOA->CRH &= ~(GPIO_CRH_MODE12 | GPIO_CRH_CNF12);
+    GPIOA->CRH |= (0b10 << GPIO_CRH_MODE12_Pos);                    // Push-pull output, 2 MHz
+#endif
+
+    // Baud rate divider from the APB2 clock, in 1/16 steps, rounded to nearest
+    USART1->BRR = (Clock_PCLK2() + UART_BAUDRATE / 2) / UART_BAUDRATE;
+
+    // RX DMA: DMA1 channel 5 copies every byte from DR into the ring, wrapping forever
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+    LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_5);
+    LL_DMA_ConfigTransfer(DMA1, LL_DMA_CHANNEL_5,
+                          LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_MODE_CIRCULAR |
+                          LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                          LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE | LL_DMA_PRIORITY_HIGH);
+    LL_DMA_ConfigAddresses(DMA1, LL_DMA_CHANNEL_5, (uint32_t)&USART1->DR, (uint32_t)rx_ring,
+                           LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+    LL_DMA_SetDataLength(DMA1, LL_DMA_CHANNEL_5, UART_RX_RING_SIZE);
+    LL_DMA_EnableIT_HT(DMA1, LL_DMA_CHANNEL_5);      // Half of the ring filled
+    LL_DMA_EnableIT_TC(DMA1, LL_DMA_CHANNEL_5);      // Ring wrapped
+    LL_DMA_EnableChannel(DMA1, LL_DMA_CHANNEL_5);
+
+    // TX DMA: DMA1 channel 4 sends one contiguous ring segment per transfer
+    LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_4);
+    LL_DMA_ConfigTransfer(DMA1, LL_DMA_CHANNEL_4,
+                          LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_MODE_NORMAL |
+                          LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                          LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE | LL_DMA_PRIORITY_MEDIUM);
+    LL_DMA_SetPeriphAddress(DMA1, LL_DMA_CHANNEL_4, (uint32_t)&USART1->DR);
+    LL_DMA_EnableIT_TC(DMA1, LL_DMA_CHANNEL_4);
+
+    // Receive and transmit through DMA, interrupt on overrun
+    USART1->CR3 = USART_CR3_DMAR | USART_CR3_DMAT | USART_CR3_EIE;
+#if UART_FLOW_CONTROL
+    USART1->CR3 |= USART_CR3_CTSE;                   // Transmitter waits while the PC holds CTS high
+#endif
 
-    // Enable Transmitter, Receiver, RX interrupt, and USART module
-    USART1->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE | USART_CR1_UE;
+    // Enable Transmitter, Receiver, idle-line interrupt (end of a burst), and USART module
+    USART1->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_IDLEIE | USART_CR1_UE;
 
-    // Enable USART1 interrupt in NVIC
+    // Start the cycle counter used to measure ISR time
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // Enable USART1 and DMA interrupts in NVIC
+    NVIC_SetPriority(USART1_IRQn, UART_RX_IRQ_PRIO);
+    NVIC_SetPriority(DMA1_Channel5_IRQn, UART_RX_IRQ_PRIO);
+    NVIC_SetPriority(DMA1_Channel4_IRQn, UART_TX_IRQ_PRIO);
     NVIC_EnableIRQ(USART1_IRQn);
+    NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+    NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+}
+
+// === Free space in the transmit ring ===
+uint16_t UART1_TxFree(void) {
+    return (uint16_t)(UART_TX_RING_SIZE - (uint16_t)(tx_head - tx_tail));
+}
+
+// === Wait for room in the transmit ring ===
+void UART1_TxWait(uint16_t n) {
+    while (UART1_TxFree() < n);                     // The DMA ISR frees space
+}
+
+// === Queue bytes for transmission ===
+uint16_t UART1_Write(const uint8_t *data, uint16_t n) {
+    uint16_t head = tx_head;
+    uint16_t used = (uint16_t)(head - tx_tail);
+
+    if (n > UART_TX_RING_SIZE - used) {
+        uart_tx_dropped += n;                        // All or nothing: never send a partial line
+        return 0;
+    }
+
+    // Copy in up to two pieces around the end of the ring
+    uint16_t pos = head & UART_TX_MASK;
+    uint16_t first = (n < UART_TX_RING_SIZE - pos) ? n : (uint16_t)(UART_TX_RING_SIZE - pos);
+    memcpy(&tx_ring[pos], data, first);
+    memcpy(tx_ring, data + first, n - first);
+
+    __DMB();                                         // Bytes in the ring before the index moves
+    tx_head = (uint16_t)(head + n);
+    if (used + n > uart_tx_peak) uart_tx_peak = used + n;
+
+    // Only the ISR starts transfers, so it never races the main loop for the channel
+    if (!tx_busy) NVIC_SetPendingIRQ(DMA1_Channel4_IRQn);
+    return n;
 }
 
 // === Send a single character via UART1 ===
-void UART1_SendChar(char c) {
-    while (!(USART1->SR & USART_SR_TXE));           // Wait until transmit buffer is empty
-    USART1->DR = c;                                  // Send character
+uint8_t UART1_SendChar(char c) {
+    return UART1_Write((const uint8_t *)&c, 1) != 0;
 }
 
 // === Send a null-terminated string via UART1 ===
-void UART1_SendString(const char *s) {
-    while (*s) UART1_SendChar(*s++);                // Send characters one by one
+uint16_t UART1_SendString(const char *s) {
+    return UART1_Write((const uint8_t *)s, (uint16_t)strlen(s));
 }
 
 // === Send raw byte array via UART1 ===
-void UART1_SendRawBytes(uint8_t *data, uint16_t length) {
-    for (uint16_t i = 0; i < length; i++) {
-        while (!(USART1->SR & USART_SR_TXE));       // Wait until ready to transmit
-        USART1->DR = data[i];                        // Send byte
-    }
+uint16_t UART1_SendRawBytes(uint8_t *data, uint16_t length) {
+    return UART1_Write(data, length);
 }
 
 // === Receive a single character (blocking) ===
@@ -65,41 +164,99 @@ char UART1_ReceiveChar(void) {
     return USART1->DR;                               // Return received character
 }
 
+// Hand the ring up to end to the deframer; 0 if it stopped early because the command queue is full
+static uint8_t UART1_Feed(uint16_t end) {
+    uint16_t n = end - rx_tail;
+#if SLCAN_MODE
+    uint16_t used = SLCAN_Receive(&rx_ring[rx_tail], n);
+#else
+    uint16_t used = Frame_Receive(&rx_ring[rx_tail], n);
+#endif
+
+#if UART_FLOW_CONTROL
+    rx_tail = (rx_tail + used) % UART_RX_RING_SIZE;  // The rest stays in the ring, RTS holds the PC
+#else
+    uart_rx_dropped += n - used;                     // Nobody waits for us: discard the rest
+    rx_tail = end % UART_RX_RING_SIZE;
+#endif
+    return used == n;
+}
+
+// Parse everything the DMA wrote since the last call
+static void UART1_DrainRx(void) {
+    uint16_t head = UART_RX_RING_SIZE - LL_DMA_GetDataLength(DMA1, LL_DMA_CHANNEL_5);
+    if (head >= UART_RX_RING_SIZE) head = 0;        // Counter reloading at the wrap
+
+    uint8_t done = 1;
+    if (head < rx_tail) done = UART1_Feed(UART_RX_RING_SIZE);   // Up to the end of the ring
+    if (done) done = UART1_Feed(head);
+
+#if UART_FLOW_CONTROL
+    if (!done && !rx_stalled) uart_rx_stalls++;
+    GPIOA->BSRR = done ? GPIO_BSRR_BR12 : GPIO_BSRR_BS12;   // RTS high while bytes are held
+#endif
+    rx_stalled = !done;
+}
+
+// === Restart a receiver held back by a full command queue ===
+void UART1_RxResume(void) {
+    if (rx_stalled) NVIC_SetPendingIRQ(DMA1_Channel5_IRQn);  // Drain again at interrupt level
+}
+
+// Keep the longest receive interrupt run
+static void UART1_TrackCycles(uint32_t start) {
+    uint32_t cycles = DWT->CYCCNT - start;
+    if (cycles > uart_isr_max_cycles) uart_isr_max_cycles = cycles;
+}
+
 // === USART1 Interrupt Service Routine ===
+// Idle line after a burst (or overrun): hand the received bytes to the deframer.
+// Packets are executed by Command_Process().
 void USART1_IRQHandler(void) {
-    if (USART1->SR & USART_SR_RXNE) {               // Check if RX register is not empty
-        uint8_t byte = USART1->DR;                  // Read received byte
-
-        // Store byte into buffer if within bounds
-        if (rx_index < UART_BUFFER_SIZE) {
-            rx_buffer[rx_index++] = byte;
-        }
-
-        // Check if at least header part is received
-        if (rx_index >= 4) {
-            uint8_t model = rx_buffer[0];           // Determine model type (0 = STD, 1 = EXT)
-            uint8_t len = (model == 0) ? rx_buffer[3] : rx_buffer[5];    // Get data length
-            uint8_t header_len = (model == 0) ? 4 : 6;                    // Determine header size
-            uint16_t total_len = header_len + len + 2;                   // Total expected length (+2 bytes for cyclic)
-
-            // If full packet received
-            if (rx_index >= total_len) {
-                // Extract CAN ID
-                uint32_t id = (model == 0)
-                    ? (rx_buffer[1] << 8 | rx_buffer[2])                        // STD ID: 11-bit
-                    : ((uint32_t)rx_buffer[1] << 24 | (uint32_t)rx_buffer[2] << 16 |
-                       (uint32_t)rx_buffer[3] << 8 | (uint32_t)rx_buffer[4]);   // EXT ID: 29-bit
-
-                uint8_t* data = &rx_buffer[header_len];                         // Pointer to data field
-                uint16_t cyclic = rx_buffer[total_len - 2] << 8 | rx_buffer[total_len - 1]; // CRC/cyclic value
-
-                // Add or update entry in CAN cyclic buffer
-                CAN_Cyclic_AddOrUpdate(model, id, data, len, cyclic);
-
-                rx_index = 0;  // Reset buffer index after successful parse
-            }
-        }
+    uint32_t start = DWT->CYCCNT;
+    uint32_t sr = USART1->SR;
+
+    if (sr & (USART_SR_IDLE | USART_SR_ORE)) {
+        (void)USART1->DR;                           // SR then DR read clears IDLE / ORE
+        if (sr & USART_SR_ORE) uart_rx_overruns++;
+        UART1_DrainRx();
     }
+
+    UART1_TrackCycles(start);
+}
+
+// === DMA1 Channel 5 Interrupt Service Routine ===
+// Half / full ring: drain long bursts before the DMA laps the parser.
+void DMA1_Channel5_IRQHandler(void) {
+    uint32_t start = DWT->CYCCNT;
+
+    if (LL_DMA_IsActiveFlag_HT5(DMA1)) LL_DMA_ClearFlag_HT5(DMA1);
+    if (LL_DMA_IsActiveFlag_TC5(DMA1)) LL_DMA_ClearFlag_TC5(DMA1);
+    UART1_DrainRx();
+
+    UART1_TrackCycles(start);
+}
+
+// === DMA1 Channel 4 Interrupt Service Routine ===
+// Segment sent (or kicked by UART1_Write): release it and start the next contiguous one.
+void DMA1_Channel4_IRQHandler(void) {
+    if (LL_DMA_IsActiveFlag_TC4(DMA1)) {
+        LL_DMA_ClearFlag_TC4(DMA1);
+        tx_tail = (uint16_t)(tx_tail + tx_busy);
+        tx_busy = 0;
+    }
+    if (tx_busy) return;                            // Kicked while a segment is still going out
+
+    uint16_t queued = (uint16_t)(tx_head - tx_tail);
+    if (queued == 0) return;
+
+    uint16_t pos = tx_tail & UART_TX_MASK;
+    uint16_t len = (queued < UART_TX_RING_SIZE - pos) ? queued : (uint16_t)(UART_TX_RING_SIZE - pos);
+    tx_busy = len;
+    LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_4);
+    LL_DMA_SetMemoryAddress(DMA1, LL_DMA_CHANNEL_4, (uint32_t)&tx_ring[pos]);
+    LL_DMA_SetDataLength(DMA1, LL_DMA_CHANNEL_4, len);
+    LL_DMA_EnableChannel(DMA1, LL_DMA_CHANNEL_4);
 }
 /*
  * End of file
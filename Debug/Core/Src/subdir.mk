@@ -8,39 +8,84 @@ C_SRCS += \
 ../Core/Src/can.c \
 ../Core/Src/can_buffer.c \
 ../Core/Src/can_cyclic.c \
+../Core/Src/can_dict.c \
+../Core/Src/can_forward.c \
+../Core/Src/can_record.c \
+../Core/Src/can_text.c \
+../Core/Src/clock.c \
+../Core/Src/cmd_queue.c \
+../Core/Src/cobs.c \
+../Core/Src/command.c \
+../Core/Src/config_store.c \
+../Core/Src/crc.c \
 ../Core/Src/delay.c \
+../Core/Src/flash_store.c \
+../Core/Src/frame.c \
 ../Core/Src/main.c \
+../Core/Src/signal_gen.c \
+../Core/Src/slcan.c \
 ../Core/Src/stm32f1xx_hal_msp.c \
 ../Core/Src/stm32f1xx_it.c \
 ../Core/Src/syscalls.c \
 ../Core/Src/sysmem.c \
 ../Core/Src/system_stm32f1xx.c \
+../Core/Src/timebase.c \
 ../Core/Src/uart.c 
 
 OBJS += \
 ./Core/Src/can.o \
 ./Core/Src/can_buffer.o \
 ./Core/Src/can_cyclic.o \
+./Core/Src/can_dict.o \
+./Core/Src/can_forward.o \
+./Core/Src/can_record.o \
+./Core/Src/can_text.o \
+./Core/Src/clock.o \
+./Core/Src/cmd_queue.o \
+./Core/Src/cobs.o \
+./Core/Src/command.o \
+./Core/Src/config_store.o \
+./Core/Src/crc.o \
 ./Core/Src/delay.o \
+./Core/Src/flash_store.o \
+./Core/Src/frame.o \
 ./Core/Src/main.o \
+./Core/Src/signal_gen.o \
+./Core/Src/slcan.o \
 ./Core/Src/stm32f1xx_hal_msp.o \
 ./Core/Src/stm32f1xx_it.o \
 ./Core/Src/syscalls.o \
 ./Core/Src/sysmem.o \
 ./Core/Src/system_stm32f1xx.o \
+./Core/Src/timebase.o \
 ./Core/Src/uart.o 
 
 C_DEPS += \
 ./Core/Src/can.d \
 ./Core/Src/can_buffer.d \
 ./Core/Src/can_cyclic.d \
+./Core/Src/can_dict.d \
+./Core/Src/can_forward.d \
+./Core/Src/can_record.d \
+./Core/Src/can_text.d \
+./Core/Src/clock.d \
+./Core/Src/cmd_queue.d \
+./Core/Src/cobs.d \
+./Core/Src/command.d \
+./Core/Src/config_store.d \
+./Core/Src/crc.d \
 ./Core/Src/delay.d \
+./Core/Src/flash_store.d \
+./Core/Src/frame.d \
 ./Core/Src/main.d \
+./Core/Src/signal_gen.d \
+./Core/Src/slcan.d \
 ./Core/Src/stm32f1xx_hal_msp.d \
 ./Core/Src/stm32f1xx_it.d \
 ./Core/Src/syscalls.d \
 ./Core/Src/sysmem.d \
 ./Core/Src/system_stm32f1xx.d \
+./Core/Src/timebase.d \
 ./Core/Src/uart.d 
 
 
@@ -51,7 +96,7 @@ Core/Src/%.o Core/Src/%.su Core/Src/%.cyclo: ../Core/Src/%.c Core/Src/subdir.mk
 clean: clean-Core-2f-Src
 
 clean-Core-2f-Src:
-	-$(RM) ./Core/Src/can.cyclo ./Core/Src/can.d ./Core/Src/can.o ./Core/Src/can.su ./Core/Src/can_buffer.cyclo ./Core/Src/can_buffer.d ./Core/Src/can_buffer.o ./Core/Src/can_buffer.su ./Core/Src/can_cyclic.cyclo ./Core/Src/can_cyclic.d ./Core/Src/can_cyclic.o ./Core/Src/can_cyclic.su ./Core/Src/delay.cyclo ./Core/Src/delay.d ./Core/Src/delay.o ./Core/Src/delay.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/stm32f1xx_hal_msp.cyclo ./Core/Src/stm32f1xx_hal_msp.d ./Core/Src/stm32f1xx_hal_msp.o ./Core/Src/stm32f1xx_hal_msp.su ./Core/Src/stm32f1xx_it.cyclo ./Core/Src/stm32f1xx_it.d ./Core/Src/stm32f1xx_it.o ./Core/Src/stm32f1xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f1xx.cyclo ./Core/Src/system_stm32f1xx.d ./Core/Src/system_stm32f1xx.o ./Core/Src/system_stm32f1xx.su ./Core/Src/uart.cyclo ./Core/Src/uart.d ./Core/Src/uart.o ./Core/Src/uart.su
+	-$(RM) ./Core/Src/can.cyclo ./Core/Src/can.d ./Core/Src/can.o ./Core/Src/can.su ./Core/Src/can_buffer.cyclo ./Core/Src/can_buffer.d ./Core/Src/can_buffer.o ./Core/Src/can_buffer.su ./Core/Src/can_cyclic.cyclo ./Core/Src/can_cyclic.d ./Core/Src/can_cyclic.o ./Core/Src/can_cyclic.su ./Core/Src/can_dict.cyclo ./Core/Src/can_dict.d ./Core/Src/can_dict.o ./Core/Src/can_dict.su ./Core/Src/can_forward.cyclo ./Core/Src/can_forward.d ./Core/Src/can_forward.o ./Core/Src/can_forward.su ./Core/Src/can_record.cyclo ./Core/Src/can_record.d ./Core/Src/can_record.o ./Core/Src/can_record.su ./Core/Src/can_text.cyclo ./Core/Src/can_text.d ./Core/Src/can_text.o ./Core/Src/can_text.su ./Core/Src/clock.cyclo ./Core/Src/clock.d ./Core/Src/clock.o ./Core/Src/clock.su ./Core/Src/cmd_queue.cyclo ./Core/Src/cmd_queue.d ./Core/Src/cmd_queue.o ./Core/Src/cmd_queue.su ./Core/Src/cobs.cyclo ./Core/Src/cobs.d ./Core/Src/cobs.o ./Core/Src/cobs.su ./Core/Src/command.cyclo ./Core/Src/command.d ./Core/Src/command.o ./Core/Src/command.su ./Core/Src/config_store.cyclo ./Core/Src/config_store.d ./Core/Src/config_store.o ./Core/Src/config_store.su ./Core/Src/crc.cyclo ./Core/Src/crc.d ./Core/Src/crc.o ./Core/Src/crc.su ./Core/Src/delay.cyclo ./Core/Src/delay.d ./Core/Src/delay.o ./Core/Src/delay.su ./Core/Src/flash_store.cyclo ./Core/Src/flash_store.d ./Core/Src/flash_store.o ./Core/Src/flash_store.su ./Core/Src/frame.cyclo ./Core/Src/frame.d ./Core/Src/frame.o ./Core/Src/frame.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/signal_gen.cyclo ./Core/Src/signal_gen.d ./Core/Src/signal_gen.o ./Core/Src/signal_gen.su ./Core/Src/slcan.cyclo ./Core/Src/slcan.d ./Core/Src/slcan.o ./Core/Src/slcan.su ./Core/Src/stm32f1xx_hal_msp.cyclo ./Core/Src/stm32f1xx_hal_msp.d ./Core/Src/stm32f1xx_hal_msp.o ./Core/Src/stm32f1xx_hal_msp.su ./Core/Src/stm32f1xx_it.cyclo ./Core/Src/stm32f1xx_it.d ./Core/Src/stm32f1xx_it.o ./Core/Src/stm32f1xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f1xx.cyclo ./Core/Src/system_stm32f1xx.d ./Core/Src/system_stm32f1xx.o ./Core/Src/system_stm32f1xx.su ./Core/Src/timebase.cyclo ./Core/Src/timebase.d ./Core/Src/timebase.o ./Core/Src/timebase.su ./Core/Src/uart.cyclo ./Core/Src/uart.d ./Core/Src/uart.o ./Core/Src/uart.su
 
 .PHONY: clean-Core-2f-Src
 
@@ -0,0 +1,258 @@
+/*
+ * bridge_dump.cpp
+ * @brief   Command line front end: optionally selects the output format of the
+ *          forwarded CAN frames (packet 0x14) and the overflow policy of the
+ *          receive queue (0x16), then decodes everything the bridge sends:
+ *          dictionary-coded, compact or full records and text lines, one line
+ *          per frame in candump style, and the loss reports on stderr. A
+ *          capture of the port can be decoded offline.
+ *
+ *          bridge_dump [options] <port>
+ *          bridge_dump [-c] -i <capture>
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "link.hpp"
+#include "serial.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+using namespace bridge_link;
+
+static volatile std::sig_atomic_t stop = 0;
+
+static void Usage(void) {
+    std::fprintf(stderr,
+        "usage: bridge_dump [options] <port>\n"
+        "       bridge_dump [-c] -i <capture>\n"
+        "  -f <format>     select the output format first: 0 text lines / full records,\n"
+        "                  1 compact records, 2 batches of compact records,\n"
+        "                  3 batches of dictionary-coded records\n"
+        "  -T              records with timestamps (with -f 1 to 3)\n"
+        "  -B <bytes>      send a batch once it holds this many bytes (1-64)\n"
+        "  -W <us>         send a batch at the latest this long after its first frame\n"
+        "  -P <policy>     when the receive queue is full: 0 drop the newest frame,\n"
+        "                  1 drop the oldest, 2 keep the latest per ID (default)\n"
+        "  -R <ms>         loss report period (default 1000, 0 = off)\n"
+        "  -b <bit/s>      UART bit rate (default 921600)\n"
+        "  -s <seq>        sequence number of the window restart (default 0)\n"
+        "  -c              COBS framing (firmware built with FRAME_COBS=1)\n"
+        "  -r              RTS/CTS flow control (firmware built with UART_FLOW_CONTROL=1)\n"
+        "  -i <capture>    decode raw bytes saved from the port instead\n"
+        "frames received and link bytes per frame are printed on exit (Ctrl-C)\n");
+}
+
+// Parse a numeric option
+static bool ParseU32(const char *text, uint32_t &out) {
+    char *end;
+    unsigned long v = std::strtoul(text, &end, 0);
+    if (*text == '\0' || *end != '\0' || v > 0xFFFFFFFFul) return false;
+    out = (uint32_t)v;
+    return true;
+}
+
+// Decodes and prints the device output
+class Printer {
+public:
+    explicit Printer(bool cobs) : rx_(cobs) {}
+
+    // Feed port bytes; reports are handed to win (if any)
+    void Feed(const uint8_t *data, size_t n, Window *win) {
+        std::vector<Bytes> bodies;
+        std::string text;
+        bytes += n;
+        rx_.Feed(data, n, bodies, text);
+        for (char c : text) {
+            if (c == '\n') frames++;                // One text line per frame
+        }
+        std::fwrite(text.data(), 1, text.size(), stdout);
+
+        for (const Bytes &b : bodies) {
+            Report r;
+            std::vector<CanRecord> recs;
+            if (b.empty()) {
+                dec_.Invalidate();                  // Frames lost: dictionary records among them?
+            } else if (ParseReport(b, r)) {
+                if (win) win->OnReport(r);
+            } else if (ParseLossReport(b, loss)) {
+                PrintLoss();
+            } else if (dec_.Parse(b, recs)) {
+                for (const CanRecord &rec : recs) Print(rec);
+            } else {
+                bad_++;
+                dec_.Invalidate();
+            }
+        }
+        std::fflush(stdout);
+    }
+
+    uint32_t Errors() const { return rx_.errors + rx_.gaps + bad_; }
+    uint32_t Unknown() const { return dec_.unknown; }
+
+    uint64_t bytes = 0;                     ///< Link bytes received
+    uint64_t frames = 0;                    ///< CAN frames decoded
+    LossReport loss;                        ///< Last loss report
+
+private:
+    // "loss: 12 of 3456 frames (drop oldest, peak 32), overrun 0: 18FEF100 10, 123 2"
+    void PrintLoss() {
+        static const char *const policies[] = { "drop newest", "drop oldest", "latest per ID" };
+        std::fprintf(stderr, "loss: %u of %u frames (%s, peak %u), overrun %u", loss.lost, loss.received,
+                     loss.policy < 3 ? policies[loss.policy] : "?", loss.peak, loss.overrun);
+        for (size_t i = 0; i < loss.ids.size(); i++) {
+            const LossReport::Entry &e = loss.ids[i];
+            std::fprintf(stderr, i ? ", " : ": ");
+            if (e.id == kLossOtherIds) std::fprintf(stderr, "other IDs %u", e.lost);
+            else std::fprintf(stderr, "%0*X %u", (e.id & kLossExt) ? 8 : 3, e.id & ~kLossExt, e.lost);
+        }
+        std::fprintf(stderr, "\n");
+    }
+
+    void Print(const CanRecord &r) {
+        frames++;
+        if (r.has_time || r.has_delta) {
+            time_us_ = r.has_time ? r.time_us : time_us_ + r.delta_us;
+            std::printf("(%6llu.%06llu) ", (unsigned long long)(time_us_ / 1000000),
+                        (unsigned long long)(time_us_ % 1000000));
+        }
+        std::printf("%*s%0*X   [%u] ", r.ext ? 0 : 5, "", r.ext ? 8 : 3, r.id, r.dlc);
+        for (uint8_t b : r.data) std::printf(" %02X", b);
+        std::printf("\n");
+    }
+
+    Deframer rx_;
+    RecordDecoder dec_;
+    uint32_t bad_ = 0;                      // Intact frames that are neither report nor record
+    uint64_t time_us_ = 0;                  // Sum of the record deltas
+};
+
+static void OnSignal(int) {
+    stop = 1;
+}
+
+int main(int argc, char **argv) {
+    uint32_t baud = 921600, format = 0xFF, sync_seq = 0, batch_bytes = 48, batch_us = 1000;
+    uint32_t policy = 2, report_ms = 1000;
+    bool cobs = false, rtscts = false, timestamps = false, set_batch = false, set_overflow = false;
+    const char *port_path = nullptr, *capture = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        uint32_t *target = nullptr;
+        if (!std::strcmp(a, "-b")) target = &baud;
+        else if (!std::strcmp(a, "-f")) target = &format;
+        else if (!std::strcmp(a, "-s")) target = &sync_seq;
+        else if (!std::strcmp(a, "-B")) target = &batch_bytes;
+        else if (!std::strcmp(a, "-W")) target = &batch_us;
+        else if (!std::strcmp(a, "-P")) target = &policy;
+        else if (!std::strcmp(a, "-R")) target = &report_ms;
+        else if (!std::strcmp(a, "-T")) timestamps = true;
+        else if (!std::strcmp(a, "-c")) cobs = true;
+        else if (!std::strcmp(a, "-r")) rtscts = true;
+        else if (!std::strcmp(a, "-i") && i + 1 < argc) capture = argv[++i];
+        else if (a[0] != '-' && !port_path) port_path = a;
+        else {
+            Usage();
+            return 2;
+        }
+        if (target && (++i >= argc || !ParseU32(argv[i], *target))) {
+            Usage();
+            return 2;
+        }
+        if (target == &batch_bytes || target == &batch_us) set_batch = true;
+        if (target == &policy || target == &report_ms) set_overflow = true;
+    }
+    if (!port_path == !capture || (format != 0xFF && format > 3) || sync_seq > 0xFF ||
+        (timestamps && (format < 1 || format > 3)) || !batch_bytes || batch_bytes > 64 || batch_us > 0xFFFF ||
+        policy > 2 || report_ms > 0xFFFF) {
+        Usage();
+        return 2;
+    }
+
+    Printer out(cobs);
+    if (capture) {
+        std::ifstream in(capture, std::ios::binary);
+        if (!in) {
+            std::fprintf(stderr, "bridge_dump: cannot open %s\n", capture);
+            return 2;
+        }
+        Bytes buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        out.Feed(buf.data(), buf.size(), nullptr);
+    } else {
+        SerialPort port;
+        std::string error;
+        if (!port.Open(port_path, baud, rtscts, error)) {
+            std::fprintf(stderr, "bridge_dump: %s\n", error.c_str());
+            return 2;
+        }
+        std::signal(SIGINT, OnSignal);
+
+        // Window restart on its own, then the overflow, batch and format packets one at a time
+        std::vector<Bytes> packets;
+        if (set_overflow) packets.push_back({ 0x16, (uint8_t)policy, (uint8_t)(report_ms >> 8), (uint8_t)report_ms });
+        if (set_batch) packets.push_back({ 0x15, (uint8_t)batch_bytes, (uint8_t)(batch_us >> 8), (uint8_t)batch_us });
+        if (format != 0xFF) packets.push_back({ 0x14, (uint8_t)format, (uint8_t)(timestamps ? 0x01 : 0x00) });
+        if (!packets.empty()) packets.insert(packets.begin(), Bytes());
+        std::unique_ptr<Window> win;
+        size_t stage = 0;
+        auto rto = std::chrono::milliseconds(50);
+        uint8_t buf[512];
+
+        while (!stop) {
+            if (!win && stage < packets.size()) {
+                win.reset(new Window(1, rto, 8));
+                win->Start((uint8_t)(sync_seq + stage), 1);
+            }
+            if (win) {
+                for (size_t i : win->Due(Clock::now())) {
+                    (void)i;
+                    Bytes f = EncodeFrame(win->Seq(0), packets[stage], cobs);
+                    if (!port.Write(f.data(), f.size())) return 1;
+                    win->Sent(0, Clock::now());
+                }
+                if (win->Failed()) {
+                    std::fprintf(stderr, "bridge_dump: no answer from the bridge\n");
+                    return 1;
+                }
+            }
+
+            long n = port.Read(buf, sizeof(buf), 10);
+            if (n < 0) return 1;
+            out.Feed(buf, (size_t)n, win.get());
+
+            if (win && win->Done()) {
+                if (stage > 0 && win->Status(0) != kStatusOk) {
+                    std::fprintf(stderr, "bridge_dump: packet 0x%02X refused (status 0x%02X)\n",
+                                 packets[stage][0], win->Status(0));
+                    return 1;
+                }
+                win.reset();
+                stage++;
+            }
+        }
+    }
+
+    std::fprintf(stderr, "frames: %llu, link bytes: %llu (%.1f per frame), lost or bad frames: %u, "
+                 "frames of unknown dictionary slots: %u\n",
+                 (unsigned long long)out.frames, (unsigned long long)out.bytes,
+                 out.frames ? (double)out.bytes / out.frames : 0.0, out.Errors(), out.Unknown());
+    if (out.loss.received) {
+        std::fprintf(stderr, "bridge: %u frames received, %u lost to a full queue, %u FIFO overruns\n",
+                     out.loss.received, out.loss.lost, out.loss.overrun);
+    }
+    return 0;
+}
+/*
+ * End of file
+ */
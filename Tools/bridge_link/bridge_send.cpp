@@ -0,0 +1,202 @@
+/*
+ * bridge_send.cpp
+ * @brief   Command line front end: streams a file of UART command packets to the
+ *          bridge with a window of commands in flight, retransmitting only the
+ *          frames the device did not acknowledge.
+ *
+ *          bridge_send [options] <port> <packets.bin>
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "link.hpp"
+#include "schedule.hpp"       // PacketLength, shared with can_sched
+#include "serial.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace bridge_link;
+
+static void Usage(void) {
+    std::fprintf(stderr,
+        "usage: bridge_send [options] <port> <packets.bin>\n"
+        "  <packets.bin>   bare UART command packets, back to back; replies to list\n"
+        "                  (0x12) and info (0x13) packets are printed\n"
+        "  -b <bit/s>      UART bit rate (default 921600)\n"
+        "  -w <n>          commands in flight, 1-16 (default 16)\n"
+        "  -t <ms>         retransmission timeout (default 50)\n"
+        "  -n <n>          transmissions per command before giving up (default 8)\n"
+        "  -s <seq>        sequence number of the window restart (default 0)\n"
+        "  -c              COBS framing (firmware built with FRAME_COBS=1)\n"
+        "  -r              RTS/CTS flow control (firmware built with UART_FLOW_CONTROL=1)\n"
+        "  -q              do not echo the CAN traffic received meanwhile\n"
+        "exit status: 0 all commands executed, 1 a command failed or the link gave up,\n"
+        "             2 usage or input error\n");
+}
+
+// Parse a numeric option
+static bool ParseU32(const char *text, uint32_t &out) {
+    char *end;
+    unsigned long v = std::strtoul(text, &end, 0);
+    if (*text == '\0' || *end != '\0' || v > 0xFFFFFFFFul) return false;
+    out = (uint32_t)v;
+    return true;
+}
+
+// Split a file into packets; false if a byte does not start a known packet
+static bool LoadPackets(const std::string &path, std::vector<Bytes> &out, std::string &error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    Bytes buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    for (size_t pos = 0; pos < buf.size();) {
+        size_t len = can_sched::PacketLength(&buf[pos], buf.size() - pos);
+        if (len == 0 || len > kMaxPacket || pos + len > buf.size()) {
+            error = path + ": bad or truncated packet at offset " + std::to_string(pos);
+            return false;
+        }
+        out.emplace_back(buf.begin() + pos, buf.begin() + pos + len);
+        pos += len;
+    }
+    return true;
+}
+
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// Print the answer to a list (0x12) or info (0x13) command
+static void PrintReply(const Bytes &b) {
+    if (b.size() >= 14 && b[0] == kReportInfo) {
+        std::printf("firmware %u.%u, %u of %u messages, %u extension records, %u generators, "
+                    "window %u, packets up to %u bytes%s%s%s\n",
+                    b[2], b[3], b[6] << 8 | b[7], b[4] << 8 | b[5], b[8], b[9], b[10], b[11] << 8 | b[12],
+                    (b[13] & 0x01) ? ", paused" : "", (b[13] & 0x02) ? ", COBS" : "", (b[13] & 0x04) ? ", RTS/CTS" : "");
+        return;
+    }
+    if (b.size() < 5 || b[0] != kReportList) return;
+    size_t pos = 5;
+    for (unsigned i = 0; i < b[4] && pos + 6 <= b.size(); i++) {
+        const uint8_t *e = &b[pos];
+        size_t len = e[5];
+        if (len > 8 || pos + 6 + len + 4 > b.size()) break;
+        std::printf("%s 0x%0*X %zu", e[0] ? "ext" : "std", e[0] ? 8 : 3, Get32(e + 1), len);
+        for (size_t k = 0; k < len; k++) std::printf(" %02X", e[6 + k]);
+        std::printf(" %uus\n", Get32(e + 6 + len));
+        pos += 6 + len + 4;
+    }
+}
+
+// Send queued frames and handle what comes back until the window is drained
+static bool Run(SerialPort &port, Deframer &rx, Window &win, const std::vector<Bytes> &packets,
+                bool cobs, bool quiet) {
+    uint8_t buf[512];
+
+    while (!win.Done()) {
+        for (size_t i : win.Due(Clock::now())) {
+            Bytes f = EncodeFrame(win.Seq(i), packets[i], cobs);
+            if (!port.Write(f.data(), f.size())) return false;
+            win.Sent(i, Clock::now());
+        }
+        if (win.Failed()) return false;
+
+        long n = port.Read(buf, sizeof(buf), 2);
+        if (n < 0) return false;
+
+        std::vector<Bytes> bodies;
+        std::string text;
+        rx.Feed(buf, (size_t)n, bodies, text);
+        if (!quiet) std::fwrite(text.data(), 1, text.size(), stdout);
+        for (const Bytes &b : bodies) {
+            Report r;
+            if (ParseReport(b, r)) win.OnReport(r);
+            else PrintReply(b);
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    uint32_t baud = 921600, window = kDeviceWindow, rto_ms = 50, tries = 8, sync_seq = 0;
+    bool cobs = false, rtscts = false, quiet = false;
+    const char *port_path = nullptr, *path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        uint32_t *target = nullptr;
+        if (!std::strcmp(a, "-b")) target = &baud;
+        else if (!std::strcmp(a, "-w")) target = &window;
+        else if (!std::strcmp(a, "-t")) target = &rto_ms;
+        else if (!std::strcmp(a, "-n")) target = &tries;
+        else if (!std::strcmp(a, "-s")) target = &sync_seq;
+        else if (!std::strcmp(a, "-c")) cobs = true;
+        else if (!std::strcmp(a, "-r")) rtscts = true;
+        else if (!std::strcmp(a, "-q")) quiet = true;
+        else if (a[0] != '-' && !port_path) port_path = a;
+        else if (a[0] != '-' && !path) path = a;
+        else {
+            Usage();
+            return 2;
+        }
+        if (target && (++i >= argc || !ParseU32(argv[i], *target))) {
+            Usage();
+            return 2;
+        }
+    }
+    if (!path || !window || window > kDeviceWindow || !rto_ms || !tries || sync_seq > 0xFF) {
+        Usage();
+        return 2;
+    }
+
+    std::vector<Bytes> packets;
+    std::string error;
+    SerialPort port;
+    if (!LoadPackets(path, packets, error) || !port.Open(port_path, baud, rtscts, error)) {
+        std::fprintf(stderr, "bridge_send: %s\n", error.c_str());
+        return 2;
+    }
+
+    Deframer rx(cobs);
+    auto rto = std::chrono::milliseconds(rto_ms);
+
+    // Restart the device window on its own first: a late copy of the empty frame
+    // must not arrive after commands that follow it
+    Window sync(1, rto, tries);
+    sync.Start((uint8_t)sync_seq, 1);
+    if (!Run(port, rx, sync, { Bytes() }, cobs, quiet)) {
+        std::fprintf(stderr, "bridge_send: no answer from the bridge\n");
+        return 1;
+    }
+
+    Window win(window, rto, tries);
+    win.Start((uint8_t)(sync_seq + 1), packets);
+    bool link_ok = Run(port, rx, win, packets, cobs, quiet);
+
+    unsigned failed = 0;
+    for (size_t i = 0; i < packets.size(); i++) {
+        if (win.Status(i) == kStatusOk) continue;
+        std::fprintf(stderr, "packet %zu (type 0x%02X, seq %u): status 0x%02X\n",
+                     i, packets[i][0], win.Seq(i), win.Status(i));
+        failed++;
+    }
+    std::fprintf(stderr, "packets: %zu, retransmitted: %u, failed: %u, bad frames received: %u\n",
+                 packets.size(), win.retransmits, failed, rx.errors);
+    if (!link_ok) {
+        std::fprintf(stderr, "bridge_send: link lost\n");
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,455 @@
+/*
+ * link.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "link.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace bridge_link {
+
+namespace {
+
+constexpr size_t kHdr = 5;                  // FRAME_HDR_LEN
+constexpr size_t kCrc = 2;                  // FRAME_CRC_LEN
+constexpr size_t kReportLen = 6;            // CMD_REPORT_LEN
+
+// CRC8 SAE-J1850 (poly 0x1D, init 0xFF, final XOR 0xFF) for the SOF header
+uint8_t Crc8J1850(const uint8_t *data, size_t len) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x1D) : (uint8_t)(crc << 1);
+    }
+    return crc ^ 0xFF;
+}
+
+uint16_t Get16(const uint8_t *p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)Get16(p) << 16 | Get16(p + 2);
+}
+
+// Record time delta: base-128 varint of 1-4 bytes, little-endian
+bool GetDelta(const uint8_t *&p, const uint8_t *end, uint32_t &out) {
+    out = 0;
+    for (int shift = 0;; shift += 7) {
+        if (p == end || shift > 21) return false;
+        uint8_t b = *p++;
+        out |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+}
+
+// COBS as in cobs.c: a full block at the end gets no extra code byte
+Bytes CobsEncode(const Bytes &in) {
+    Bytes out(1, 0);
+    size_t code = 0;                         // Position of the current code byte
+    for (size_t i = 0; i < in.size(); i++) {
+        uint8_t b = in[i];
+        if (b != 0) out.push_back(b);
+        if (b == 0 || (out.size() - code == 0xFF && i + 1 < in.size())) {
+            out[code] = (uint8_t)(out.size() - code);
+            code = out.size();
+            out.push_back(0);
+        }
+    }
+    out[code] = (uint8_t)(out.size() - code);
+    return out;
+}
+
+// Decode one COBS frame (delimiter removed); false if malformed
+bool CobsDecode(const Bytes &in, Bytes &out) {
+    out.clear();
+    for (size_t i = 0; i < in.size();) {
+        size_t code = in[i++];
+        if (code == 0 || i + code - 1 > in.size()) return false;
+        out.insert(out.end(), in.begin() + i, in.begin() + i + code - 1);
+        i += code - 1;
+        if (code != 0xFF && i < in.size()) out.push_back(0);
+    }
+    return true;
+}
+
+}  // namespace
+
+uint16_t Crc16Ccitt(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+Bytes EncodeFrame(uint8_t seq, const Bytes &packet, bool cobs) {
+    Bytes f;
+    if (!cobs) f = { kFrameSof, seq, (uint8_t)(packet.size() >> 8), (uint8_t)packet.size(), 0 };
+    else f = { seq };
+    if (!cobs) f[4] = Crc8J1850(&f[1], 3);           // The CRC16 covers the header CRC too
+    f.insert(f.end(), packet.begin(), packet.end());
+
+    size_t from = cobs ? 0 : 1;                      // CRC16 starts at Seq
+    uint16_t crc = Crc16Ccitt(&f[from], f.size() - from);
+    f.push_back((uint8_t)(crc >> 8));
+    f.push_back((uint8_t)crc);
+    if (!cobs) return f;
+    Bytes out = CobsEncode(f);
+    out.push_back(0);
+    return out;
+}
+
+// =====================================================================
+// Deframer
+void Deframer::Feed(const uint8_t *data, size_t n, std::vector<Bytes> &bodies, std::string &text) {
+    buf_.insert(buf_.end(), data, data + n);
+    if (cobs_) FeedCobs(bodies);
+    else FeedSof(bodies, text);
+}
+
+void Deframer::Deliver(uint8_t seq, Bytes body, std::vector<Bytes> &bodies) {
+    if (next_seq_ >= 0 && seq != next_seq_ && !lost_) {
+        gaps++;
+        bodies.emplace_back();
+    }
+    next_seq_ = (uint8_t)(seq + 1);
+    lost_ = false;
+    bodies.push_back(std::move(body));
+}
+
+void Deframer::Lost(std::vector<Bytes> &bodies) {
+    errors++;
+    if (!lost_) bodies.emplace_back();
+    lost_ = true;
+}
+
+void Deframer::FeedSof(std::vector<Bytes> &bodies, std::string &text) {
+    size_t pos = 0;
+    while (pos < buf_.size()) {
+        const uint8_t *f = &buf_[pos];
+        if (f[0] != kFrameSof) {
+            text.push_back((char)f[0]);                 // Text CAN lines between the frames
+            pos++;
+            continue;
+        }
+        if (buf_.size() - pos < kHdr) break;            // Header incomplete
+        size_t len = Get16(f + 2);
+        if (Crc8J1850(f + 1, 3) != f[4] || len > kMaxPacket) {
+            Lost(bodies);
+            pos++;
+            continue;
+        }
+        if (buf_.size() - pos < kHdr + len + kCrc) break;
+        if (Crc16Ccitt(f + 1, kHdr - 1 + len) == Get16(f + kHdr + len))
+            Deliver(f[1], Bytes(f + kHdr, f + kHdr + len), bodies);
+        else
+            Lost(bodies);
+        pos += kHdr + len + kCrc;
+    }
+    buf_.erase(buf_.begin(), buf_.begin() + pos);
+}
+
+void Deframer::FeedCobs(std::vector<Bytes> &bodies) {
+    auto begin = buf_.begin();
+    for (auto end = begin; (end = std::find(begin, buf_.end(), 0)) != buf_.end(); begin = end + 1) {
+        if (end == begin) continue;                     // Empty frame
+        Bytes f;
+        if (!CobsDecode(Bytes(begin, end), f) || f.size() < 1 + kCrc ||
+            Crc16Ccitt(f.data(), f.size() - kCrc) != Get16(&f[f.size() - kCrc])) {
+            Lost(bodies);
+            continue;
+        }
+        Deliver(f[0], Bytes(f.begin() + 1, f.end() - kCrc), bodies);
+    }
+    buf_.erase(buf_.begin(), begin);
+}
+
+bool ParseReport(const Bytes &body, Report &out) {
+    if (body.size() != kReportLen || (body[0] != kReportAck && body[0] != kReportNack)) return false;
+    out.type = body[0];
+    out.seq = body[1];
+    out.status = body[2];
+    out.ack = body[3];
+    out.sack = Get16(&body[4]);
+    return true;
+}
+
+bool ParseLossReport(const Bytes &body, LossReport &out) {
+    constexpr size_t kHdr = 16;
+    if (body.size() < kHdr || body[0] != kReportLoss || body.size() != kHdr + 8 * (size_t)body[15]) return false;
+    out.policy = body[1];
+    out.peak = body[2];
+    out.received = Get32(&body[3]);
+    out.lost = Get32(&body[7]);
+    out.overrun = Get32(&body[11]);
+    out.ids.clear();
+    for (size_t i = kHdr; i < body.size(); i += 8) out.ids.push_back({ Get32(&body[i]), Get32(&body[i + 4]) });
+    return true;
+}
+
+// =====================================================================
+// Forwarded CAN frames
+bool ParseRecords(const Bytes &body, std::vector<CanRecord> &out) {
+    const uint8_t *p = body.data(), *end = p + body.size();
+    if (p == end) return false;
+
+    // Full record of the COBS build: exactly one per frame
+    if (*p <= 1) {
+        if (body.size() < 6 || body[5] > 8 || body.size() != 6u + body[5]) return false;
+        CanRecord r;
+        r.ext = body[0] != 0;
+        r.id = Get32(&body[1]);
+        r.dlc = body[5];
+        r.data.assign(body.begin() + 6, body.end());
+        out.push_back(r);
+        return true;
+    }
+
+    // Batch: the first record is at Time, each later one Delta after the one before
+    bool timed = false;
+    uint32_t time = 0;
+    if ((*p & 0xFE) == 0x02) {
+        timed = *p++ & 0x01;
+        if (timed) {
+            if (end - p < 4) return false;
+            time = Get32(p);
+            p += 4;
+        }
+        if (p == end) return false;
+    }
+
+    while (p < end) {
+        uint8_t flags = *p++;
+        if ((flags & 0xC0) != 0x40) return false;
+        CanRecord r;
+        r.ext = flags & 0x10;
+        r.dlc = flags & 0x0F;
+        size_t id_len = r.ext ? 4 : 2, n = std::min<size_t>(r.dlc, 8);
+        if ((size_t)(end - p) < id_len + n) return false;
+        for (size_t i = 0; i < id_len; i++) r.id = r.id << 8 | *p++;
+        r.data.assign(p, p + n);
+        p += n;
+        if (flags & 0x20) {
+            r.has_delta = true;
+            if (!GetDelta(p, end, r.delta_us)) return false;
+        }
+        if (timed) {
+            time += r.delta_us;
+            r.has_time = true;
+            r.time_us = time;
+        }
+        out.push_back(r);
+    }
+    return true;
+}
+
+bool RecordDecoder::Parse(const Bytes &body, std::vector<CanRecord> &out) {
+    if (body.empty() || (body[0] & 0xFE) != 0x04) return ParseRecords(body, out);
+    const uint8_t *p = body.data() + 1, *end = body.data() + body.size();
+
+    bool timed = body[0] & 0x01;
+    uint32_t time = 0;
+    if (timed) {
+        if (end - p < 4) return false;
+        time = Get32(p);
+        p += 4;
+    }
+    if (p == end) return false;
+
+    while (p < end) {
+        uint8_t tag = *p++;
+        CanRecord r;
+        bool known = true, delta;
+        if (tag & 0x80) {
+            // Known ID: flip the changed bytes of the last payload
+            Slot &s = dict_[tag & 0x3F];
+            if (p == end) return false;
+            uint8_t mask = *p++;
+            delta = tag & 0x40;
+            known = s.valid;
+            r.id = s.id;
+            r.ext = s.ext;
+            r.dlc = s.dlc;
+            r.data = s.data;
+            for (size_t i = 0; i < 8; i++) {
+                if (!(mask >> i & 1)) continue;
+                if (p == end || i >= r.data.size()) return false;
+                r.data[i] ^= *p++;
+            }
+            s.data = r.data;
+        } else {
+            // Definition of a slot
+            if (tag & 0x40) return false;
+            delta = tag & 0x20;
+            r.ext = tag & 0x10;
+            r.dlc = tag & 0x0F;
+            size_t id_len = r.ext ? 4 : 2, n = std::min<size_t>(r.dlc, 8);
+            if ((size_t)(end - p) < 1 + id_len + n || *p > 0x3F) return false;
+            Slot &s = dict_[*p++];
+            for (size_t i = 0; i < id_len; i++) r.id = r.id << 8 | *p++;
+            r.data.assign(p, p + n);
+            p += n;
+            s.valid = true;
+            s.id = r.id;
+            s.ext = r.ext;
+            s.dlc = r.dlc;
+            s.data = r.data;
+        }
+        if (delta) {
+            r.has_delta = true;
+            if (!GetDelta(p, end, r.delta_us)) return false;
+        }
+        if (timed) {
+            time += r.delta_us;
+            r.has_time = true;
+            r.time_us = time;
+        }
+        if (known) out.push_back(r);
+        else unknown++;
+    }
+    return true;
+}
+
+void RecordDecoder::Invalidate() {
+    for (Slot &s : dict_) s.valid = false;
+}
+
+// =====================================================================
+// Window
+
+// Command packet types and bulk / group flags as in command.c
+PacketOrder ClassifyPacket(const Bytes &packet) {
+    PacketOrder o;
+    const uint8_t *p = packet.data();
+    size_t n = packet.size();
+
+    if (n == 0) return o;
+    switch (p[0]) {
+    case 0x06:                                          // CMD_BULK_LOAD
+    case 0x0C:                                          // CMD_GROUP_UPDATE
+        o.barrier = n > 1 && (p[1] & 0x03);             // CMD_BULK_BEGIN, CMD_BULK_COMMIT
+        break;
+    case 0x07:                                          // CMD_SAVE_CONFIG
+    case 0x08:                                          // CMD_ERASE_CONFIG
+    case 0x09:                                          // CMD_SET_BITRATE
+    case 0x0F:                                          // CMD_CLEAR
+    case 0x10:                                          // CMD_PAUSE
+    case 0x11:                                          // CMD_RESUME
+        o.barrier = true;
+        break;
+    case 0x00:                                          // CMD_STD: 11-bit ID
+        o.has_id = n >= 3;
+        if (o.has_id) o.id = Get16(p + 1);
+        break;
+    case 0x01:                                          // CMD_EXT
+    case 0x02:                                          // CMD_SET_COUNTER
+    case 0x03:                                          // CMD_SET_CHECKSUM
+    case 0x04:                                          // CMD_SET_GENERATOR
+    case 0x05:                                          // CMD_SET_MODE
+    case 0x0E:                                          // CMD_DELETE
+        o.has_id = n >= 5;
+        if (o.has_id) o.id = Get32(p + 1);
+        break;
+    case 0x0B:                                          // CMD_FRAME_US: [B][Model][ID 4]
+        o.has_id = n >= 6;
+        if (o.has_id) o.id = Get32(p + 2);
+        break;
+    case 0x0D:                                          // CMD_PATCH: [D][Ctl][ID 2 or 4]
+        if (n >= 2 && (p[1] & 0x80)) {                  // CMD_PATCH_EXT
+            o.has_id = n >= 6;
+            if (o.has_id) o.id = Get32(p + 2);
+        } else {
+            o.has_id = n >= 4;
+            if (o.has_id) o.id = Get16(p + 2);
+        }
+        break;
+    default:
+        break;
+    }
+    return o;
+}
+
+Window::Window(size_t size, Clock::duration rto, unsigned max_tries)
+    : size_(std::min(std::max<size_t>(size, 1), kDeviceWindow)), rto_(rto), max_tries_(max_tries) {}
+
+void Window::Start(uint8_t first_seq, size_t count) {
+    first_seq_ = first_seq;
+    slots_.assign(count, Slot());
+    base_ = next_ = 0;
+    failed_ = false;
+}
+
+void Window::Start(uint8_t first_seq, const std::vector<Bytes> &packets) {
+    Start(first_seq, packets.size());
+    for (size_t i = 0; i < packets.size(); i++) slots_[i].order = ClassifyPacket(packets[i]);
+}
+
+bool Window::Ready(size_t index) const {
+    const PacketOrder &o = slots_[index].order;
+    for (size_t i = base_; i < index; i++) {
+        const Slot &s = slots_[i];
+        if (s.done) continue;
+        if (o.barrier || s.order.barrier || (o.has_id && s.order.has_id && o.id == s.order.id)) return false;
+    }
+    return true;
+}
+
+std::vector<size_t> Window::Due(Clock::time_point now) {
+    std::vector<size_t> due;
+    bool later_acked = false;                           // A newer packet got through
+
+    // Walk newest to oldest so a gap behind an acknowledged packet is seen
+    for (size_t i = next_; i-- > base_;) {
+        Slot &s = slots_[i];
+        if (s.done) {
+            later_acked = true;
+            continue;
+        }
+        auto age = now - s.last_tx;
+        if (age >= rto_ || (later_acked && age >= rto_ / 4)) {
+            if (s.tries >= max_tries_) {
+                failed_ = true;
+                return {};
+            }
+            due.push_back(i);
+        }
+    }
+    std::reverse(due.begin(), due.end());
+    // New packets in order; one that depends on a packet in flight holds back the rest
+    for (; next_ < slots_.size() && next_ - base_ < size_ && Ready(next_); next_++) due.push_back(next_);
+    return due;
+}
+
+void Window::Sent(size_t index, Clock::time_point now) {
+    Slot &s = slots_[index];
+    if (s.tries++) retransmits++;
+    s.last_tx = now;
+}
+
+size_t Window::Find(uint8_t seq) const {
+    size_t i = (uint8_t)(seq - Seq(base_));
+    return (base_ + i < next_) ? base_ + i : slots_.size();
+}
+
+void Window::OnReport(const Report &r) {
+    if (r.type == kReportNack) {
+        size_t i = Find(r.seq);
+        if (i < slots_.size()) slots_[i].status = r.status;
+    }
+    // Everything before Ack is executed, and Ack + i for every Sack bit i
+    for (size_t i = base_; i < next_; i++) {
+        uint8_t ahead = (uint8_t)(Seq(i) - r.ack);
+        if (ahead >= 0x80 || (ahead < 16 && (r.sack >> ahead & 1))) slots_[i].done = true;
+    }
+    while (base_ < next_ && slots_[base_].done) base_++;
+}
+
+}  // namespace bridge_link
@@ -0,0 +1,266 @@
+/*
+ * link.hpp
+ * @brief   PC side of the bridge UART protocol: framing (SOF or COBS), parsing of
+ *          the device output and the sliding window that keeps several commands
+ *          in flight and retransmits only the ones that were lost.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef TOOLS_BRIDGE_LINK_LINK_HPP_
+#define TOOLS_BRIDGE_LINK_LINK_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bridge_link {
+
+using Bytes = std::vector<uint8_t>;
+using Clock = std::chrono::steady_clock;
+
+// Protocol constants as in frame.h / command.h
+constexpr uint8_t kFrameSof = 0xA5;         ///< FRAME_SOF
+constexpr size_t kMaxPacket = 300;          ///< CMD_MAX_LEN
+constexpr size_t kDeviceWindow = 16;        ///< CMD_WINDOW
+constexpr uint8_t kReportAck = 0x80;        ///< CMD_REPORT_ACK
+constexpr uint8_t kReportNack = 0x81;       ///< CMD_REPORT_NACK
+constexpr uint8_t kReportList = 0x82;       ///< CMD_REPORT_LIST
+constexpr uint8_t kReportInfo = 0x83;       ///< CMD_REPORT_INFO
+constexpr uint8_t kReportLoss = 0x84;       ///< CAN_FWD_REPORT_LOSS
+constexpr uint8_t kStatusOk = 0x00;         ///< CMD_OK
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) as used by UART frames.
+ */
+uint16_t Crc16Ccitt(const uint8_t *data, size_t len);
+
+/**
+ * @brief Build one frame around a packet (an empty packet is a window restart).
+ *
+ * @param seq     Frame sequence number
+ * @param packet  Command packet (0–kMaxPacket bytes)
+ * @param cobs    COBS framing (firmware built with FRAME_COBS=1) instead of SOF
+ */
+Bytes EncodeFrame(uint8_t seq, const Bytes &packet, bool cobs);
+
+/**
+ * @brief Splits the device output into frame bodies and everything else
+ *        (the text CAN lines in SOF mode).
+ */
+class Deframer {
+public:
+    explicit Deframer(bool cobs) : cobs_(cobs) {}
+
+    /**
+     * @brief Feed received bytes.
+     *
+     * @param data    Bytes from the port
+     * @param n       Number of bytes
+     * @param bodies  Intact frame bodies are appended here; an empty body
+     *                stands for frames lost at that point (failed check or a
+     *                gap in the sequence numbers)
+     * @param text    Bytes outside frames are appended here
+     */
+    void Feed(const uint8_t *data, size_t n, std::vector<Bytes> &bodies, std::string &text);
+
+    uint32_t errors = 0;                    ///< Frames dropped for a failed check
+    uint32_t gaps = 0;                      ///< Sequence gaps: frames lost without a trace
+
+private:
+    void FeedSof(std::vector<Bytes> &bodies, std::string &text);
+    void FeedCobs(std::vector<Bytes> &bodies);
+    void Deliver(uint8_t seq, Bytes body, std::vector<Bytes> &bodies);
+    void Lost(std::vector<Bytes> &bodies);
+
+    bool cobs_;
+    Bytes buf_;                             // Bytes not parsed yet
+    int next_seq_ = -1;                     // Sequence number expected next, -1 = any
+    bool lost_ = false;                     // Empty body already given for the current loss
+};
+
+/**
+ * @brief ACK or NACK report: [Type][Seq][Status][Ack][Sack 2].
+ */
+struct Report {
+    uint8_t type = 0;                       ///< kReportAck or kReportNack
+    uint8_t seq = 0;                        ///< Last command of the pass / failed command
+    uint8_t status = 0;                     ///< CMD_ status code
+    uint8_t ack = 0;                        ///< Oldest sequence number not executed yet
+    uint16_t sack = 0;                      ///< Bit i: ack + i already executed
+};
+
+/**
+ * @brief Parse a frame body as a report.
+ * @return false if the body is not a report
+ */
+bool ParseReport(const Bytes &body, Report &out);
+
+/**
+ * @brief Loss report of the receive queue (can_forward.h), counts since the
+ *        last packet 0x16.
+ */
+struct LossReport {
+    uint8_t policy = 0;                     ///< 0 drop newest, 1 drop oldest, 2 latest per ID
+    uint8_t peak = 0;                       ///< Most frames queued at once since the previous report
+    uint32_t received = 0;                  ///< Frames received from the bus
+    uint32_t lost = 0;                      ///< Frames lost to a full queue
+    uint32_t overrun = 0;                   ///< Controller FIFO overruns (IDs unknown)
+    struct Entry {
+        uint32_t id;                        ///< ID, bit 31 set for 29-bit, or kLossOtherIds
+        uint32_t lost;
+    };
+    std::vector<Entry> ids;                 ///< IDs whose count changed since the previous report
+};
+
+constexpr uint32_t kLossExt = 0x80000000u;      ///< CAN_BUF_EXT
+constexpr uint32_t kLossOtherIds = 0xFFFFFFFFu; ///< CAN_BUF_OTHER_IDS
+
+/**
+ * @brief Parse a frame body as a loss report.
+ * @return false if the body is not one
+ */
+bool ParseLossReport(const Bytes &body, LossReport &out);
+
+/**
+ * @brief A received CAN frame as forwarded by the device.
+ */
+struct CanRecord {
+    uint32_t id = 0;
+    bool ext = false;                       ///< 29-bit ID
+    uint8_t dlc = 0;                        ///< Data length code (data holds at most 8 bytes)
+    Bytes data;
+    bool has_delta = false;                 ///< Compact record with a timestamp
+    uint32_t delta_us = 0;                  ///< Time since the previous record
+    bool has_time = false;                  ///< Batch with timestamps: time_us is known
+    uint32_t time_us = 0;                   ///< Device time of the frame
+};
+
+/**
+ * @brief Parse a frame body holding forwarded CAN frames: compact records
+ *        [Flags][ID 2 or 4][Data][Delta] (packet 0x14 format 1), a batch of them
+ *        [0x02 or 0x03][Time 4 with 0x03][Record]... (format 2) or the full
+ *        record [Ext][ID 4][Len][Data] of the COBS build. Dictionary batches
+ *        (format 3) need the state of a RecordDecoder.
+ * @return false if the body is not a record or is malformed
+ */
+bool ParseRecords(const Bytes &body, std::vector<CanRecord> &out);
+
+/**
+ * @brief ParseRecords that also decodes the dictionary batches of format 3
+ *        (can_dict.h), keeping the PC copy of the device dictionary.
+ */
+class RecordDecoder {
+public:
+    /**
+     * @brief Parse a frame body holding forwarded CAN frames, in any format.
+     * @return false if the body is not a record or is malformed
+     */
+    bool Parse(const Bytes &body, std::vector<CanRecord> &out);
+
+    /**
+     * @brief Forget the dictionary after a lost or damaged frame: records of a
+     *        slot are then dropped (and counted) until the device defines it again.
+     */
+    void Invalidate();
+
+    uint32_t unknown = 0;                   ///< Records dropped for a slot not defined yet
+
+private:
+    struct Slot {
+        bool valid = false;
+        uint32_t id = 0;
+        bool ext = false;
+        uint8_t dlc = 0;
+        Bytes data;
+    };
+
+    Slot dict_[64];
+};
+
+/**
+ * @brief How a packet has to be ordered against the other packets in flight.
+ *        The device runs each packet as soon as it arrives, so after a lost
+ *        frame later packets run before the retransmission of the lost one.
+ */
+struct PacketOrder {
+    bool barrier = false;                   ///< Runs alone: begin / commit of a bulk or group load, save, erase,
+                                            ///< bit rate, clear, pause, resume
+    bool has_id = false;
+    uint32_t id = 0;                        ///< CAN ID of a packet that changes one message
+};
+
+/**
+ * @brief Ordering needs of a command packet.
+ */
+PacketOrder ClassifyPacket(const Bytes &packet);
+
+/**
+ * @brief Sender side of the command window. Packets get consecutive sequence
+ *        numbers; a packet is resent when its timeout expires, or earlier when a
+ *        later packet was acknowledged and it was not (a lost frame). A packet
+ *        is not sent while a packet it depends on is in flight: a barrier waits
+ *        for every earlier packet and holds back every later one, a packet for
+ *        an ID waits for the earlier packets for the same ID.
+ */
+class Window {
+public:
+    /**
+     * @param size       Commands in flight (1–kDeviceWindow)
+     * @param rto        Time after which an unacknowledged packet is resent
+     * @param max_tries  Transmissions per packet before giving up
+     */
+    Window(size_t size, Clock::duration rto, unsigned max_tries);
+
+    /** @brief Start a transfer of count independent packets, the first one using first_seq. */
+    void Start(uint8_t first_seq, size_t count);
+
+    /** @brief Start a transfer of packets, ordered as ClassifyPacket says. */
+    void Start(uint8_t first_seq, const std::vector<Bytes> &packets);
+
+    /** @brief Packets to send now, oldest first (new ones and retransmissions). */
+    std::vector<size_t> Due(Clock::time_point now);
+
+    /** @brief Record that a packet was written to the port. */
+    void Sent(size_t index, Clock::time_point now);
+
+    /** @brief Apply an ACK or NACK from the device. */
+    void OnReport(const Report &r);
+
+    uint8_t Seq(size_t index) const { return (uint8_t)(first_seq_ + index); }
+    uint8_t Status(size_t index) const { return slots_[index].status; }
+    bool Done() const { return base_ == slots_.size(); }
+    bool Failed() const { return failed_; }
+
+    uint32_t retransmits = 0;               ///< Frames sent more than once
+
+private:
+    struct Slot {
+        bool done = false;
+        uint8_t status = kStatusOk;
+        unsigned tries = 0;
+        Clock::time_point last_tx;
+        PacketOrder order;
+    };
+
+    // Index of an in-flight packet with this sequence number, or slots_.size()
+    size_t Find(uint8_t seq) const;
+
+    // Whether a packet never sent may go out with the ones in flight
+    bool Ready(size_t index) const;
+
+    size_t size_;
+    Clock::duration rto_;
+    unsigned max_tries_;
+    uint8_t first_seq_ = 0;
+    std::vector<Slot> slots_;
+    size_t base_ = 0;                       // Oldest packet not acknowledged
+    size_t next_ = 0;                       // First packet never sent
+    bool failed_ = false;
+};
+
+}  // namespace bridge_link
+
+#endif /* TOOLS_BRIDGE_LINK_LINK_HPP_ */
@@ -0,0 +1,100 @@
+/*
+ * serial.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "serial.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace bridge_link {
+
+namespace {
+
+// termios constant for a bit rate, 0 if unsupported
+speed_t Speed(uint32_t baud) {
+    switch (baud) {
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    case 3000000: return B3000000;
+#endif
+    default: return 0;
+    }
+}
+
+}  // namespace
+
+SerialPort::~SerialPort() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool SerialPort::Open(const std::string &path, uint32_t baud, bool rtscts, std::string &error) {
+    speed_t speed = Speed(baud);
+    if (!speed) {
+        error = "unsupported bit rate";
+        return false;
+    }
+    fd_ = open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (fd_ < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    termios tio;
+    if (tcgetattr(fd_, &tio) != 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB);
+    if (rtscts) tio.c_cflag |= CRTSCTS;
+    else tio.c_cflag &= ~CRTSCTS;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd_, TCSANOW, &tio) != 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    tcflush(fd_, TCIOFLUSH);
+    return true;
+}
+
+bool SerialPort::Write(const uint8_t *data, size_t n) {
+    while (n) {
+        ssize_t w = write(fd_, data, n);
+        if (w < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return false;
+        }
+        data += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+long SerialPort::Read(uint8_t *data, size_t n, int timeout_ms) {
+    pollfd p = { fd_, POLLIN, 0 };
+    int r = poll(&p, 1, timeout_ms);
+    if (r <= 0) return (r == 0 || errno == EINTR) ? 0 : -1;
+    ssize_t got = read(fd_, data, n);
+    return (got < 0) ? (errno == EAGAIN ? 0 : -1) : (long)got;
+}
+
+}  // namespace bridge_link
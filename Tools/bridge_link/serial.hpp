@@ -0,0 +1,47 @@
+/*
+ * serial.hpp
+ * @brief   Minimal POSIX serial port: raw 8N1, optional RTS/CTS.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef TOOLS_BRIDGE_LINK_SERIAL_HPP_
+#define TOOLS_BRIDGE_LINK_SERIAL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bridge_link {
+
+class SerialPort {
+public:
+    SerialPort() = default;
+    ~SerialPort();
+    SerialPort(const SerialPort &) = delete;
+    SerialPort &operator=(const SerialPort &) = delete;
+
+    /**
+     * @brief Open and configure the port.
+     *
+     * @param path      Device, e.g. /dev/ttyUSB0
+     * @param baud      Bit rate (must be a rate termios knows)
+     * @param rtscts    Hardware flow control (firmware built with UART_FLOW_CONTROL=1)
+     * @param error     Message on failure
+     * @return          true on success
+     */
+    bool Open(const std::string &path, uint32_t baud, bool rtscts, std::string &error);
+
+    /** @brief Write all bytes; false on error. */
+    bool Write(const uint8_t *data, size_t n);
+
+    /** @brief Read what arrives within timeout_ms; returns bytes read, -1 on error. */
+    long Read(uint8_t *data, size_t n, int timeout_ms);
+
+private:
+    int fd_ = -1;
+};
+
+}  // namespace bridge_link
+
+#endif /* TOOLS_BRIDGE_LINK_SERIAL_HPP_ */
@@ -0,0 +1,228 @@
+/*
+ * analysis.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "analysis.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <queue>
+
+namespace can_sched {
+
+namespace {
+
+constexpr uint64_t kMaxEvents = 20000000;   // Bound on simulated releases
+
+// Arbitration order: base ID first, a standard frame wins against an extended
+// frame with the same base ID (SRR is recessive), then the extension bits
+uint32_t PriorityKey(const Message &m) {
+    if (!m.extended) return m.id << 19;
+    return (m.id >> 18) << 19 | 1u << 18 | (m.id & 0x3FFFFu);
+}
+
+std::string Format(const char *fmt, double a, double b = 0, double c = 0) {
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), fmt, a, b, c);
+    return buf;
+}
+
+std::string IdText(const Message &m) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), m.extended ? "0x%08X" : "0x%03X", m.id);
+    return buf;
+}
+
+// Release pattern with synchronous start: frames per scheduler pass and per tick
+void SimulateReleases(const std::vector<uint64_t> &period_ns, const std::vector<uint64_t> &c_ns,
+                      const Options &opt, Report &rep, std::vector<uint64_t> &wait_ns,
+                      std::vector<uint32_t> &same_pass) {
+    const size_t n = period_ns.size();
+
+    // Hyperperiod, capped at the horizon
+    uint64_t horizon = (uint64_t)opt.horizon_ms * 1000000u;
+    uint64_t hyper = 1;
+    for (uint64_t p : period_ns) {
+        hyper = std::lcm(hyper, p);
+        if (hyper >= horizon) break;
+    }
+    horizon = std::min(horizon, hyper);
+
+    // Keep the simulation bounded for very short periods
+    double events = 0;
+    for (uint64_t p : period_ns) events += (double)horizon / p;
+    if (events > kMaxEvents) horizon = (uint64_t)(horizon * (kMaxEvents / events));
+    rep.horizon_ms = horizon / 1e6;
+
+    using Ev = std::pair<uint64_t, uint32_t>;
+    std::priority_queue<Ev, std::vector<Ev>, std::greater<Ev>> q;
+    for (uint32_t i = 0; i < n; i++) q.push({0, i});
+
+    const uint64_t tick = (uint64_t)opt.tick_us * 1000u;
+    uint64_t cur_tick = 0, tick_frames = 0, tick_bus = 0;
+    std::vector<uint32_t> group;
+
+    while (!q.empty() && q.top().first < horizon) {
+        uint64_t t = q.top().first;
+        uint64_t cmax = 0;
+        group.clear();
+        while (!q.empty() && q.top().first == t) {
+            uint32_t i = q.top().second;
+            q.pop();
+            group.push_back(i);
+            cmax = std::max(cmax, c_ns[i]);
+            q.push({t + period_ns[i], i});
+        }
+
+        // Frames beyond the mailbox count make the interrupt wait for the bus
+        uint64_t wait = group.size() > opt.mailboxes ? (group.size() - opt.mailboxes) * cmax : 0;
+        rep.peak_same_pass = std::max<uint32_t>(rep.peak_same_pass, (uint32_t)group.size());
+        rep.isr_wait_us = std::max(rep.isr_wait_us, wait / 1000.0);
+        for (uint32_t i : group) {
+            wait_ns[i] = std::max(wait_ns[i], wait);
+            same_pass[i] = std::max<uint32_t>(same_pass[i], (uint32_t)group.size());
+        }
+
+        // Per-tick demand
+        if (t / tick != cur_tick) {
+            cur_tick = t / tick;
+            tick_frames = 0;
+            tick_bus = 0;
+        }
+        tick_frames += group.size();
+        for (uint32_t i : group) tick_bus += c_ns[i];
+        if (tick_frames > rep.peak_tick_frames) {
+            rep.peak_tick_frames = (uint32_t)tick_frames;
+            rep.peak_tick_bus_us = tick_bus / 1000.0;
+            rep.peak_tick_at_ms = (double)(cur_tick * tick) / 1e6;
+        }
+    }
+}
+
+}  // namespace
+
+uint32_t FrameBits(bool extended, uint8_t len) {
+    // Davis et al., "Controller Area Network (CAN) schedulability analysis: refuted,
+    // revisited and revised" (2007): g control bits exposed to stuffing, 13 bits of
+    // CRC delimiter, ACK, EOF and interframe space that are not
+    uint32_t g = extended ? 54 : 34;
+    uint32_t s = 8u * len;
+    return g + s + 13 + (g + s - 1) / 4;
+}
+
+Report Analyze(const std::vector<Message> &msgs, const Options &opt) {
+    Report rep;
+    const uint64_t tau = (1000000000u + opt.bitrate - 1) / opt.bitrate;   // Bit time in ns, rounded up
+
+    // Highest bus priority first
+    for (const Message &m : msgs) {
+        MessageResult r;
+        r.msg = m;
+        rep.rows.push_back(r);
+    }
+    std::stable_sort(rep.rows.begin(), rep.rows.end(), [](const MessageResult &a, const MessageResult &b) {
+        return PriorityKey(a.msg) < PriorityKey(b.msg);
+    });
+
+    const size_t n = rep.rows.size();
+    std::vector<uint64_t> c(n), t(n), j(n);
+    std::vector<size_t> periodic;
+    for (size_t i = 0; i < n; i++) {
+        MessageResult &r = rep.rows[i];
+        r.frame_bits = FrameBits(r.msg.extended, r.msg.len);
+        c[i] = r.frame_bits * tau;
+        t[i] = (uint64_t)r.msg.period_us * 1000u;
+        r.c_us = c[i] / 1000.0;
+        r.d_us = r.msg.period_us;
+        if (r.msg.event) {
+            r.r_us = -1;
+            rep.warnings.push_back(IdText(r.msg) + ": on-change without a minimum interval, its bus load is not bounded");
+        } else {
+            periodic.push_back(i);
+            rep.utilization += (double)c[i] / t[i];
+        }
+    }
+
+    if (n > opt.capacity) {
+        rep.schedulable = false;
+        rep.warnings.push_back(Format("%.0f messages do not fit into the %.0f table slots", n, opt.capacity));
+    }
+    if (periodic.empty()) return rep;
+
+    // Mailbox demand of the periodic messages
+    std::vector<uint64_t> pt, pc, pw(periodic.size(), 0);
+    std::vector<uint32_t> ps(periodic.size(), 0);
+    for (size_t i : periodic) {
+        pt.push_back(t[i]);
+        pc.push_back(c[i]);
+    }
+    SimulateReleases(pt, pc, opt, rep, pw, ps);
+    for (size_t k = 0; k < periodic.size(); k++) {
+        size_t i = periodic[k];
+        rep.rows[i].same_pass = ps[k];
+        j[i] = (uint64_t)opt.jitter_us * 1000u + pw[k];
+        rep.rows[i].j_us = j[i] / 1000.0;
+    }
+
+    // Response time analysis, sufficient test of Davis et al. 2007:
+    //   w = max(B, C) + sum over higher priority k of ceil((w + J_k + tau) / T_k) * C_k
+    //   R = J + w + C
+    for (size_t i : periodic) {
+        MessageResult &r = rep.rows[i];
+        uint64_t b = 0;
+        for (size_t k = i + 1; k < n; k++) b = std::max(b, c[k]);   // One lower-priority frame in progress
+        uint64_t base = std::max(b, c[i]);
+        uint64_t w = base, prev = 0;
+        uint64_t limit = t[i];
+        while (w != prev && j[i] + w + c[i] <= limit) {
+            prev = w;
+            w = base;
+            for (size_t k : periodic) {
+                if (k >= i) break;
+                w += (prev + j[k] + tau + t[k] - 1) / t[k] * c[k];
+            }
+        }
+        r.r_us = (j[i] + w + c[i]) / 1000.0;
+        r.ok = j[i] + w + c[i] <= limit;
+        if (!r.ok) {
+            rep.schedulable = false;
+            rep.warnings.push_back(IdText(r.msg) + Format(": response time %.1f us exceeds the %.0f us period",
+                                                            r.r_us, r.d_us));
+        }
+    }
+
+    // Findings
+    for (size_t k = 0; k < periodic.size(); k++) {
+        size_t i = periodic[k];
+        bool higher_event = false;
+        for (size_t h = 0; h < i; h++) higher_event |= rep.rows[h].msg.event;
+        if (higher_event) {
+            rep.warnings.push_back(IdText(rep.rows[i].msg) +
+                                   ": higher-priority on-change messages are not included in its response time");
+            break;
+        }
+    }
+    if (rep.utilization > 1.0) {
+        rep.schedulable = false;
+        rep.warnings.push_back(Format("bus load %.1f %% exceeds the bus capacity", rep.utilization * 100));
+    }
+    if (rep.peak_same_pass > opt.mailboxes) {
+        rep.warnings.push_back(Format("up to %.0f frames are due in one scheduler pass; the TIM2 interrupt waits "
+                                      "up to %.1f us for free mailboxes", rep.peak_same_pass, rep.isr_wait_us));
+    }
+    if (rep.peak_tick_bus_us > opt.tick_us) {
+        rep.warnings.push_back(Format("%.0f frames released in the %.0f us window at %.3f ms",
+                                      rep.peak_tick_frames, opt.tick_us, rep.peak_tick_at_ms) +
+                               Format(" need %.1f us of bus time", rep.peak_tick_bus_us));
+    }
+    return rep;
+}
+
+}  // namespace can_sched
@@ -0,0 +1,81 @@
+/*
+ * analysis.hpp
+ * @brief   Bus load, worst-case response times and transmit mailbox demand of a
+ *          cyclic schedule on a CAN bus where the bridge is the only sender.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef TOOLS_CAN_SCHED_ANALYSIS_HPP_
+#define TOOLS_CAN_SCHED_ANALYSIS_HPP_
+
+#include "schedule.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace can_sched {
+
+/**
+ * @brief Analysis parameters.
+ */
+struct Options {
+    uint32_t bitrate = 500000;      ///< CAN bit rate in bit/s
+    uint32_t jitter_us = 10;        ///< Release jitter of the TIM2 scheduler interrupt
+    uint32_t mailboxes = 3;         ///< bxCAN transmit mailboxes
+    uint32_t tick_us = 1000;        ///< Window for the per-tick mailbox demand
+    uint32_t horizon_ms = 1000;     ///< Simulated time for the release pattern (capped at the hyperperiod)
+    uint32_t capacity = 500;        ///< CAN_CYCLIC_CAPACITY of the firmware
+};
+
+/**
+ * @brief Result for one message.
+ */
+struct MessageResult {
+    Message msg;
+    uint32_t frame_bits = 0;        ///< Worst-case frame length incl. stuff bits and interframe space
+    double c_us = 0;                ///< Worst-case transmission time
+    double j_us = 0;                ///< Queuing jitter (scheduler + waiting for a free mailbox)
+    double r_us = 0;                ///< Worst-case response time, < 0 if not analyzed (event message)
+    double d_us = 0;                ///< Deadline (= period)
+    uint32_t same_pass = 0;         ///< Most frames released in the same scheduler pass as this one
+    bool ok = true;                 ///< Response time within the deadline
+};
+
+/**
+ * @brief Result for the whole schedule.
+ */
+struct Report {
+    std::vector<MessageResult> rows;    ///< Sorted by bus priority
+    double utilization = 0;             ///< Bus load of the periodic messages (1.0 = 100 %)
+    uint32_t peak_same_pass = 0;        ///< Most frames due in one scheduler pass
+    double isr_wait_us = 0;             ///< Longest busy-wait for a mailbox inside one pass
+    uint32_t peak_tick_frames = 0;      ///< Most frames released within one tick window
+    double peak_tick_bus_us = 0;        ///< Bus time those frames need
+    double peak_tick_at_ms = 0;         ///< Start of that window
+    double horizon_ms = 0;              ///< Simulated time actually used
+    bool schedulable = true;            ///< No deadline misses and no hard limit exceeded
+    std::vector<std::string> warnings;  ///< Findings in plain text
+};
+
+/**
+ * @brief Worst-case number of bits a data frame occupies on the bus, including
+ *        bit stuffing and the 3-bit interframe space.
+ *
+ * @param extended  29-bit identifier
+ * @param len       Payload length (0–8)
+ */
+uint32_t FrameBits(bool extended, uint8_t len);
+
+/**
+ * @brief Analyze a schedule.
+ *
+ * All messages are assumed to start together (as after a bulk commit), which is
+ * the worst case for mailbox demand.
+ */
+Report Analyze(const std::vector<Message> &msgs, const Options &opt);
+
+}  // namespace can_sched
+
+#endif /* TOOLS_CAN_SCHED_ANALYSIS_HPP_ */
@@ -0,0 +1,125 @@
+/*
+ * can_sched.cpp
+ * @brief   Command line front end: checks whether a cyclic schedule fits on the bus
+ *          before it is loaded into the bridge.
+ *
+ *          can_sched [options] <table.txt | packets.bin>
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "analysis.hpp"
+#include "schedule.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace can_sched;
+
+static void Usage(void) {
+    std::fprintf(stderr,
+        "usage: can_sched [options] <file>\n"
+        "  <file>          text table (<model> <id> <len> <interval>[ms|us] per line)\n"
+        "                  or, with -p or a .bin extension, raw UART command packets\n"
+        "  -b <bit/s>      CAN bit rate (default 500000)\n"
+        "  -j <us>         scheduler interrupt jitter (default 10)\n"
+        "  -m <n>          transmit mailboxes (default 3)\n"
+        "  -t <us>         window for the per-tick mailbox demand (default 1000)\n"
+        "  -H <ms>         simulated time for the release pattern (default 1000)\n"
+        "  -c <n>          table capacity of the firmware (default 500)\n"
+        "  -p              treat the file as UART command packets\n"
+        "  -q              print the summary only\n"
+        "exit status: 0 schedulable, 1 deadline miss or limit exceeded, 2 usage or input error\n");
+}
+
+// Parse a numeric option
+static bool ParseU32(const char *text, uint32_t &out) {
+    char *end;
+    unsigned long v = std::strtoul(text, &end, 0);
+    if (*text == '\0' || *end != '\0' || v > 0xFFFFFFFFul) return false;
+    out = (uint32_t)v;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    bool packets = false, quiet = false;
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        uint32_t *target = nullptr;
+        if (!std::strcmp(a, "-b")) target = &opt.bitrate;
+        else if (!std::strcmp(a, "-j")) target = &opt.jitter_us;
+        else if (!std::strcmp(a, "-m")) target = &opt.mailboxes;
+        else if (!std::strcmp(a, "-t")) target = &opt.tick_us;
+        else if (!std::strcmp(a, "-H")) target = &opt.horizon_ms;
+        else if (!std::strcmp(a, "-c")) target = &opt.capacity;
+        else if (!std::strcmp(a, "-p")) packets = true;
+        else if (!std::strcmp(a, "-q")) quiet = true;
+        else if (a[0] != '-' && !path) path = a;
+        else {
+            Usage();
+            return 2;
+        }
+        if (target && (++i >= argc || !ParseU32(argv[i], *target))) {
+            Usage();
+            return 2;
+        }
+    }
+    // Everything but the jitter must be non-zero
+    if (!path || !opt.bitrate || !opt.mailboxes || !opt.tick_us || !opt.horizon_ms) {
+        Usage();
+        return 2;
+    }
+
+    std::string name(path), error;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) packets = true;
+
+    std::vector<Message> msgs;
+    if (!(packets ? LoadPackets(name, msgs, error) : LoadTable(name, msgs, error))) {
+        std::fprintf(stderr, "can_sched: %s\n", error.c_str());
+        return 2;
+    }
+
+    Report rep = Analyze(msgs, opt);
+
+    if (!quiet) {
+        std::printf("%-10s %-3s %3s %10s %5s %8s %8s %10s %4s  %s\n",
+                    "ID", "Typ", "DLC", "Period us", "Bits", "C us", "J us", "R us", "Pass", "");
+        for (const MessageResult &r : rep.rows) {
+            char id[16];
+            std::snprintf(id, sizeof(id), r.msg.extended ? "0x%08X" : "0x%03X", r.msg.id);
+            if (r.msg.event) {
+                std::printf("%-10s %-3s %3u %10s %5u %8.1f %8s %10s %4s  on-change\n", id,
+                            r.msg.extended ? "ext" : "std", r.msg.len, "-", r.frame_bits, r.c_us, "-", "-", "-");
+                continue;
+            }
+            std::printf("%-10s %-3s %3u %10u %5u %8.1f %8.1f %10.1f %4u  %s\n", id,
+                        r.msg.extended ? "ext" : "std", r.msg.len, r.msg.period_us, r.frame_bits,
+                        r.c_us, r.j_us, r.r_us, r.same_pass, r.ok ? "ok" : "MISS");
+        }
+        std::printf("\n");
+    }
+
+    std::printf("messages:         %zu\n", rep.rows.size());
+    std::printf("bit rate:         %u bit/s\n", opt.bitrate);
+    std::printf("bus load:         %.1f %% (worst-case stuffing)\n", rep.utilization * 100);
+    std::printf("peak per pass:    %u frames (%u mailboxes), interrupt waits up to %.1f us\n",
+                rep.peak_same_pass, opt.mailboxes, rep.isr_wait_us);
+    std::printf("peak per tick:    %u frames, %.1f us of bus time in %u us at %.3f ms\n",
+                rep.peak_tick_frames, rep.peak_tick_bus_us, opt.tick_us, rep.peak_tick_at_ms);
+    std::printf("simulated:        %.3f ms from a synchronous start\n", rep.horizon_ms);
+    for (const std::string &w : rep.warnings) std::printf("warning: %s\n", w.c_str());
+    std::printf("result:           %s\n", rep.schedulable ? "schedulable" : "NOT schedulable");
+
+    return rep.schedulable ? 0 : 1;
+}
+/*
+ * End of file
+ */
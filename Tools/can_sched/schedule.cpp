@@ -0,0 +1,299 @@
+/*
+ * schedule.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "schedule.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+namespace can_sched {
+
+namespace {
+
+constexpr uint32_t kMinIntervalUs = 50;     // CYCLIC_MIN_INTERVAL_US in can_cyclic.c
+
+// Modes as in CyclicMode (can_cyclic.h)
+constexpr uint8_t kModePeriodic = 0;
+constexpr uint8_t kModeOnChange = 2;
+constexpr uint8_t kModeOnChangeMinMax = 3;
+
+// Bulk load flags as in command.c
+constexpr uint8_t kBulkBegin = 0x01;
+constexpr uint8_t kBulkCommit = 0x02;
+constexpr uint8_t kBulkUs = 0x04;
+
+constexpr uint8_t kFrameSof = 0xA5;         // FRAME_SOF in frame.h
+
+// Firmware-side state of one slot
+struct Entry {
+    Message msg;
+    uint32_t interval_us = 0;
+    uint8_t mode = kModePeriodic;
+    uint16_t min_ms = 0;
+};
+
+using Table = std::map<uint32_t, Entry>;
+
+uint32_t Clamp(uint32_t interval_us) {
+    return interval_us < kMinIntervalUs ? kMinIntervalUs : interval_us;
+}
+
+// Same table behaviour as CAN_Cyclic_AddOrUpdateUs: update in place, 0 removes
+void AddOrUpdate(Table &table, bool extended, uint32_t id, uint8_t len, uint32_t interval_us) {
+    if (interval_us == 0) {
+        table.erase(id);
+        return;
+    }
+    Entry &e = table[id];
+    e.msg.id = id;
+    e.msg.extended = extended;
+    e.msg.len = len;
+    e.interval_us = Clamp(interval_us);
+}
+
+// Worst-case transmission pattern of a slot
+std::vector<Message> Flatten(const Table &table) {
+    std::vector<Message> out;
+    for (const auto &kv : table) {
+        Message m = kv.second.msg;
+        m.period_us = kv.second.interval_us;
+        if (kv.second.mode == kModeOnChange) {
+            m.event = true;                              // Rate depends on the PC only
+        } else if (kv.second.mode == kModeOnChangeMinMax) {
+            if (kv.second.min_ms == 0)
+                m.event = true;
+            else if (kv.second.min_ms * 1000u < m.period_us)
+                m.period_us = kv.second.min_ms * 1000u;  // Changes can come as fast as the inhibit time
+        }
+        out.push_back(m);
+    }
+    return out;
+}
+
+// CRC8 SAE-J1850 (poly 0x1D, init 0xFF, final XOR 0xFF) as used by bulk loads
+uint8_t Crc8J1850(const uint8_t *data, size_t len) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x1D) : (uint8_t)(crc << 1);
+    }
+    return crc ^ 0xFF;
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) as used by UART frames
+uint16_t Crc16Ccitt(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+uint32_t Get16(const uint8_t *p) {
+    return (uint32_t)p[0] << 8 | p[1];
+}
+
+uint32_t Get32(const uint8_t *p) {
+    return Get16(p) << 16 | Get16(p + 2);
+}
+
+// Strip the UART framing (frame.h) from a capture; frames that fail a check are dropped
+std::vector<uint8_t> Unframe(const std::vector<uint8_t> &buf) {
+    constexpr size_t kHdr = 5, kCrc = 2;
+    std::vector<uint8_t> out;
+    size_t pos = 0;
+    while (pos + kHdr <= buf.size()) {
+        const uint8_t *f = &buf[pos];
+        size_t len = Get16(f + 2);
+        if (f[0] != kFrameSof || Crc8J1850(f + 1, 3) != f[4] || pos + kHdr + len + kCrc > buf.size() ||
+            Crc16Ccitt(f + 1, kHdr - 1 + len) != Get16(f + kHdr + len)) {
+            pos++;                                       // Hunt for the next start of frame
+            continue;
+        }
+        out.insert(out.end(), f + kHdr, f + kHdr + len);
+        pos += kHdr + len + kCrc;
+    }
+    return out;
+}
+
+// Stage the entries of one bulk packet; false if the packet is rejected
+bool BulkLoad(const uint8_t *p, size_t len, Table &staged) {
+    if (Crc8J1850(p, len - 1) != p[len - 1]) return false;
+
+    size_t ival = (p[1] & kBulkUs) ? 4 : 2;
+    Table add;
+    size_t pos = 4;
+    while (pos < len - 1) {
+        if (pos + 6 > len - 1) return false;
+        const uint8_t *e = p + pos;
+        if (e[0] > 1 || e[5] > 8 || pos + 6 + e[5] + ival > len - 1) return false;
+        const uint8_t *t = e + 6 + e[5];
+        uint32_t interval_us = ival == 4 ? Get32(t) : Get16(t) * 1000u;
+        if (interval_us == 0) return false;
+        Entry &s = add[Get32(e + 1)];
+        s = Entry();
+        s.msg.id = Get32(e + 1);
+        s.msg.extended = e[0] == 1;
+        s.msg.len = e[5];
+        s.interval_us = Clamp(interval_us);
+        pos += 6 + e[5] + ival;
+    }
+    for (const auto &kv : add) staged[kv.first] = kv.second;   // Last entry for an ID wins
+    return true;
+}
+
+}  // namespace
+
+bool LoadTable(const std::string &path, std::vector<Message> &out, std::string &error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    Table table;
+    std::string line;
+    for (int lineno = 1; std::getline(in, line); lineno++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ss(line);
+        std::string model, id, len, interval;
+        if (!(ss >> model)) continue;                    // Blank or comment
+        if (!(ss >> id >> len >> interval)) {
+            error = path + ":" + std::to_string(lineno) + ": expected <model> <id> <len> <interval>";
+            return false;
+        }
+        try {
+            bool ext;
+            if (model == "0" || model == "std") ext = false;
+            else if (model == "1" || model == "ext") ext = true;
+            else throw std::invalid_argument("model");
+
+            uint32_t ident = std::stoul(id, nullptr, 0);
+            unsigned long n = std::stoul(len, nullptr, 0);
+            size_t used;
+            double value = std::stod(interval, &used);
+            std::string unit = interval.substr(used);
+            if (unit == "" || unit == "ms") value *= 1000.0;
+            else if (unit != "us") throw std::invalid_argument("unit");
+
+            if (n > 8 || value < 0 || ident > (ext ? 0x1FFFFFFFu : 0x7FFu)) throw std::out_of_range("range");
+            AddOrUpdate(table, ext, ident, (uint8_t)n, (uint32_t)(value + 0.5));
+        } catch (const std::exception &) {
+            error = path + ":" + std::to_string(lineno) + ": invalid entry '" + line + "'";
+            return false;
+        }
+    }
+    out = Flatten(table);
+    return true;
+}
+
+size_t PacketLength(const uint8_t *p, size_t avail) {
+    auto need = [avail](size_t n) { return avail >= n; };
+    switch (p[0]) {
+    case 0x00: return need(4) && p[3] <= 8 ? 4 + p[3] + 2 : 0;
+    case 0x01: return need(6) && p[5] <= 8 ? 6 + p[5] + 2 : 0;
+    case 0x02: return 8;
+    case 0x03: return 9;
+    case 0x04: return 14;
+    case 0x05: return 10;
+    case 0x06:
+    case 0x0C: return need(4) ? 4 + Get16(p + 2) + 1 : 0;
+    case 0x07:
+    case 0x08:
+    case 0x0F:
+    case 0x10:
+    case 0x11:
+    case 0x13: return 1;
+    case 0x09:
+    case 0x0E: return 5;
+    case 0x15:
+    case 0x16: return 4;
+    case 0x12:
+    case 0x14: return 3;
+    case 0x0A: return 10;
+    case 0x0B: return need(7) && p[1] <= 1 && p[6] <= 8 ? 7 + p[6] + 4 : 0;
+    case 0x0D: {
+        if (!need(2)) return 0;
+        size_t hdr = (p[1] & 0x80) ? 6 : 4;
+        if (p[1] & 0x40) return (p[1] & 0x3F) < 32 ? hdr + 1 + ((p[1] & 0x3F) + 8) / 8 : 0;
+        return ((p[1] >> 3) & 7) + (p[1] & 7) + 1 <= 8 ? hdr + (p[1] & 7) + 1 : 0;
+    }
+    default:   return 0;
+    }
+}
+
+bool LoadPackets(const std::string &path, std::vector<Message> &out, std::string &error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!buf.empty() && buf[0] == kFrameSof) buf = Unframe(buf);   // Capture of the UART stream
+
+    Table active, staged;
+    size_t pos = 0;
+    while (pos < buf.size()) {
+        const uint8_t *p = &buf[pos];
+        size_t len = PacketLength(p, buf.size() - pos);
+        if (len == 0) {
+            pos++;                                       // Receiver drops the byte and resynchronizes
+            continue;
+        }
+        if (pos + len > buf.size()) {
+            error = path + ": truncated packet at offset " + std::to_string(pos);
+            return false;
+        }
+
+        switch (p[0]) {
+        case 0x00:
+            AddOrUpdate(active, false, Get16(p + 1), p[3], Get16(p + len - 2) * 1000u);
+            break;
+        case 0x01:
+            AddOrUpdate(active, true, Get32(p + 1), p[5], Get16(p + len - 2) * 1000u);
+            break;
+        case 0x0B:
+            AddOrUpdate(active, p[1] == 1, Get32(p + 2), p[6], Get32(p + len - 4));
+            break;
+        case 0x05: {
+            auto it = active.find(Get32(p + 1));
+            if (it != active.end() && p[5] <= kModeOnChangeMinMax) {
+                it->second.mode = p[5];
+                it->second.min_ms = (uint16_t)Get16(p + 8);
+            }
+            break;
+        }
+        case 0x06:
+            if (p[1] & kBulkBegin) staged.clear();
+            if (!BulkLoad(p, len, staged)) {
+                staged.clear();                          // Corrupt chunk poisons the transaction
+            } else if (p[1] & kBulkCommit) {
+                active.swap(staged);
+                staged.clear();
+            }
+            break;
+        case 0x0E:
+            active.erase(Get32(p + 1));
+            break;
+        case 0x0F:
+            active.clear();
+            break;
+        default:
+            break;                                       // Not relevant for the bus load
+        }
+        pos += len;
+    }
+    out = Flatten(active);
+    return true;
+}
+
+}  // namespace can_sched
@@ -0,0 +1,72 @@
+/*
+ * schedule.hpp
+ * @brief   Cyclic schedule as the bridge would run it, loaded from a text table
+ *          or from a file of UART command packets (e.g. a bulk upload).
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef TOOLS_CAN_SCHED_SCHEDULE_HPP_
+#define TOOLS_CAN_SCHED_SCHEDULE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace can_sched {
+
+/**
+ * @brief One cyclic message as seen by the bus.
+ */
+struct Message {
+    uint32_t id = 0;            ///< CAN identifier
+    bool extended = false;      ///< 29-bit identifier
+    uint8_t len = 0;            ///< Payload length (0–8)
+    uint32_t period_us = 0;     ///< Minimum time between two transmissions
+    bool event = false;         ///< On-change message without a bounded rate (not analyzed)
+};
+
+/**
+ * @brief Load a text table, one message per line:
+ *
+ *     <model> <id> <len> <interval>[ms|us] [data bytes...]
+ *
+ * model is 0/std or 1/ext, id is decimal or 0x-prefixed hex and the interval
+ * defaults to milliseconds like CAN_Cyclic_AddOrUpdate. '#' starts a comment.
+ * A later line for the same ID replaces the earlier one; interval 0 removes it.
+ *
+ * @param path    File to read
+ * @param out     Resulting schedule
+ * @param error   Message on failure
+ * @return        true on success
+ */
+bool LoadTable(const std::string &path, std::vector<Message> &out, std::string &error);
+
+/**
+ * @brief Replay a binary file of UART command packets (0x00/0x01 frames, 0x0B
+ *        microsecond frames, 0x05 modes, 0x06 bulk loads, 0x0E deletes and 0x0F
+ *        clears) the way the firmware
+ *        executes them. Other packet types are skipped. A file starting with
+ *        0xA5 is taken as a capture of framed UART traffic and unframed first.
+ *
+ * @param path    File to read
+ * @param out     Resulting schedule
+ * @param error   Message on failure
+ * @return        true on success
+ */
+bool LoadPackets(const std::string &path, std::vector<Message> &out, std::string &error);
+
+/**
+ * @brief Length of a UART command packet from its first bytes (mirrors
+ *        Command_Length in the firmware).
+ *
+ * @param p       Packet start
+ * @param avail   Bytes available at p
+ * @return        Packet length, 0 if the type is unknown or more bytes are needed
+ */
+size_t PacketLength(const uint8_t *p, size_t avail);
+
+}  // namespace can_sched
+
+#endif /* TOOLS_CAN_SCHED_SCHEDULE_HPP_ */
@@ -0,0 +1,146 @@
+/*
+ * cobs_bench.c
+ * @brief   Host benchmark of the firmware COBS encoder / decoder (Core/Src/cobs.c)
+ *          against a plain byte-at-a-time implementation. Every buffer is also
+ *          checked for identical encoding and a lossless round trip.
+ *
+ *          gcc -O2 -I../../Core/Inc -o cobs_bench cobs_bench.c ../../Core/Src/cobs.c
+ *          cobs_bench [iterations]
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "cobs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_LEN 303               // Largest frame: Seq + 300-byte packet + CRC16
+
+// Reference encoder: one byte per loop
+static uint16_t Ref_Encode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    uint8_t *code = dst, *out = dst + 1;
+    uint8_t n = 1;
+    for (uint16_t i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            *code = n;
+            code = out++;
+            n = 1;
+        } else {
+            *out++ = src[i];
+            if (++n == 0xFF && i + 1 < len) {
+                *code = n;
+                code = out++;
+                n = 1;
+            }
+        }
+    }
+    *code = n;
+    return (uint16_t)(out - dst);
+}
+
+// Reference decoder: one byte per loop; returns the decoded length or -1
+static int Ref_Decode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    int out = 0;
+    for (uint16_t i = 0; i < len; ) {
+        uint8_t code = src[i++];
+        if (code == 0) return -1;
+        for (uint8_t k = 1; k < code; k++) {
+            if (i >= len) return -1;
+            dst[out++] = src[i++];
+        }
+        if (code != 0xFF && i < len) dst[out++] = 0;
+    }
+    return out;
+}
+
+// Firmware decoder driven the way the UART receiver uses it
+static int Fw_Decode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    CobsDecoder d;
+    int out = 0;
+    COBS_DecodeReset(&d);
+    for (uint16_t used = 0; used < len; ) {
+        const uint8_t *seg;
+        uint16_t seg_len;
+        used += COBS_DecodeNext(&d, src + used, len - used, &seg, &seg_len);
+        memcpy(dst + out, seg, seg_len);
+        out += seg_len;
+    }
+    return COBS_DecodeComplete(&d) ? out : -1;
+}
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Fill a buffer where roughly one byte in every `spacing` is zero (0 = no zeros)
+static void Fill(uint8_t *buf, uint16_t len, unsigned spacing) {
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t b = (uint8_t)(rand() % 255 + 1);
+        if (spacing && rand() % spacing == 0) b = 0;
+        buf[i] = b;
+    }
+}
+
+int main(int argc, char **argv) {
+    long iters = argc > 1 ? atol(argv[1]) : 200000;
+    static const unsigned spacings[] = { 0, 300, 64, 8, 2 };
+    uint8_t src[BENCH_LEN], enc[COBS_MAX_ENCODED(BENCH_LEN)], ref[COBS_MAX_ENCODED(BENCH_LEN) + 1];
+    uint8_t dec[BENCH_LEN];
+    int failed = 0;
+
+    // Correctness over all lengths and zero densities
+    srand(1);
+    for (unsigned s = 0; s < sizeof(spacings) / sizeof(spacings[0]); s++) {
+        for (uint16_t len = 0; len <= BENCH_LEN; len++) {
+            Fill(src, len, spacings[s]);
+            uint16_t n = COBS_Encode(src, len, enc);
+            uint16_t rn = Ref_Encode(src, len, ref);
+            int dn = Fw_Decode(enc, n, dec);
+            if (n != rn || memcmp(enc, ref, n) != 0 || memchr(enc, 0, n) || n > COBS_MAX_ENCODED(len) ||
+                dn != len || memcmp(dec, src, len) != 0) {
+                printf("mismatch: len %u, zero spacing %u\n", len, spacings[s]);
+                failed = 1;
+            }
+        }
+    }
+
+    printf("%-12s %12s %12s %12s %12s\n", "zeros 1 in", "ref enc MB/s", "enc MB/s", "ref dec MB/s", "dec MB/s");
+    for (unsigned s = 0; s < sizeof(spacings) / sizeof(spacings[0]); s++) {
+        Fill(src, BENCH_LEN, spacings[s]);
+        uint16_t n = COBS_Encode(src, BENCH_LEN, enc);
+        volatile int sink = 0;
+        double t[4], mb = (double)iters * BENCH_LEN / 1e6;
+
+        t[0] = Now();
+        for (long i = 0; i < iters; i++) sink += Ref_Encode(src, BENCH_LEN, ref);
+        t[1] = Now();
+        for (long i = 0; i < iters; i++) sink += COBS_Encode(src, BENCH_LEN, enc);
+        t[2] = Now();
+        double ref_enc = mb / (t[1] - t[0]), fw_enc = mb / (t[2] - t[1]);
+
+        t[0] = Now();
+        for (long i = 0; i < iters; i++) sink += Ref_Decode(enc, n, dec);
+        t[1] = Now();
+        for (long i = 0; i < iters; i++) sink += Fw_Decode(enc, n, dec);
+        t[2] = Now();
+        double ref_dec = mb / (t[1] - t[0]), fw_dec = mb / (t[2] - t[1]);
+
+        char label[16];
+        if (spacings[s]) snprintf(label, sizeof(label), "%u", spacings[s]);
+        else snprintf(label, sizeof(label), "none");
+        printf("%-12s %12.1f %12.1f %12.1f %12.1f\n", label, ref_enc, fw_enc, ref_dec, fw_dec);
+        (void)sink;
+    }
+    return failed;
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,336 @@
+/*
+ * flash_model.c
+ * @brief   Runs the firmware flash store (Core/Src/flash_store.c) against a RAM
+ *          model of the STM32F1 flash: 1 KB pages erased to 0xFF, halfwords that
+ *          can only be programmed once after an erase (or cleared to 0x0000).
+ *          The power can be cut after any number of flash operations, leaving
+ *          the operation in progress half done. Checks:
+ *            - wrap-around: a small live set rewritten until every page was
+ *              erased many times, remounting along the way; erases stay even,
+ *            - full store: live data up to FLASH_STORE_CAPACITY survives any
+ *              sequence of rewrites, a write beyond it fails without losing
+ *              anything,
+ *            - power loss: a script of writes and deletes that changes pages
+ *              several times is cut at every flash operation in turn; after the
+ *              remount each key holds its value from before or after the write
+ *              that was cut, and the store keeps working. Every 8th cut
+ *              relocation is cut again at every operation of the remount that
+ *              redoes it.
+ *              One script keeps a page of records that are never rewritten,
+ *              so relocating it needs all of the next page.
+ *
+ *          gcc -O2 -ICore/Inc -o flash_model Tools/flash_model/flash_model.c \
+ *              Core/Src/flash_store.c Core/Src/crc.c
+ *          flash_model [seed]
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "flash_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MODEL_PAGE_SIZE  1024
+#define MODEL_PAGES      4
+#define MODEL_KEYS       160        // Keys the checks use (0x100 + n)
+
+// === Flash model ===
+static uint8_t flash[MODEL_PAGES * MODEL_PAGE_SIZE];
+static long power_ops = -1;         // Flash operations until the power fails, -1 = never
+static unsigned page_erases[MODEL_PAGES];
+static unsigned program_errors;     // Halfwords programmed twice (PGERR on the part)
+
+// Count one flash operation, 0 once the power is gone
+static int Model_Power(void) {
+    if (power_ops < 0) return 1;
+    if (power_ops == 0) return 0;
+    power_ops--;
+    return 1;
+}
+
+static uint8_t Model_Erase(uint8_t page) {
+    if (page >= MODEL_PAGES) return 0;
+    if (!Model_Power()) {
+        memset(flash + page * MODEL_PAGE_SIZE, 0xFF, MODEL_PAGE_SIZE / 2);   // Cut halfway
+        return 0;
+    }
+    memset(flash + page * MODEL_PAGE_SIZE, 0xFF, MODEL_PAGE_SIZE);
+    page_erases[page]++;
+    return 1;
+}
+
+static uint8_t Model_Program(uint32_t offset, const uint16_t *data, uint16_t count) {
+    if (offset % 2 || offset + 2u * count > sizeof(flash)) return 0;
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t *p = flash + offset + 2 * i;
+        uint16_t cur = (uint16_t)(p[0] | p[1] << 8);
+        if (!Model_Power()) return 0;
+        if (cur != 0xFFFF && data[i] != 0) {
+            program_errors++;
+            return 0;
+        }
+        p[0] = (uint8_t)data[i];
+        p[1] = (uint8_t)(data[i] >> 8);
+    }
+    return 1;
+}
+
+static const FlashStoreDev model_dev = {
+    flash, MODEL_PAGE_SIZE, MODEL_PAGES, Model_Erase, Model_Program
+};
+
+// === Expected contents ===
+typedef struct {
+    uint8_t len;                    // 0 = missing or deleted
+    uint8_t data[FLASH_STORE_MAX_VALUE];
+} Value;
+
+static Value ref[MODEL_KEYS];
+static int failed;
+
+static uint16_t Key(int k) {
+    return (uint16_t)(0x100 + k);
+}
+
+static void Fill(Value *v, uint8_t len) {
+    v->len = len;
+    for (uint8_t i = 0; i < len; i++) v->data[i] = (uint8_t)rand();
+}
+
+static uint32_t LiveBytes(void) {
+    uint32_t n = 0;
+    for (int k = 0; k < MODEL_KEYS; k++) {
+        if (ref[k].len) n += FLASH_STORE_RECORD_SIZE(ref[k].len);
+    }
+    return n;
+}
+
+// Compare the store with ref; key alt may also hold *alt_v
+static int Matches(int alt, const Value *alt_v) {
+    for (int k = 0; k < MODEL_KEYS; k++) {
+        uint8_t buf[FLASH_STORE_MAX_VALUE];
+        uint8_t len = FlashStore_Read(Key(k), buf, sizeof(buf));
+        int same = len == ref[k].len && memcmp(buf, ref[k].data, len) == 0;
+        if (!same && k == alt) same = len == alt_v->len && memcmp(buf, alt_v->data, len) == 0;
+        if (!same) return 0;
+    }
+    return 1;
+}
+
+static void Check(int ok, const char *what, long step) {
+    if (ok) return;
+    printf("FAIL: %s (step %ld)\n", what, step);
+    failed = 1;
+}
+
+static void Reset(void) {
+    power_ops = -1;
+    memset(flash, 0xFF, sizeof(flash));
+    memset(page_erases, 0, sizeof(page_erases));
+    memset(ref, 0, sizeof(ref));
+    FlashStore_Init(&model_dev);
+}
+
+// === Wrap-around: small live set, many page changes ===
+static void Test_Wrap(void) {
+    long writes = 200000;
+
+    Reset();
+    for (long i = 0; i < writes && !failed; i++) {
+        int k = rand() % 8;
+        Value v;
+        Fill(&v, (uint8_t)(1 + rand() % FLASH_STORE_MAX_VALUE));
+        Check(FlashStore_Write(Key(k), v.data, v.len), "write", i);
+        ref[k] = v;
+        if (i % 997 == 0) {
+            Check(FlashStore_Init(&model_dev), "remount", i);
+            Check(Matches(-1, 0), "contents after remount", i);
+        }
+    }
+    Check(Matches(-1, 0), "contents", writes);
+
+    unsigned lo = page_erases[0], hi = page_erases[0];
+    for (int p = 1; p < MODEL_PAGES; p++) {
+        if (page_erases[p] < lo) lo = page_erases[p];
+        if (page_erases[p] > hi) hi = page_erases[p];
+    }
+    Check(hi - lo <= 1, "erases spread evenly", writes);
+    printf("wrap-around: %ld writes, %u-%u erases per page\n", writes, lo, hi);
+}
+
+// === Full store: capacity holds under any rewrite order ===
+static void Test_Full(void) {
+    uint32_t cap = FLASH_STORE_CAPACITY(MODEL_PAGE_SIZE, MODEL_PAGES);
+    long rewrites = 100000;
+    int used = 0;
+
+    Reset();
+    // Fill up to the capacity with mixed value sizes
+    for (; used < MODEL_KEYS && !failed; used++) {
+        Value v;
+        Fill(&v, (uint8_t)(1 + rand() % FLASH_STORE_MAX_VALUE));
+        if (LiveBytes() + FLASH_STORE_RECORD_SIZE(v.len) > cap) break;
+        Check(FlashStore_Write(Key(used), v.data, v.len), "fill below capacity", used);
+        ref[used] = v;
+    }
+
+    // Rewrite and delete at random, staying within the capacity
+    for (long i = 0; i < rewrites && !failed; i++) {
+        int k = rand() % used;
+        if (rand() % 8 == 0) {
+            Check(FlashStore_Delete(Key(k)), "delete", i);
+            ref[k].len = 0;
+            continue;
+        }
+        Value v;
+        Fill(&v, (uint8_t)(1 + rand() % FLASH_STORE_MAX_VALUE));
+        uint32_t live = LiveBytes() - (ref[k].len ? FLASH_STORE_RECORD_SIZE(ref[k].len) : 0);
+        if (live + FLASH_STORE_RECORD_SIZE(v.len) > cap) continue;
+        Check(FlashStore_Write(Key(k), v.data, v.len), "rewrite within capacity", i);
+        ref[k] = v;
+    }
+    Check(Matches(-1, 0), "contents at capacity", rewrites);
+
+    // Beyond the capacity: new keys until the store refuses
+    int extra = used;
+    for (; extra < MODEL_KEYS && !failed; extra++) {
+        Value v;
+        Fill(&v, FLASH_STORE_MAX_VALUE);
+        if (!FlashStore_Write(Key(extra), v.data, v.len)) break;
+        ref[extra] = v;
+    }
+    Check(extra < MODEL_KEYS, "store refuses when full", extra);
+    Check(Matches(-1, 0), "contents after a refused write", extra);
+    Check(FlashStore_Init(&model_dev) && Matches(-1, 0), "contents after remount", extra);
+    printf("full store: capacity %u bytes, %d keys, %ld rewrites; refused at %u live bytes\n",
+           (unsigned)cap, used, rewrites, (unsigned)LiveBytes());
+}
+
+// === Power loss at every flash operation of a script ===
+#define SCRIPT_MAX_STEPS 200
+
+typedef struct {
+    const char *name;
+    int keys;                       // Keys written before the script
+    uint8_t start_len;              // Their value length
+    int first_key, script_keys;     // Keys the script writes
+    int steps;
+    uint8_t min_len, max_len;       // Value lengths the script writes
+    int delete_1_in;                // 0 = no deletes
+} Script;
+
+typedef struct {
+    int key;
+    Value v;                        // len 0 = delete
+} Step;
+
+static Step script[SCRIPT_MAX_STEPS];
+
+// Build the starting contents and return the script result, or the step the power failed in
+static int Run_Script(const Script *sc, long ops) {
+    Reset();
+    for (int k = 0; k < sc->keys; k++) {
+        Fill(&ref[k], sc->start_len);
+        FlashStore_Write(Key(k), ref[k].data, ref[k].len);
+    }
+    power_ops = ops;
+    for (int s = 0; s < sc->steps; s++) {
+        const Step *st = &script[s];
+        uint8_t ok = st->v.len ? FlashStore_Write(Key(st->key), st->v.data, st->v.len)
+                               : FlashStore_Delete(Key(st->key));
+        if (!ok) return s;
+        ref[st->key] = st->v;
+    }
+    return sc->steps;
+}
+
+// Reset-time state of the active page: 1 if a relocation was cut
+static int RelocationCut(void) {
+    uint32_t best = 0;
+    int active = -1;
+    for (int p = 0; p < MODEL_PAGES; p++) {
+        const uint8_t *h = flash + p * MODEL_PAGE_SIZE;
+        uint32_t seq = h[4] | h[5] << 8 | (uint32_t)h[6] << 16 | (uint32_t)h[7] << 24;
+        if ((h[0] | h[1] << 8) == 0x5346 && (active < 0 || seq > best)) {
+            best = seq;
+            active = p;
+        }
+    }
+    return active >= 0 && (flash[active * MODEL_PAGE_SIZE + 2] | flash[active * MODEL_PAGE_SIZE + 3] << 8) == 0xFFFF;
+}
+
+static void Test_PowerLoss(const Script *sc, unsigned seed) {
+    long cuts = 0, in_relocation = 0;
+
+    for (int s = 0; s < sc->steps; s++) {
+        script[s].key = sc->first_key + rand() % sc->script_keys;
+        if (sc->delete_1_in && rand() % sc->delete_1_in == 0) script[s].v.len = 0;
+        else Fill(&script[s].v, (uint8_t)(sc->min_len + rand() % (sc->max_len - sc->min_len + 1)));
+    }
+
+    for (long ops = 0; !failed; ops++) {
+        srand(seed + 1);                            // Same starting contents every run
+        int cut = Run_Script(sc, ops);
+        if (cut == sc->steps) break;                // Every operation has been cut once
+        cuts++;
+        if (RelocationCut() && in_relocation++ % 8 == 0) {
+            // The relocation is redone at the remount: cut that too, at every operation
+            // (of every 8th such remount, to keep the run short)
+            static uint8_t saved[sizeof(flash)];
+            memcpy(saved, flash, sizeof(flash));
+            for (long again = 0; !failed; again++) {
+                memcpy(flash, saved, sizeof(flash));
+                power_ops = again;
+                if (FlashStore_Init(&model_dev)) break;
+                power_ops = -1;
+                Check(FlashStore_Init(&model_dev), "remount after a cut remount", ops);
+                Check(Matches(script[cut].key, &script[cut].v), "old or new value after a cut remount", ops);
+            }
+            memcpy(flash, saved, sizeof(flash));
+        }
+
+        power_ops = -1;
+        Check(FlashStore_Init(&model_dev), "remount after power loss", ops);
+        Check(Matches(script[cut].key, &script[cut].v), "old or new value after power loss", ops);
+        Check(program_errors == 0, "halfword programmed twice", ops);
+
+        // The store goes on working: finish the script and remount again
+        if (!Matches(-1, 0)) ref[script[cut].key] = script[cut].v;
+        for (int s = cut + 1; s < sc->steps && !failed; s++) {
+            const Step *st = &script[s];
+            uint8_t ok = st->v.len ? FlashStore_Write(Key(st->key), st->v.data, st->v.len)
+                                   : FlashStore_Delete(Key(st->key));
+            Check(ok, "write after power loss", ops);
+            ref[st->key] = st->v;
+        }
+        Check(FlashStore_Init(&model_dev) && Matches(-1, 0), "contents after the script", ops);
+    }
+    Check(in_relocation > 0, "power cut during a relocation", cuts);
+    printf("power loss, %s: %ld cut points, %ld during a relocation\n", sc->name, cuts, in_relocation);
+}
+
+// Mixed sizes and deletes; a page full of records that are never rewritten, so
+// the relocation of that page needs all of the next one
+static const Script scripts[] = {
+    { "mixed", 24, 30, 0, 24, 120, 8, 47, 6 },
+    { "full page", 42, 20, 42, 2, 160, 20, 20, 0 },
+};
+
+int main(int argc, char **argv) {
+    unsigned seed = argc > 1 ? (unsigned)atoi(argv[1]) : 1;
+
+    srand(seed);
+    Test_Wrap();
+    Test_Full();
+    for (unsigned i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++) Test_PowerLoss(&scripts[i], seed);
+    printf(failed ? "FAILED\n" : "ok\n");
+    return failed;
+}
+/*
+ * End of file
+ */
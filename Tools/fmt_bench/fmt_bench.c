@@ -0,0 +1,101 @@
+/*
+ * fmt_bench.c
+ * @brief   Host benchmark of the firmware CAN text formatter (Core/Src/can_text.c)
+ *          against the sprintf calls it replaced. Every frame is also checked for
+ *          byte-identical output.
+ *
+ *          gcc -O2 -I../../Core/Inc -o fmt_bench fmt_bench.c ../../Core/Src/can_text.c
+ *          fmt_bench [iterations]
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "can_text.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Former main() formatting: header, one sprintf per data byte, line end
+static int Ref_Format(char *buf, uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len) {
+    int n = sprintf(buf, "ID: 0x%03lX [%s], Data: ", (unsigned long)id, is_ext ? "Ext" : "Std");
+    for (int i = 0; i < len; i++) n += sprintf(buf + n, "%02X ", data[i]);
+    n += sprintf(buf + n, "\r\n");
+    return n;
+}
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Compare both formatters for one frame
+static int Check(uint32_t id, uint8_t is_ext, const uint8_t *data, uint8_t len) {
+    char ref[128], out[CAN_TEXT_LINE_MAX + 8];
+    memset(out, 0x55, sizeof(out));
+    int rn = Ref_Format(ref, id, is_ext, data, len);
+    uint8_t n = CAN_Text_Format(out, id, is_ext, data, len);
+    if (n == rn && n <= CAN_TEXT_LINE_MAX && memcmp(out, ref, n) == 0 && out[CAN_TEXT_LINE_MAX] == 0x55) return 0;
+    printf("mismatch: id 0x%lX ext %u len %u\n  ref \"%.*s\"\n  got \"%.*s\"\n",
+           (unsigned long)id, is_ext, len, rn - 2, ref, n > 2 ? n - 2 : 0, out);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    long iters = argc > 1 ? atol(argv[1]) : 2000000;
+    uint8_t data[8];
+    char buf[128];
+    int failed = 0;
+
+    // Every ID width and length, then random frames
+    srand(1);
+    for (int i = 0; i < 8; i++) data[i] = (uint8_t)(i * 0x37 + 0x0A);
+    for (uint8_t len = 0; len <= 8; len++) {
+        for (int bits = 0; bits <= 29; bits++) {
+            uint32_t id = bits ? (1u << (bits - 1)) : 0;
+            failed |= Check(id, bits > 11, data, len);
+            if (bits) failed |= Check((1u << bits) - 1, bits > 11, data, len);
+        }
+    }
+    for (long i = 0; i < 1000000; i++) {
+        uint8_t ext = (uint8_t)(rand() & 1), len = (uint8_t)(rand() % 9);
+        uint32_t id = ext ? ((uint32_t)rand() & 0x1FFFFFFF) : ((uint32_t)rand() & 0x7FF);
+        for (int k = 0; k < 8; k++) data[k] = (uint8_t)rand();
+        failed |= Check(id, ext, data, len);
+    }
+
+    // Throughput on a full 8-byte standard frame and a 29-bit one
+    printf("%-10s %14s %14s %8s\n", "frame", "sprintf ns", "table ns", "speedup");
+    static const struct { const char *name; uint32_t id; uint8_t ext; } cases[] = {
+        { "std 8", 0x123, 0 },
+        { "ext 8", 0x18FEF100, 1 },
+    };
+    for (unsigned c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        volatile int sink = 0;
+        double t[3];
+        t[0] = Now();
+        for (long i = 0; i < iters; i++) {
+            data[0] = (uint8_t)i;
+            sink += Ref_Format(buf, cases[c].id, cases[c].ext, data, 8);
+        }
+        t[1] = Now();
+        for (long i = 0; i < iters; i++) {
+            data[0] = (uint8_t)i;
+            sink += CAN_Text_Format(buf, cases[c].id, cases[c].ext, data, 8);
+        }
+        t[2] = Now();
+        double ref_ns = (t[1] - t[0]) * 1e9 / iters, fw_ns = (t[2] - t[1]) * 1e9 / iters;
+        printf("%-10s %14.1f %14.1f %7.1fx\n", cases[c].name, ref_ns, fw_ns, ref_ns / fw_ns);
+        (void)sink;
+    }
+    printf("%s\n", failed ? "FAILED" : "ok");
+    return failed;
+}
+/*
+ * End of file
+ */
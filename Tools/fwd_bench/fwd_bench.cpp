@@ -0,0 +1,457 @@
+/*
+ * fwd_bench.cpp
+ * @brief   Replays a recorded CAN trace through the firmware forwarding code
+ *          (can_forward.c with can_text.c, can_record.c, can_dict.c) against a
+ *          model of the UART transmit ring, once per output format, and decodes
+ *          the output with the bridge_dump decoder: every frame that got through
+ *          must come back intact and in order. Prints the link bytes per frame,
+ *          the frames per second the link carries when saturated, and the load
+ *          and losses at the recorded rate, where the frames wait in the receive
+ *          queue (can_buffer.c) as on the device and the losses must match the
+ *          loss reports. Built with -DFRAME_COBS=1 (both steps) it measures the
+ *          COBS build.
+ *
+ *          gcc -O2 -c -ITools/slcan_pty/stub -ICore/Inc Core/Src/can_{forward,text,record,dict,buffer}.c
+ *          g++ -std=c++17 -O2 -ITools/bridge_link -ITools/slcan_pty/stub -ICore/Inc -o fwd_bench Tools/fwd_bench/fwd_bench.cpp \
+ *              Tools/bridge_link/link.cpp can_{forward,text,record,dict,buffer}.o
+ *          fwd_bench [-b bit/s] [-T] [-p policy] <candump.log>
+ *          fwd_bench [-b bit/s] [-T] [-p policy] -g <seconds> [-w <candump.log>]
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#include "link.hpp"
+
+extern "C" {
+#include "can_forward.h"
+#include "can_buffer.h"
+#include "frame.h"
+#include "uart.h"
+#include "timebase.h"
+}
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace bridge_link;
+
+struct TraceFrame {
+    uint32_t t_us;                          // Time since the first frame
+    uint32_t id;
+    bool ext;
+    uint8_t dlc;
+    uint8_t data[8];
+};
+
+// =====================================================================
+// Firmware environment: a UART ring of UART_TX_RING_SIZE bytes drained at
+// the bit rate (10 bits per byte)
+
+static uint32_t sim_now;                    // Device time, µs
+static double us_per_byte;
+static double busy_until;                   // When the bytes in the ring are out
+static uint8_t sim_seq;
+static Bytes sim_out;                       // Everything written to the UART
+
+static uint16_t Sim_Queued(void) {
+    double left = busy_until - sim_now;
+    return left <= 0 ? 0 : (uint16_t)std::min<double>(UART_TX_RING_SIZE, left / us_per_byte + 0.999);
+}
+
+extern "C" uint32_t Timebase_Now(void) {
+    return sim_now;
+}
+
+extern "C" uint16_t UART1_TxFree(void) {
+    return (uint16_t)(UART_TX_RING_SIZE - Sim_Queued());
+}
+
+extern "C" void UART1_TxWait(uint16_t n) {
+    while (UART1_TxFree() < n) sim_now += 10;
+}
+
+extern "C" uint16_t UART1_Write(const uint8_t *data, uint16_t n) {
+    if (n > UART1_TxFree()) return 0;
+    sim_out.insert(sim_out.end(), data, data + n);
+    busy_until = std::max<double>(busy_until, sim_now) + n * us_per_byte;
+    return n;
+}
+
+extern "C" uint8_t Frame_Send(const uint8_t *body, uint8_t len) {
+    Bytes f = EncodeFrame(sim_seq, Bytes(body, body + len), FRAME_COBS);
+    sim_seq++;                              // Also when dropped, as frame.c does
+    return UART1_Write(f.data(), (uint16_t)f.size()) != 0;
+}
+
+// =====================================================================
+// Traces
+
+// candump -l lines: "(1436509052.249713) can0 18FEF100#0102030405060708";
+// remote and CAN FD frames are skipped
+static bool LoadTrace(const char *path, std::vector<TraceFrame> &out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    double t0 = -1;
+    while (std::getline(in, line)) {
+        double t;
+        char ifname[32], frame[64];
+        if (std::sscanf(line.c_str(), " (%lf) %31s %63s", &t, ifname, frame) != 3) continue;
+        const char *hash = std::strchr(frame, '#');
+        if (!hash || hash[1] == '#' || hash[1] == 'R') continue;
+        size_t id_digits = (size_t)(hash - frame), n = std::strlen(hash + 1);
+        if ((id_digits != 3 && id_digits != 8) || n % 2 || n > 16) continue;
+
+        TraceFrame f;
+        if (t0 < 0) t0 = t;
+        f.t_us = (uint32_t)((t - t0) * 1e6 + 0.5);
+        f.id = (uint32_t)std::strtoul(std::string(frame, id_digits).c_str(), nullptr, 16);
+        f.ext = id_digits == 8;
+        f.dlc = (uint8_t)(n / 2);
+        for (size_t i = 0; i < f.dlc; i++) f.data[i] = (uint8_t)std::strtoul(std::string(hash + 1 + 2 * i, 2).c_str(), nullptr, 16);
+        out.push_back(f);
+    }
+    return true;
+}
+
+/*
+ * Synthetic engine bus, J1939 style: the usual powertrain PGNs plus 11-bit
+ * messages with a rolling counter and checksum. Each payload byte follows the
+ * pattern letter at its position:
+ *   c constant, s changes now and then, n random every time,
+ *   w / W low / high byte of a 16-bit value that drifts every time,
+ *   k rolling counter, x XOR checksum of the other bytes
+ */
+struct SynthMsg {
+    uint32_t id;
+    bool ext;
+    uint32_t period_ms;
+    const char *bytes;
+};
+
+static const SynthMsg synth_bus[] = {
+    { 0x0CF00400, true,  10,   "csswWcsc" },    // EEC1: torque, engine speed
+    { 0x0CF00300, true,  50,   "cscsccsc" },    // EEC2: accelerator pedal
+    { 0x0CF00203, true,  10,   "cwWccswW" },    // ETC1: shaft speeds
+    { 0x0C000003, true,  10,   "cwWscccc" },    // TSC1: speed / torque request
+    { 0x18F0010B, true,  100,  "ccccccsc" },    // EBC1
+    { 0x18F00503, true,  100,  "sccsccsc" },    // ETC2: gears
+    { 0x18F00010, true,  100,  "cscccccc" },    // ERC1
+    { 0x18FEDF00, true,  250,  "sccsccsc" },    // EEC3
+    { 0x18FEEE00, true,  1000, "sscsccss" },    // ET1: temperatures
+    { 0x18FEEF00, true,  500,  "sccsccsc" },    // EFL/P1: pressures
+    { 0x18FEF100, true,  100,  "cwWcccss" },    // CCVS: vehicle speed
+    { 0x18FEF200, true,  100,  "wWsscccc" },    // LFE: fuel rate
+    { 0x18FEF500, true,  1000, "sccsccsc" },    // AMB
+    { 0x18FEF600, true,  500,  "cssscccc" },    // IC1
+    { 0x18FEF700, true,  1000, "ccccwWcc" },    // VEP1
+    { 0x18FEE900, true,  1000, "ssssssss" },    // LFC: fuel used
+    { 0x18FEE500, true,  1000, "ssssssss" },    // HOURS
+    { 0x100,      false, 10,   "wWsncckx" },
+    { 0x101,      false, 10,   "wWwWcckx" },
+    { 0x110,      false, 10,   "sssscckx" },
+    { 0x120,      false, 20,   "wWnccckx" },
+    { 0x121,      false, 20,   "sscccckx" },
+    { 0x130,      false, 20,   "wWsscckx" },
+    { 0x140,      false, 50,   "ssccccsc" },
+    { 0x150,      false, 100,  "scsccccc" },
+    { 0x160,      false, 100,  "ccsccccc" },
+};
+
+static void GenerateTrace(uint32_t seconds, std::vector<TraceFrame> &out) {
+    std::mt19937 rng(1);
+    struct State {
+        uint32_t next_us;
+        uint8_t data[8];
+        int step;                           // Current drift of the w/W values
+    };
+    std::vector<State> st;
+    for (const SynthMsg &m : synth_bus) {
+        State s;
+        s.next_us = rng() % (m.period_ms * 1000);
+        for (uint8_t &b : s.data) b = (uint8_t)rng();
+        s.step = 0;
+        st.push_back(s);
+    }
+
+    uint32_t end = seconds * 1000000u;
+    for (;;) {
+        size_t k = 0;
+        for (size_t i = 1; i < st.size(); i++) {
+            if (st[i].next_us < st[k].next_us) k = i;
+        }
+        State &s = st[k];
+        const SynthMsg &m = synth_bus[k];
+        if (s.next_us >= end) break;
+
+        if (rng() % 50 == 0) s.step = (int)(rng() % 41) - 20;    // Speed up / slow down
+        uint8_t sum = 0;
+        for (int i = 0; i < 8; i++) {
+            uint8_t &b = s.data[i];
+            switch (m.bytes[i]) {
+            case 's': if (rng() % 40 == 0) b = (uint8_t)(b + (rng() % 2 ? 1 : -1)); break;
+            case 'n': b = (uint8_t)rng(); break;
+            case 'w': {
+                unsigned v = (unsigned)(b | s.data[i + 1] << 8) + (unsigned)(s.step + (int)(rng() % 5) - 2);
+                b = (uint8_t)v;
+                s.data[i + 1] = (uint8_t)(v >> 8);
+                break;
+            }
+            case 'k': b = (uint8_t)((b & 0xF0) | ((b + 1) & 0x0F)); break;
+            default: break;
+            }
+            if (m.bytes[i] != 'x') sum ^= b;
+        }
+        for (int i = 0; i < 8; i++) {
+            if (m.bytes[i] == 'x') s.data[i] = sum;
+        }
+
+        TraceFrame f;
+        f.t_us = s.next_us;
+        f.id = m.id;
+        f.ext = m.ext;
+        f.dlc = 8;
+        std::memcpy(f.data, s.data, 8);
+        out.push_back(f);
+        s.next_us += m.period_ms * 1000 + rng() % 101 - 50;          // ±50 µs jitter
+    }
+}
+
+static bool SaveTrace(const char *path, const std::vector<TraceFrame> &trace) {
+    FILE *f = std::fopen(path, "w");
+    if (!f) return false;
+    for (const TraceFrame &t : trace) {
+        std::fprintf(f, "(%u.%06u) can0 %0*X#", 1700000000u + t.t_us / 1000000, t.t_us % 1000000,
+                     t.ext ? 8 : 3, t.id);
+        for (int i = 0; i < t.dlc; i++) std::fprintf(f, "%02X", t.data[i]);
+        std::fprintf(f, "\n");
+    }
+    return std::fclose(f) == 0;
+}
+
+// =====================================================================
+// Replay and check
+
+struct Result {
+    size_t wire = 0;                        // Link bytes
+    double seconds = 0;                     // Until the last byte is out
+    size_t delivered = 0;                   // Frames decoded
+    LossReport loss;                        // Last loss report
+    bool ok = true;                         // Every decoded frame matched the trace
+};
+
+// Text lines of the SOF build: "ID: 0x123 [Std], Data: 11 22 \r\n"
+static void ParseText(const std::string &text, std::vector<CanRecord> &out) {
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        unsigned id;
+        char type[4];
+        int pos;
+        if (std::sscanf(line.c_str(), "ID: 0x%X [%3[^]]], Data: %n", &id, type, &pos) != 2) continue;
+        CanRecord r;
+        r.id = id;
+        r.ext = type[0] == 'E';
+        unsigned b;
+        int used;
+        for (const char *p = line.c_str() + pos; std::sscanf(p, "%2X%n", &b, &used) == 1; p += used) r.data.push_back((uint8_t)b);
+        r.dlc = (uint8_t)r.data.size();
+        out.push_back(r);
+    }
+}
+
+// Decoded frames must be the trace in order, minus the frames that were lost.
+// With CAN_BUF_LATEST a frame can take the queue place of an older one of its
+// ID: then only the frames of each ID are in order, and a frame sent behind a
+// younger one carries that one's time
+static bool Check(const std::vector<TraceFrame> &trace, const std::vector<uint32_t> &rx_at,
+                  const std::vector<CanRecord> &recs, bool timed, bool per_id) {
+    std::map<uint64_t, size_t> next;        // Per ID (or for all): trace position to search from
+    uint64_t t = 0;
+    for (const CanRecord &r : recs) {
+        if (r.has_time) t = r.time_us;
+        else t += r.delta_us;
+        size_t &i = next[per_id ? (uint64_t)r.ext << 32 | r.id : 0];
+        bool check_time = timed && (r.has_time || r.has_delta);
+        for (;; i++) {                      // Payloads repeat: with timestamps, the time decides
+            if (i == trace.size()) return false;
+            const TraceFrame &f = trace[i];
+            if (f.id == r.id && f.ext == r.ext && f.dlc == r.dlc && std::equal(r.data.begin(), r.data.end(), f.data) &&
+                (!check_time || (per_id ? (uint32_t)t >= rx_at[i] : (uint32_t)t == rx_at[i])))
+                break;
+        }
+        i++;
+    }
+    return true;
+}
+
+// One main loop pass: forward a queued frame if the UART can take it
+static void MainLoop(void) {
+    CanFrame f;
+    if (CAN_Forward_Ready() && CAN_Buffer_Pop(&f)) CAN_Forward(f.id, f.is_ext, f.data, f.len, f.time);
+    CAN_Forward_Poll();
+}
+
+// Forward the whole trace, in main loop passes of 10 µs. saturated: ignore the
+// recorded times and offer the next frame as soon as the forwarder is ready.
+// Otherwise each frame enters the receive queue at its time, as from the
+// interrupt, and the run goes on until the last loss report is out
+static Result Replay(const std::vector<TraceFrame> &trace, uint8_t format, bool timed, bool saturated,
+                     uint8_t policy) {
+    std::vector<uint32_t> rx_at(trace.size());
+    sim_now = 0;
+    busy_until = 0;
+    sim_seq = 0;
+    sim_out.clear();
+    can_fwd_dropped = 0;
+    CAN_Forward_SetFormat(format, (format != CAN_FWD_DEFAULT && timed) ? CAN_FWD_TIMESTAMP : 0);
+    CAN_Buffer_SetPolicy(policy);
+    CAN_Forward_SetReport(saturated ? 0 : CAN_FWD_REPORT_MS);
+
+    for (size_t i = 0; i < trace.size(); i++) {
+        if (saturated) {
+            while (!CAN_Forward_Ready()) {
+                sim_now += 10;
+                CAN_Forward_Poll();
+            }
+            rx_at[i] = sim_now;
+            CAN_Forward(trace[i].id, trace[i].ext, trace[i].data, trace[i].dlc, sim_now);
+            continue;
+        }
+        while (sim_now < trace[i].t_us) {
+            sim_now += 10;
+            MainLoop();
+        }
+        CanFrame f;
+        f.id = trace[i].id;
+        f.is_ext = trace[i].ext;
+        f.len = trace[i].dlc;
+        f.time = rx_at[i] = sim_now;
+        std::memcpy(f.data, trace[i].data, 8);
+        CAN_Buffer_Push(&f);
+    }
+    uint32_t end = sim_now;
+    do {                                    // Until the queue, the last batch and the last report are out
+        sim_now += 10;
+        if (saturated) CAN_Forward_Poll();
+        else MainLoop();
+    } while (UART1_TxFree() < UART_TX_RING_SIZE ||
+             (!saturated && sim_now - end < 2000u * CAN_FWD_REPORT_MS));
+
+    Result res;
+    res.wire = sim_out.size();
+    res.seconds = busy_until / 1e6;
+
+    Deframer rx(FRAME_COBS);
+    RecordDecoder dec;
+    std::vector<Bytes> bodies;
+    std::string text;
+    std::vector<CanRecord> recs;
+    rx.Feed(sim_out.data(), sim_out.size(), bodies, text);
+    ParseText(text, recs);
+    for (const Bytes &b : bodies) {
+        if (b.empty()) dec.Invalidate();   // Dropped frame
+        else if (ParseLossReport(b, res.loss)) continue;
+        else if (!dec.Parse(b, recs)) res.ok = false;
+    }
+    res.delivered = recs.size();
+    if (rx.errors || dec.unknown || can_fwd_dropped ||
+        !Check(trace, rx_at, recs, timed, !saturated && policy == CAN_BUF_LATEST))
+        res.ok = false;
+    if (!saturated && (res.loss.received != trace.size() || res.delivered + res.loss.lost != trace.size()))
+        res.ok = false;                     // Every loss reported
+    return res;
+}
+
+static void Usage(void) {
+    std::fprintf(stderr,
+        "usage: fwd_bench [options] <candump.log>\n"
+        "       fwd_bench [options] -g <seconds> [-w <candump.log>]\n"
+        "  <candump.log>   trace recorded with candump -l\n"
+        "  -g <seconds>    synthetic J1939 engine bus trace instead (~870 frames/s)\n"
+        "  -w <file>       save the synthetic trace in candump -l format\n"
+        "  -b <bit/s>      UART bit rate (default 921600)\n"
+        "  -T              records with timestamps\n"
+        "  -p <policy>     when the receive queue is full: 0 drop the newest frame,\n"
+        "                  1 drop the oldest, 2 keep the latest per ID (default)\n"
+        "exit status: 1 if a decoded frame does not match the trace or a loss was not reported\n");
+}
+
+int main(int argc, char **argv) {
+    unsigned long baud = 921600, gen_seconds = 0, policy = CAN_BUF_LATEST;
+    bool timed = false;
+    const char *path = nullptr, *save = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (!std::strcmp(a, "-b") && i + 1 < argc) baud = std::strtoul(argv[++i], nullptr, 0);
+        else if (!std::strcmp(a, "-g") && i + 1 < argc) gen_seconds = std::strtoul(argv[++i], nullptr, 0);
+        else if (!std::strcmp(a, "-w") && i + 1 < argc) save = argv[++i];
+        else if (!std::strcmp(a, "-p") && i + 1 < argc) policy = std::strtoul(argv[++i], nullptr, 0);
+        else if (!std::strcmp(a, "-T")) timed = true;
+        else if (a[0] != '-' && !path) path = a;
+        else {
+            Usage();
+            return 2;
+        }
+    }
+    if (!baud || !path == !gen_seconds || policy > CAN_BUF_LATEST) {
+        Usage();
+        return 2;
+    }
+    us_per_byte = 10.0 * 1e6 / baud;
+
+    std::vector<TraceFrame> trace;
+    if (path && !LoadTrace(path, trace)) {
+        std::fprintf(stderr, "fwd_bench: cannot read %s\n", path);
+        return 2;
+    }
+    if (gen_seconds) GenerateTrace((uint32_t)gen_seconds, trace);
+    if (save && !SaveTrace(save, trace)) {
+        std::fprintf(stderr, "fwd_bench: cannot write %s\n", save);
+        return 2;
+    }
+    if (trace.empty()) {
+        std::fprintf(stderr, "fwd_bench: no frames\n");
+        return 2;
+    }
+    double span = trace.back().t_us / 1e6;
+    static const char *const policies[] = { "drop newest", "drop oldest", "latest per ID" };
+    std::printf("%zu frames in %.1f s (%.0f frames/s), UART %lu bit/s, %s framing%s, queue of %d: %s\n",
+                trace.size(), span, span > 0 ? trace.size() / span : 0.0, baud, FRAME_COBS ? "COBS" : "SOF",
+                timed ? ", timestamps" : "", CAN_BUFFER_DEPTH, policies[policy]);
+    std::printf("%-22s %11s %14s %8s   %s\n", "format", "bytes/frame", "max frames/s", "vs 0", "at the recorded rate");
+
+    static const char *const names[] = {
+        FRAME_COBS ? "0 full records" : "0 text lines", "1 compact records", "2 batches", "3 dictionary batches"
+    };
+    int status = 0;
+    double base = 0;
+    for (uint8_t format = CAN_FWD_DEFAULT; format <= CAN_FWD_DICT; format++) {
+        Result sat = Replay(trace, format, timed, true, (uint8_t)policy);
+        Result rec = Replay(trace, format, timed, false, (uint8_t)policy);
+        double fps = sat.delivered / sat.seconds;
+        if (format == CAN_FWD_DEFAULT) base = fps;
+        std::printf("%-22s %11.2f %14.0f %7.2fx   link %3.0f%% busy, %zu frames lost (%u reported)%s\n",
+                    names[format],
+                    (double)sat.wire / trace.size(), fps, base > 0 ? fps / base : 0.0,
+                    100.0 * rec.wire * us_per_byte / 1e6 / std::max(span, rec.seconds),
+                    trace.size() - rec.delivered, rec.loss.lost, (sat.ok && rec.ok) ? "" : ", MISMATCH");
+        if (!sat.ok || !rec.ok) status = 1;
+    }
+    return status;
+}
+/*
+ * End of file
+ */
@@ -0,0 +1,386 @@
+/*
+ * slcan_pty.c
+ * @brief   Runs the firmware SLCAN code (Core/Src/slcan.c) on a PC behind a
+ *          pseudo terminal, so slcand / can-utils can be pointed at it without
+ *          hardware. The CAN side is simulated: transmitted frames are counted
+ *          and can be looped back, and received traffic can be generated at a
+ *          fixed rate. With -t it runs a scripted check of the protocol and a
+ *          parser throughput measurement against the pty itself.
+ *
+ *          gcc -O2 -DSLCAN_MODE=1 -ITools/slcan_pty/stub -ICore/Inc -o slcan_pty \
+ *              Tools/slcan_pty/slcan_pty.c Core/Src/slcan.c Core/Src/cmd_queue.c
+ *          slcan_pty [-l] [-r frames/s] [-t]
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+/*
+ * Include files
+ */
+#define _GNU_SOURCE
+#include "slcan.h"
+#include "uart.h"
+#include "can.h"
+#include "timebase.h"
+#include "can_buffer.h"
+#include "can_cyclic.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOOP_DEPTH 64               // Frames waiting to be looped back
+
+typedef struct {
+    uint32_t id;
+    uint8_t ext, len;
+    uint8_t data[8];
+} SimFrame;
+
+static int pty_master = -1;
+static uint8_t tx_buf[8192];        // Device output not yet written to the pty
+static size_t tx_len;
+
+static uint8_t loopback;            // -l: transmitted frames come back as received ones
+static SimFrame loop_q[LOOP_DEPTH];
+static unsigned loop_head, loop_tail;
+
+static unsigned long frames_tx, frames_rx, lines_rx;
+static int sched_locked;            // Inside CAN_Cyclic_Lock / Unlock
+static unsigned long unlocked_calls; // CAN accesses the scheduler could have raced
+static uint8_t sim_silent;          // CAN_SetSilent state
+static uint8_t sim_paused;          // CAN_Cyclic_Pause state
+static volatile sig_atomic_t stop;
+
+// =====================================================================
+// Firmware environment
+
+uint16_t UART1_Write(const uint8_t *data, uint16_t n) {
+    for (uint16_t i = 0; i < n; i++) {
+        if (tx_len == sizeof(tx_buf)) {
+            if (write(pty_master, tx_buf, tx_len) < 0) stop = 1;
+            tx_len = 0;
+        }
+        tx_buf[tx_len++] = data[i];
+    }
+    return n;
+}
+
+void UART1_TxWait(uint16_t n) {
+    (void)n;
+}
+
+uint8_t UART1_SendChar(char c) {
+    return UART1_Write((const uint8_t *)&c, 1) != 0;
+}
+
+void UART1_RxResume(void) {
+}
+
+void CAN_Cyclic_Lock(void) {
+    sched_locked = 1;
+}
+
+void CAN_Cyclic_Unlock(void) {
+    sched_locked = 0;
+}
+
+void CAN_Cyclic_Pause(void) {
+    unlocked_calls += !sched_locked;
+    sim_paused = 1;
+}
+
+void CAN_Cyclic_Resume(void) {
+    unlocked_calls += !sched_locked;
+    sim_paused = 0;
+}
+
+uint8_t CAN_Cyclic_Paused(void) {
+    return sim_paused;
+}
+
+static void Sim_Transmit(uint32_t id, uint8_t ext, const uint8_t *data, uint8_t len) {
+    frames_tx++;
+    unlocked_calls += !sched_locked;
+    if (!loopback || loop_head - loop_tail == LOOP_DEPTH) return;
+    SimFrame *f = &loop_q[loop_head++ % LOOP_DEPTH];
+    f->id = id;
+    f->ext = ext;
+    f->len = len;
+    memcpy(f->data, data, 8);
+}
+
+void CAN_Send_STD(uint16_t std_id, uint8_t *data, uint8_t len) {
+    Sim_Transmit(std_id, 0, data, len);
+}
+
+void CAN_Send_EXT(uint32_t ext_id, uint8_t *data, uint8_t len) {
+    Sim_Transmit(ext_id, 1, data, len);
+}
+
+uint8_t CAN_SetBitrate(uint32_t bitrate) {
+    unlocked_calls += !sched_locked;
+    fprintf(stderr, "bit rate %lu\n", (unsigned long)bitrate);
+    return 1;
+}
+
+void CAN_SetSilent(uint8_t silent) {
+    unlocked_calls += !sched_locked;
+    sim_silent = silent;
+}
+
+uint32_t CAN_Buffer_Lost(void) {
+    return 0;                       // Simulated frames are never lost
+}
+
+uint32_t Timebase_Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+}
+
+// =====================================================================
+// Device loop
+
+static void Flush(void) {
+    if (tx_len && write(pty_master, tx_buf, tx_len) < 0) stop = 1;
+    tx_len = 0;
+}
+
+// Hand bytes to the receiver the way the UART interrupt does, executing
+// queued lines whenever the command queue fills up
+static void Feed(const uint8_t *data, size_t n) {
+    while (n) {
+        uint16_t chunk = n > 256 ? 256 : (uint16_t)n;
+        uint16_t used = SLCAN_Receive(data, chunk);
+        data += used;
+        n -= used;
+        SLCAN_Process();
+    }
+}
+
+// One pass: input from the pty, looped-back frames, generated frames
+static void Pump(int timeout_ms, unsigned long rate, uint32_t start) {
+    uint8_t buf[1024];
+    struct pollfd p = { pty_master, POLLIN, 0 };
+
+    if (poll(&p, 1, timeout_ms) > 0) {
+        ssize_t n = read(pty_master, buf, sizeof(buf));
+        if (n > 0) {
+            for (ssize_t i = 0; i < n; i++) lines_rx += (buf[i] == '\r');
+            Feed(buf, (size_t)n);
+        }
+    }
+    SLCAN_Process();
+
+    while (loop_tail != loop_head) {
+        SimFrame *f = &loop_q[loop_tail++ % LOOP_DEPTH];
+        SLCAN_Forward(f->id, f->ext, f->data, f->len, Timebase_Now());
+        frames_rx++;
+    }
+    if (rate) {
+        unsigned long due = (unsigned long)((uint64_t)(Timebase_Now() - start) * rate / 1000000u);
+        for (unsigned burst = 0; frames_rx < due && burst < 256; burst++) {
+            uint8_t data[8];
+            for (int i = 0; i < 8; i++) data[i] = (uint8_t)(frames_rx >> (8 * (i & 3)));
+            SLCAN_Forward((frames_rx & 1) ? 0x18FF0001u : 0x123u, (uint8_t)(frames_rx & 1), data, 8,
+                          Timebase_Now());
+            frames_rx++;
+        }
+    }
+    Flush();
+}
+
+// =====================================================================
+// Self test
+
+static int test_fd = -1;
+static int failures;
+
+// Write to the pty slave and run the device until the reply is complete
+static void Exchange(const char *send, char *reply, size_t size) {
+    size_t got = 0;
+    if (write(test_fd, send, strlen(send)) < 0) return;
+    for (int idle = 0; idle < 20 && got + 1 < size;) {
+        Pump(1, 0, 0);
+        ssize_t n = read(test_fd, reply + got, size - 1 - got);
+        if (n > 0) {
+            got += (size_t)n;
+            idle = 0;
+        } else {
+            idle++;
+        }
+    }
+    reply[got] = '\0';
+}
+
+static void Expect(const char *send, const char *expect) {
+    char reply[256];
+    Exchange(send, reply, sizeof(reply));
+    if (strcmp(reply, expect) == 0) return;
+    failures++;
+    printf("FAIL: sent \"");
+    for (const char *s = send; *s; s++) printf(*s == '\r' ? "\\r" : "%c", *s);
+    printf("\", got \"");
+    for (const char *s = reply; *s; s++) printf(*s == '\r' ? "\\r" : *s == '\a' ? "\\a" : "%c", *s);
+    printf("\"\n");
+}
+
+// Check that the reply is a forwarded frame with a 4-digit timestamp
+static void ExpectTimestamped(const char *send, const char *frame) {
+    char reply[256];
+    Exchange(send, reply, sizeof(reply));
+    size_t flen = strlen(frame);
+    if (strncmp(reply, "z\r", 2) == 0 && strncmp(reply + 2, frame, flen) == 0 &&
+        strlen(reply) == 2 + flen + 5 && reply[2 + flen + 4] == '\r' && reply[strlen(reply) - 1] == '\r')
+        return;
+    failures++;
+    printf("FAIL: timestamped frame, got \"%s\"\n", reply);
+}
+
+static int SelfTest(const char *slave) {
+    struct termios tio;
+
+    test_fd = open(slave, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (test_fd < 0 || tcgetattr(test_fd, &tio) != 0) {
+        perror(slave);
+        return 2;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(test_fd, TCSANOW, &tio);
+    loopback = 1;
+
+    // Setup sequence of slcand, then the command set
+    Expect("C\r", "\r");
+    Expect("S6\r", "\r");
+    Expect("S9\r", "\a");
+    Expect("t1230\r", "\a");                          // Closed: no transmit
+    Expect("O\r", "\r");
+    Expect("S4\r", "\a");                             // Bit rate only while closed
+    Expect("O\r", "\a");
+    Expect("V\r", "V0101\r");
+    Expect("N\r", "N" SLCAN_SERIAL "\r");
+    Expect("F\r", "F00\r");
+    Expect("M00000000\rmFFFFFFFF\r", "\r\r");
+    Expect("\r", "\r");
+    Expect("t1230\r", "z\rt1230\r");
+    Expect("t7FF81122334455667788\r", "z\rt7FF81122334455667788\r");
+    Expect("t00a2beef\r", "z\rt00A2BEEF\r");
+    Expect("T1FFFFFFF3ABCDEF\r", "Z\rT1FFFFFFF3ABCDEF\r");
+    Expect("t800100\r", "\a");                        // ID out of range
+    Expect("t1239\r", "\a");                          // Length out of range
+    Expect("t123200\r", "\a");                        // Length and data disagree
+    Expect("t12310G\r", "\a");                        // Not hex
+    Expect("T200000000\r", "\a");
+    Expect("X\r", "\a");
+    Expect("t123812345678901234567812345678\r", "\a");  // Too long
+    Expect("t1230\r", "z\rt1230\r");                  // Back in step after the long line
+    Expect("Z1\r", "\r");
+    ExpectTimestamped("t1231AA\r", "t1231AA");
+    Expect("Z0\r", "\r");
+    Expect("C\rL\r", "\r\r");
+    Expect("t1230\r", "\a");                          // Listen-only
+    if (!sim_silent || !sim_paused) {
+        failures++;
+        printf("FAIL: L left silent=%u paused=%u\n", sim_silent, sim_paused);
+    }
+    Expect("C\rO\r", "\r\r");
+    if (sim_silent || sim_paused) {
+        failures++;
+        printf("FAIL: C after L left silent=%u paused=%u\n", sim_silent, sim_paused);
+    }
+    sim_paused = 1;                                   // A schedule paused beforehand stays paused
+    Expect("C\rL\rC\rO\r", "\r\r\r\r");
+    if (sim_silent || !sim_paused) {
+        failures++;
+        printf("FAIL: L/C resumed a paused schedule\n");
+    }
+    sim_paused = 0;
+    if (unlocked_calls) {
+        failures++;
+        printf("FAIL: %lu CAN calls without the scheduler lock\n", unlocked_calls);
+    }
+
+    // Parser throughput: 20000 full-length frames through the pty
+    enum { N = 20000 };
+    const char *line = "t12381122334455667788\r";
+    size_t llen = strlen(line);
+    char out[64 * 22];
+    for (int i = 0; i < 64; i++) memcpy(out + i * llen, line, llen);
+
+    loopback = 0;
+    unsigned long tx0 = frames_tx;
+    uint32_t t0 = Timebase_Now();
+    for (int sent = 0; sent < N; sent += 64) {
+        if (write(test_fd, out, 64 * llen) < 0) break;
+        while (frames_tx - tx0 < (unsigned long)sent + 64) {
+            char drain[4096];
+            Pump(1, 0, 0);
+            while (read(test_fd, drain, sizeof(drain)) > 0);
+        }
+    }
+    double s = (Timebase_Now() - t0) / 1e6;
+    printf("parsed %lu transmit lines in %.3f s (%.0f lines/s)\n", frames_tx - tx0, s, (frames_tx - tx0) / s);
+    if (slcan_errors) printf("errors: %lu lines refused\n", (unsigned long)slcan_errors);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+
+// =====================================================================
+
+static void OnSignal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+int main(int argc, char **argv) {
+    unsigned long rate = 0;
+    int self_test = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-l")) loopback = 1;
+        else if (!strcmp(argv[i], "-t")) self_test = 1;
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) rate = strtoul(argv[++i], 0, 0);
+        else {
+            fprintf(stderr, "usage: slcan_pty [-l] [-r frames/s] [-t]\n"
+                            "  -l   loop transmitted frames back as received frames\n"
+                            "  -r   generate received frames at this rate\n"
+                            "  -t   run the protocol check and throughput test, then exit\n");
+            return 2;
+        }
+    }
+
+    pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty_master < 0 || grantpt(pty_master) != 0 || unlockpt(pty_master) != 0) {
+        perror("pty");
+        return 2;
+    }
+    const char *slave = ptsname(pty_master);
+    if (self_test) return SelfTest(slave);
+
+    printf("%s\n", slave);
+    printf("  slcand -o -s6 -S 921600 %s slcan0 && ip link set slcan0 up\n", slave);
+    fflush(stdout);
+    signal(SIGINT, OnSignal);
+
+    uint32_t start = Timebase_Now(), report = start;
+    while (!stop) {
+        Pump(rate ? 0 : 10, rate, start);
+        if (Timebase_Now() - report >= 1000000u) {
+            report += 1000000u;
+            fprintf(stderr, "lines in %lu, frames sent %lu, frames received %lu, refused %lu\n",
+                    lines_rx, frames_tx, frames_rx, (unsigned long)slcan_errors);
+        }
+    }
+    return 0;
+}
+/*
+ * End of file
+ */
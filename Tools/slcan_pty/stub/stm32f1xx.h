@@ -0,0 +1,24 @@
+/*
+ * stm32f1xx.h
+ * @brief   Host stand-in for the device header: just enough for the firmware
+ *          modules built into slcan_pty (slcan.c, cmd_queue.c) and fwd_bench
+ *          (can_forward.c, can_buffer.c). There are no interrupts on the host,
+ *          so masking one does nothing.
+ *  Created on: Oct 19, 2026
+ *      Author: nguye
+ */
+
+#ifndef TOOLS_SLCAN_PTY_STM32F1XX_H_
+#define TOOLS_SLCAN_PTY_STM32F1XX_H_
+
+#include <stdint.h>
+
+#define __DMB() __sync_synchronize()
+#define __DSB() __sync_synchronize()
+#define __ISB() __sync_synchronize()
+
+#define USB_LP_CAN1_RX0_IRQn 20
+#define NVIC_DisableIRQ(irq) ((void)(irq))
+#define NVIC_EnableIRQ(irq)  ((void)(irq))
+
+#endif /* TOOLS_SLCAN_PTY_STM32F1XX_H_ */